@@ -0,0 +1,59 @@
+// Memory used by the paletted chunks of a generated world against flat arrays
+// of 16 bit block ids, over 2048 chunks of terrain from a fixed seed.
+
+#include "check.hpp"
+#include "terrain.hpp"
+#include "world.hpp"
+#include <cstdio>
+
+int main() {
+  using namespace ktp;
+  const terrain::Generator generator {1234};
+  World world {};
+  // 16x16 columns of 8 chunks, as far as streaming keeps loaded at the start
+  for (GLint x = -8; x < 8; ++x) {
+    for (GLint z = -8; z < 8; ++z) {
+      for (GLint y = 0; y < 8; ++y) {
+        const ChunkPos pos {x, y, z};
+        generator.generate(pos, world.createChunk(pos));
+      }
+    }
+  }
+
+  std::size_t by_width[17] {};
+  std::size_t chunk_bytes {};
+  std::size_t blocks_checked {};
+  for (GLint x = -8; x < 8; ++x) {
+    for (GLint z = -8; z < 8; ++z) {
+      for (GLint y = 0; y < 8; ++y) {
+        const ChunkPos pos {x, y, z};
+        const auto& chunk {*world.chunk(pos)};
+        ++by_width[chunk.bitsPerBlock()];
+        chunk_bytes += chunk.memoryUsage();
+        // the packed blocks are the ones the generator wrote
+        if ((x + y + z) % 7 == 0) {
+          Chunk flat {};
+          generator.generate(pos, flat);
+          for (GLuint i = 0; i < Chunk::volume; ++i) CHECK(chunk.get(i) == flat.get(i));
+          blocks_checked += Chunk::volume;
+        }
+      }
+    }
+  }
+
+  const auto chunks {world.chunkCount()};
+  const auto flat_bytes {chunks * (sizeof(BlockID) * Chunk::volume)};
+  CHECK(chunks == 2048);
+  CHECK(chunk_bytes < flat_bytes);
+  std::printf("%zu chunks, %zu blocks checked\n", chunks, blocks_checked);
+  std::printf("bits per block:");
+  for (GLuint bits: {0u, 1u, 2u, 4u, 8u, 16u}) std::printf(" %u: %zu", bits, by_width[bits]);
+  std::printf("\n");
+  std::printf("paletted %.2f MiB (%.0f B/chunk), whole world %.2f MiB\n",
+    static_cast<double>(chunk_bytes) / (1024.0 * 1024.0), static_cast<double>(chunk_bytes) / static_cast<double>(chunks),
+    static_cast<double>(world.memoryUsage()) / (1024.0 * 1024.0));
+  std::printf("flat     %.2f MiB (%zu B/chunk), %.1fx more\n",
+    static_cast<double>(flat_bytes) / (1024.0 * 1024.0), sizeof(BlockID) * Chunk::volume,
+    static_cast<double>(flat_bytes) / static_cast<double>(chunk_bytes));
+  return test::result();
+}
@@ -0,0 +1,96 @@
+// EBO::generateEBO against the quadratic search it replaced, on grids of
+// unindexed triangles from 1k to 1M vertices. The quadratic one takes minutes
+// on the 1M mesh, it's only timed there with --full, the output of the new
+// one is checked against the mesh either way.
+
+#include "check.hpp"
+#include "opengl.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+using namespace ktp;
+
+// the deduplication before the hash table, looks for every vertex in the
+// unique ones found so far
+void reference(FloatArray& vertices, UintArray& indices) {
+  FloatArray unique_coords {};
+  indices.clear();
+  for (std::size_t i = 0; i < vertices.size(); i += 3) {
+    bool found {false};
+    for (std::size_t j = 0; j < unique_coords.size(); j += 3) {
+      // the grid has no -0.f, the bits are enough
+      if (std::memcmp(&vertices[i], &unique_coords[j], 3 * sizeof(GLfloat)) == 0) {
+        found = true;
+        indices.push_back(static_cast<GLuint>(j / 3u));
+        break;
+      }
+    }
+    if (!found) {
+      unique_coords.insert(unique_coords.end(), {vertices[i], vertices[i + 1], vertices[i + 2]});
+      indices.push_back(static_cast<GLuint>(unique_coords.size() / 3u - 1u));
+    }
+  }
+  vertices = std::move(unique_coords);
+}
+
+// a square grid of quads, 6 vertices each, about as many vertices as asked
+FloatArray grid(std::size_t vertex_count) {
+  std::size_t side {1};
+  while ((side + 1) * (side + 1) * 6 <= vertex_count) ++side;
+  FloatArray vertices {};
+  vertices.reserve(side * side * 6 * 3);
+  const auto push {[&vertices](std::size_t x, std::size_t z) {
+    vertices.insert(vertices.end(), {static_cast<GLfloat>(x), 0.f, static_cast<GLfloat>(z)});
+  }};
+  for (std::size_t z = 0; z < side; ++z) {
+    for (std::size_t x = 0; x < side; ++x) {
+      push(x, z); push(x + 1, z); push(x + 1, z + 1);
+      push(x, z); push(x + 1, z + 1); push(x, z + 1);
+    }
+  }
+  return vertices;
+}
+
+template <typename Function>
+double milliseconds(Function&& function) {
+  const auto start {std::chrono::steady_clock::now()};
+  function();
+  return std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  const bool full {argc > 1 && std::strcmp(argv[1], "--full") == 0};
+  std::printf("%10s %10s %14s %14s\n", "vertices", "unique", "hash ms", "quadratic ms");
+  for (std::size_t count: {1000u, 10000u, 100000u, 1000000u}) {
+    const auto original {grid(count)};
+    auto vertices {original};
+    UintArray indices {};
+    const auto hash_ms {milliseconds([&] { EBO::generateEBO(vertices, indices); })};
+    // every index points to the vertex it replaces, and no vertex is left twice
+    CHECK(indices.size() * 3 == original.size());
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      CHECK(std::memcmp(&original[i * 3], &vertices[indices[i] * 3], 3 * sizeof(GLfloat)) == 0);
+    }
+    const auto side {static_cast<std::size_t>(std::sqrt(static_cast<double>(original.size() / 18)))};
+    CHECK(vertices.size() / 3 == (side + 1) * (side + 1));
+
+    if (count < 1000000u || full) {
+      auto old_vertices {original};
+      UintArray old_indices {};
+      const auto quadratic_ms {milliseconds([&] { reference(old_vertices, old_indices); })};
+      // both keep the vertices in the order they are first seen
+      CHECK(old_vertices == vertices);
+      CHECK(old_indices == indices);
+      std::printf("%10zu %10zu %14.3f %14.3f\n", original.size() / 3, vertices.size() / 3, hash_ms, quadratic_ms);
+    } else {
+      std::printf("%10zu %10zu %14.3f %14s\n", original.size() / 3, vertices.size() / 3, hash_ms, "--full");
+    }
+  }
+  return test::result();
+}
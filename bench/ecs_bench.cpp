@@ -0,0 +1,29 @@
+// Time per tick of 100k mobs, dropped items and particles stored by archetype,
+// on the calling thread and on the job system, against an object with a
+// virtual update per entity, through ecs::benchmark().
+
+#include "check.hpp"
+#include "ecs.hpp"
+#include "jobs.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+int main() {
+  using namespace ktp;
+  const auto threads {std::max(std::thread::hardware_concurrency(), 2u)};
+  jobs::init(threads - 1u);
+  std::printf("%u threads\n", threads);
+  std::printf("%10s %10s %12s %12s %12s %12s\n", "entities", "create ms", "tick ms", "parallel ms", "objects ms", "archetypes");
+  for (const std::size_t entities: {10000u, 100000u}) {
+    const auto timing {ecs::benchmark(entities, 60)};
+    CHECK(timing.entities == entities);
+    // mobs, items and particles
+    CHECK(timing.archetypes == 3);
+    CHECK(timing.create_ms > 0.0 && timing.tick_ms > 0.0 && timing.parallel_tick_ms > 0.0 && timing.objects_tick_ms > 0.0);
+    std::printf("%10zu %10.2f %12.3f %12.3f %12.3f %12zu\n", timing.entities, timing.create_ms,
+      timing.tick_ms, timing.parallel_tick_ms, timing.objects_tick_ms, timing.archetypes);
+  }
+  jobs::shutdown();
+  return test::result();
+}
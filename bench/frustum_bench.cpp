@@ -0,0 +1,27 @@
+// Chunk boxes culled per microsecond by the scalar kernel of Frustum against
+// the SIMD one of the build, through frustum::benchmark(), from 4k to 256k
+// boxes around a camera looking at the horizon.
+
+#include "check.hpp"
+#include "frustum.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+
+int main() {
+  using namespace ktp;
+  const Point3D eye {8.f, 70.f, 8.f};
+  const auto view_projection {glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 1000.f)
+    * glm::lookAt(eye, eye + Point3D{1.f, -0.2f, 0.5f}, Point3D{0.f, 1.f, 0.f})};
+  std::printf("SIMD kernel: %s\n", frustum::kernel());
+  std::printf("%8s %8s %16s %16s %8s\n", "boxes", "visible", "scalar boxes/us", "SIMD boxes/us", "speedup");
+  for (const std::size_t count: {4096u, 32768u, 262144u}) {
+    const auto throughput {frustum::benchmark(view_projection, eye, count)};
+    CHECK(throughput.boxes == count);
+    CHECK(throughput.same);
+    // a view sees part of the boxes around it, not none and not all
+    CHECK(throughput.visible > 0 && throughput.visible < throughput.boxes);
+    std::printf("%8zu %8zu %16.1f %16.1f %7.2fx\n", throughput.boxes, throughput.visible,
+      throughput.scalar_per_us, throughput.simd_per_us, throughput.simd_per_us / throughput.scalar_per_us);
+  }
+  return test::result();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file gl_context.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief An OpenGL context for the benchmarks that need the driver.
+ * @version 0.1
+ * @date 2022-12-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_BENCH_GL_CONTEXT_HPP_)
+#define KETEMINE_BENCH_GL_CONTEXT_HPP_
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+namespace ktp { namespace test {
+
+/**
+ * @brief A hidden window with the same 4.3 core context as the game, current
+ *  on the calling thread. Machines without a display or a driver don't get
+ *  one, the benchmark should return test::skipped then.
+ */
+class GLContext {
+
+ public:
+
+  GLContext() {
+    if (!glfwInit()) {
+      std::cerr << "No GLFW, skipping\n";
+      return;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_window = glfwCreateWindow(64, 64, "keteMine benchmark", nullptr, nullptr);
+    if (!m_window) {
+      std::cerr << "No OpenGL 4.3 context, skipping\n";
+      return;
+    }
+    glfwMakeContextCurrent(m_window);
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+      std::cerr << "GLEW failed to start, skipping\n";
+      glfwDestroyWindow(m_window);
+      m_window = nullptr;
+    }
+  }
+  GLContext(const GLContext& other) = delete;
+  GLContext& operator=(const GLContext& other) = delete;
+  ~GLContext() {
+    if (m_window) glfwDestroyWindow(m_window);
+    glfwTerminate();
+  }
+
+  /**
+   * @return True if the context is current and usable.
+   */
+  bool ok() const { return m_window != nullptr; }
+
+  /**
+   * @return The renderer string of the driver.
+   */
+  auto renderer() const { return reinterpret_cast<const char*>(glGetString(GL_RENDERER)); }
+
+ private:
+
+  GLFWwindow* m_window {nullptr};
+};
+
+} } // namespace test/ktp
+
+#endif // KETEMINE_BENCH_GL_CONTEXT_HPP_
@@ -0,0 +1,115 @@
+// Scaling of the job system from 1 thread to one per core, or as many as
+// given on the command line, on a synthetic arithmetic workload and on
+// greedy meshing of generated terrain. 1 thread is the main thread alone,
+// before jobs::init(), every other count is jobs::init(threads - 1) plus the
+// main thread helping while it waits.
+
+#include "check.hpp"
+#include "jobs.hpp"
+#include "mesher.hpp"
+#include "terrain.hpp"
+#include "world.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+
+template <typename Function>
+double milliseconds(Function&& function) {
+  const auto start {std::chrono::steady_clock::now()};
+  function();
+  return std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count();
+}
+
+// a few thousand dependent multiplies, so the work is all in the cores
+std::uint64_t synthetic(std::uint64_t seed) {
+  std::uint64_t state {seed * 0x9E3779B97F4A7C15ull + 1u};
+  for (int i = 0; i < 4000; ++i) {
+    state ^= state >> 29;
+    state *= 0xBF58476D1CE4E5B9ull;
+  }
+  return state;
+}
+
+constexpr std::size_t synthetic_items {1u << 14};
+
+std::uint64_t syntheticRun() {
+  std::vector<std::uint64_t> results(synthetic_items);
+  jobs::parallelFor(synthetic_items, 64, [&results](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) results[i] = synthetic(i);
+  });
+  std::uint64_t sum {};
+  for (const auto result: results) sum += result;
+  return sum;
+}
+
+std::size_t meshingRun(const World& world, const std::vector<ChunkPos>& positions) {
+  std::atomic<std::size_t> quads {};
+  jobs::parallelFor(positions.size(), 4, [&](std::size_t begin, std::size_t end) {
+    PaddedChunk padded {};
+    ChunkMesh mesh {};
+    std::size_t batch_quads {};
+    for (std::size_t i = begin; i < end; ++i) {
+      mesher::copyNeighbourhood(world, positions[i], padded);
+      mesher::greedy(padded, mesh);
+      batch_quads += mesh.quadCount();
+    }
+    quads += batch_quads;
+  });
+  return quads;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  const unsigned int max_threads {argc > 1
+    ? static_cast<unsigned int>(std::max(std::atoi(argv[1]), 1))
+    : std::max(std::thread::hardware_concurrency(), 2u)};
+
+  const terrain::Generator generator {1234};
+  World world {};
+  std::vector<ChunkPos> positions {};
+  for (GLint x = -6; x < 6; ++x) {
+    for (GLint z = -6; z < 6; ++z) {
+      for (GLint y = 0; y < 6; ++y) {
+        const ChunkPos pos {x, y, z};
+        generator.generate(pos, world.createChunk(pos));
+        if (!world.chunk(pos)->isEmpty()) positions.push_back(pos);
+      }
+    }
+  }
+
+  // the serial results, every thread count must get the same
+  const auto expected_sum {syntheticRun()};
+  const auto expected_quads {meshingRun(world, positions)};
+  double synthetic_base {}, meshing_base {};
+
+  std::printf("%zu synthetic items, %zu chunks meshed, %u cores\n", synthetic_items, positions.size(), std::thread::hardware_concurrency());
+  std::printf("%8s %14s %8s %14s %8s\n", "threads", "synthetic ms", "speedup", "meshing ms", "speedup");
+  for (unsigned int threads = 1; threads <= max_threads; ++threads) {
+    if (threads > 1) jobs::init(threads - 1);
+    CHECK(jobs::threadCount() == threads - 1);
+    std::uint64_t sum {};
+    std::size_t quads {};
+    const auto synthetic_ms {milliseconds([&sum] { sum = syntheticRun(); })};
+    const auto meshing_ms {milliseconds([&] { quads = meshingRun(world, positions); })};
+    jobs::shutdown();
+    CHECK(sum == expected_sum);
+    CHECK(quads == expected_quads);
+    if (threads == 1) {
+      synthetic_base = synthetic_ms;
+      meshing_base = meshing_ms;
+    }
+    std::printf("%8u %14.2f %7.2fx %14.2f %7.2fx\n", threads,
+      synthetic_ms, synthetic_base / synthetic_ms, meshing_ms, meshing_base / meshing_ms);
+  }
+  return test::result();
+}
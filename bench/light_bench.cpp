@@ -0,0 +1,22 @@
+// The worst case of the incremental lighting: a lamp placed and removed at
+// the corner of 8 chunks of air, through light::benchmark(). The lit blocks
+// are checked against the diamond a lamp lights with nothing in the way.
+
+#include "check.hpp"
+#include "light.hpp"
+#include <cstdio>
+
+int main() {
+  using namespace ktp;
+  // the blocks up to 14 steps away from the lamp, where its light fades to 1
+  constexpr std::size_t reach {light::max_level - 1u};
+  constexpr std::size_t diamond {(2 * reach + 1) * (2 * reach * reach + 2 * reach + 3) / 3};
+  std::printf("%10s %12s %12s %8s\n", "iterations", "place ms", "remove ms", "blocks");
+  for (const std::size_t iterations: {1u, 16u, 256u}) {
+    const auto timing {light::benchmark(iterations)};
+    CHECK(timing.blocks == diamond);
+    CHECK(timing.place_ms > 0.0 && timing.remove_ms > 0.0);
+    std::printf("%10zu %12.4f %12.4f %8zu\n", iterations, timing.place_ms, timing.remove_ms, timing.blocks);
+  }
+  return test::result();
+}
@@ -0,0 +1,93 @@
+// Greedy meshing of the terrain of a few fixed seeds, quads and microseconds
+// per chunk with and without shading. The flat meshes are checked against
+// the faces a per block mesher would emit: the merged quads must cover them
+// all and nothing else.
+
+#include "check.hpp"
+#include "mesher.hpp"
+#include "terrain.hpp"
+#include "world.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+using namespace ktp;
+
+// the visible faces of a chunk, one quad each without merging
+std::size_t exposedFaces(const PaddedChunk& padded) {
+  constexpr GLint offsets[6][3] {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+  std::size_t faces {};
+  for (GLint y = 0; y < Chunk::size; ++y) {
+    for (GLint z = 0; z < Chunk::size; ++z) {
+      for (GLint x = 0; x < Chunk::size; ++x) {
+        if (padded.get(x, y, z) == Blocks::air) continue;
+        for (const auto& offset: offsets) {
+          if (padded.get(x + offset[0], y + offset[1], z + offset[2]) == Blocks::air) ++faces;
+        }
+      }
+    }
+  }
+  return faces;
+}
+
+// the faces of blocks covered by the quads of a mesh
+std::size_t coveredFaces(const ChunkMesh& mesh) {
+  std::size_t faces {};
+  for (std::size_t i = 0; i < mesh.vertices.size(); i += 4) {
+    GLuint min[3] {31u, 31u, 31u}, max[3] {};
+    for (std::size_t v = i; v < i + 4; ++v) {
+      const GLuint coords[3] {mesh.vertices[v].x(), mesh.vertices[v].y(), mesh.vertices[v].z()};
+      for (int axis = 0; axis < 3; ++axis) {
+        min[axis] = std::min(min[axis], coords[axis]);
+        max[axis] = std::max(max[axis], coords[axis]);
+      }
+    }
+    const auto axis {mesh.vertices[i].face() / 2u};
+    const auto u {(axis + 1u) % 3u}, v {(axis + 2u) % 3u};
+    faces += (max[u] - min[u]) * (max[v] - min[v]);
+  }
+  return faces;
+}
+
+} // namespace
+
+int main() {
+  std::printf("%6s %7s %12s %12s %10s %10s\n", "seed", "chunks", "flat quads", "shaded quads", "flat us", "shaded us");
+  for (const GLint seed: {1234, 42, 7}) {
+    const terrain::Generator generator {seed};
+    World world {};
+    // 8x8 columns from the caves up to above the hills
+    for (GLint x = -4; x < 4; ++x) {
+      for (GLint z = -4; z < 4; ++z) {
+        for (GLint y = 0; y < 8; ++y) {
+          const ChunkPos pos {x, y, z};
+          generator.generate(pos, world.createChunk(pos));
+        }
+      }
+    }
+
+    std::size_t meshed {};
+    PaddedChunk padded {};
+    ChunkMesh mesh {};
+    for (const auto& [pos, chunk]: world.chunks()) {
+      if (chunk.isEmpty()) continue;
+      ++meshed;
+      mesher::copyNeighbourhood(world, pos, padded);
+      mesher::greedy(padded, mesh, false);
+      const auto faces {exposedFaces(padded)};
+      CHECK(coveredFaces(mesh) == faces);
+      CHECK(mesh.quadCount() <= faces);
+    }
+    CHECK(meshed > 0);
+
+    const auto timing {mesher::benchmark(world, meshed)};
+    const auto chunks {static_cast<double>(meshed)};
+    // shading only splits quads, it never hides a face
+    CHECK(timing.shaded_quads >= timing.flat_quads);
+    std::printf("%6d %7zu %12.1f %12.1f %10.1f %10.1f\n", seed, meshed,
+      static_cast<double>(timing.flat_quads) / chunks, static_cast<double>(timing.shaded_quads) / chunks,
+      timing.flat_ms * 1000.0, timing.shaded_ms * 1000.0);
+  }
+  return test::result();
+}
@@ -0,0 +1,41 @@
+// Samples per second of every noise kernel in the build filling chunk
+// sections, through noise::benchmark(), for both types of noise with and
+// without domain warping. The sections of every kernel are checked against
+// the scalar ones.
+
+#include "check.hpp"
+#include "noise.hpp"
+#include <cstdio>
+#include <cstring>
+
+int main() {
+  using namespace ktp;
+  constexpr noise::Isa isas[] {noise::Isa::Scalar, noise::Isa::SSE2, noise::Isa::AVX2};
+  std::printf("%-8s %-5s", "noise", "warp");
+  for (const auto isa: isas) std::printf(" %16s", noise::name(isa));
+  std::printf("\n");
+  for (const auto type: {noise::Type::Perlin, noise::Type::Simplex}) {
+    for (const auto warp: {0.f, 24.f}) {
+      noise::Fractal fractal {};
+      fractal.type = type;
+      fractal.warp_amplitude = warp;
+      noise::Section scalar {};
+      noise::fillSection(fractal, {-16, 48, 32}, scalar, noise::Isa::Scalar);
+      std::printf("%-8s %-5s", type == noise::Type::Perlin ? "perlin" : "simplex", warp > 0.f ? "on" : "off");
+      for (const auto isa: isas) {
+        if (!noise::supported(isa)) {
+          std::printf(" %16s", "not built");
+          continue;
+        }
+        const auto samples_per_second {noise::benchmark(fractal, isa)};
+        CHECK(samples_per_second > 0.0);
+        noise::Section section {};
+        noise::fillSection(fractal, {-16, 48, 32}, section, isa);
+        CHECK(std::memcmp(section.data(), scalar.data(), sizeof(section)) == 0);
+        std::printf(" %12.2f M/s", samples_per_second / 1000000.0);
+      }
+      std::printf("\n");
+    }
+  }
+  return test::result();
+}
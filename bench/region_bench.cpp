@@ -0,0 +1,39 @@
+// Chunks per second saved to region files on the I/O thread and loaded back,
+// through region::benchmark(), for 512 to 4096 chunks of terrain from a fixed
+// seed, up to as many as the GUI button saves.
+
+#include "check.hpp"
+#include "region.hpp"
+#include "terrain.hpp"
+#include "world.hpp"
+#include <cstdio>
+#include <filesystem>
+
+int main() {
+  using namespace ktp;
+  const terrain::Generator generator {1234};
+  World world {};
+  // 16x16 columns of 16 chunks
+  for (GLint x = -8; x < 8; ++x) {
+    for (GLint z = -8; z < 8; ++z) {
+      for (GLint y = 0; y < 16; ++y) {
+        const ChunkPos pos {x, y, z};
+        generator.generate(pos, world.createChunk(pos));
+      }
+    }
+  }
+  const auto directory {std::filesystem::temp_directory_path() / "ketemine_region_bench"};
+  std::printf("%8s %14s %14s %12s\n", "chunks", "saved/s", "loaded/s", "bytes/chunk");
+  for (const std::size_t count: {512u, 2048u, 4096u}) {
+    const auto throughput {region::benchmark(directory, world, count)};
+    CHECK(throughput.saved_per_second > 0.0);
+    CHECK(throughput.loaded_per_second > 0.0);
+    // every chunk takes at least its header, and less than a flat array
+    CHECK(throughput.bytes_per_chunk > 0.0);
+    CHECK(throughput.bytes_per_chunk < static_cast<double>(sizeof(BlockID) * Chunk::volume));
+    // and the region files are gone
+    CHECK(!std::filesystem::exists(directory));
+    std::printf("%8zu %14.0f %14.0f %12.0f\n", count, throughput.saved_per_second, throughput.loaded_per_second, throughput.bytes_per_chunk);
+  }
+  return test::result();
+}
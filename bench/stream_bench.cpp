@@ -0,0 +1,117 @@
+// Upload throughput of chunk meshes into a vertex buffer, through
+// VBO::setupSubData() against a persistently mapped StreamBuffer copied on
+// the GPU, the way streaming uploads them. Every frame the GPU also reads
+// the whole buffer, as drawing would, so glBufferSubData() can't ignore it.
+// Needs an OpenGL 4.4 context, it's skipped without one.
+
+#include "check.hpp"
+#include "gl_context.hpp"
+#include "opengl.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+
+// as big as the staging regions of the streaming
+constexpr GLsizeiptr frame_bytes {4 * 1024 * 1024};
+constexpr int frames {60};
+
+struct Upload {
+  double mb_per_s {};
+  std::size_t stalls {};
+};
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>{std::chrono::steady_clock::now() - start}.count();
+}
+
+// the GPU reads what was uploaded, the stand-in for the draws of a frame
+void readOnGPU(const VBO& destination, GLuint sink) {
+  glBindBuffer(GL_COPY_READ_BUFFER, destination.id());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, sink);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, frame_bytes);
+}
+
+Upload subData(const std::vector<std::byte>& payload, GLsizeiptr mesh_bytes, VBO& destination, GLuint sink) {
+  const auto start {std::chrono::steady_clock::now()};
+  for (int frame = 0; frame < frames; ++frame) {
+    for (GLsizeiptr offset = 0; offset + mesh_bytes <= frame_bytes; offset += mesh_bytes) {
+      destination.setupSubData(payload.data() + offset, mesh_bytes, offset);
+    }
+    readOnGPU(destination, sink);
+  }
+  glFinish();
+  return {static_cast<double>(frame_bytes) * frames / (1024.0 * 1024.0) / seconds(start), 0};
+}
+
+Upload streamed(const std::vector<std::byte>& payload, GLsizeiptr mesh_bytes, VBO& destination, GLuint sink) {
+  StreamBuffer staging {frame_bytes};
+  const auto start {std::chrono::steady_clock::now()};
+  for (int frame = 0; frame < frames; ++frame) {
+    destination.bind();
+    glBindBuffer(GL_COPY_READ_BUFFER, staging.id());
+    for (GLsizeiptr offset = 0; offset + mesh_bytes <= frame_bytes; offset += mesh_bytes) {
+      const auto staged {staging.allocate(mesh_bytes)};
+      std::memcpy(staging.data(staged), payload.data() + offset, static_cast<std::size_t>(mesh_bytes));
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, staged, offset, mesh_bytes);
+    }
+    readOnGPU(destination, sink);
+    staging.fence();
+  }
+  glFinish();
+  return {static_cast<double>(frame_bytes) * frames / (1024.0 * 1024.0) / seconds(start), staging.stalls()};
+}
+
+// the destination holds the payload after the uploads
+bool uploaded(const std::vector<std::byte>& payload, const VBO& destination) {
+  std::vector<std::byte> read_back(payload.size());
+  glBindBuffer(GL_COPY_READ_BUFFER, destination.id());
+  glGetBufferSubData(GL_COPY_READ_BUFFER, 0, frame_bytes, read_back.data());
+  return read_back == payload;
+}
+
+} // namespace
+
+int main() {
+  const test::GLContext context {};
+  if (!context.ok()) return test::skipped;
+  std::printf("%s\n", context.renderer());
+  if (!StreamBuffer{frame_bytes}.valid()) {
+    std::printf("No ARB_buffer_storage, skipping\n");
+    return test::skipped;
+  }
+
+  std::vector<std::byte> payload(static_cast<std::size_t>(frame_bytes));
+  std::mt19937 rng {1234};
+  for (auto& byte: payload) byte = static_cast<std::byte>(rng());
+
+  GLuint sink {};
+  glGenBuffers(1, &sink);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, sink);
+  glBufferData(GL_COPY_WRITE_BUFFER, frame_bytes, nullptr, GL_STREAM_COPY);
+
+  std::printf("%d frames of %lld MiB\n", frames, static_cast<long long>(frame_bytes / (1024 * 1024)));
+  std::printf("%10s %16s %16s %8s\n", "mesh KiB", "subdata MB/s", "stream MB/s", "stalls");
+  // from a small chunk mesh to a region's worth at once
+  for (const GLsizeiptr mesh_bytes: {16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024}) {
+    VBO destination {};
+    destination.setup(static_cast<const std::byte*>(nullptr), frame_bytes, GL_DYNAMIC_DRAW);
+    const auto sub_data {subData(payload, mesh_bytes, destination, sink)};
+    CHECK(uploaded(payload, destination));
+
+    VBO streamed_destination {};
+    streamed_destination.setup(static_cast<const std::byte*>(nullptr), frame_bytes, GL_DYNAMIC_DRAW);
+    const auto stream {streamed(payload, mesh_bytes, streamed_destination, sink)};
+    CHECK(uploaded(payload, streamed_destination));
+
+    std::printf("%10lld %16.1f %16.1f %8zu\n", static_cast<long long>(mesh_bytes / 1024), sub_data.mb_per_s, stream.mb_per_s, stream.stalls);
+  }
+  glDeleteBuffers(1, &sink);
+  CHECK(glGetError() == GL_NO_ERROR);
+  return test::result();
+}
@@ -0,0 +1,168 @@
+// CPU time of submitting every chunk of the view, one draw call per chunk
+// against the single glMultiDrawElementsIndirect() of the renderer, from 256
+// to 16384 chunks. The draws are built and submitted as drawChunks() does
+// without culling, and everything lands behind the camera so the GPU time
+// doesn't get in the way. A primitives query checks both draw the same.
+// Needs an OpenGL 4.3 context, it's skipped without one.
+
+#include "check.hpp"
+#include "gl_context.hpp"
+#include "mesher.hpp"
+#include "opengl.hpp"
+#include "renderer.hpp"
+#include "resources.hpp"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+using renderer::DrawElementsIndirectCommand;
+
+// the attributes of voxel.vert, but every vertex is clipped
+constexpr auto vertex_source {R"(#version 430 core
+layout (location = 0) in uvec2 vertex_data;
+layout (location = 1) in vec3 origin;
+void main() { gl_Position = vec4(origin + vec3(vertex_data.x & 31u), -1.0); }
+)"};
+
+constexpr auto fragment_source {R"(#version 430 core
+out vec4 color;
+void main() { color = vec4(1.0); }
+)"};
+
+constexpr std::size_t max_chunks {16384};
+constexpr GLuint quads_per_chunk {16};
+constexpr GLuint vertices_per_chunk {quads_per_chunk * 4};
+constexpr int frames {20};
+
+GLuint linkProgram() {
+  const auto vertex {glCreateShader(GL_VERTEX_SHADER)};
+  const auto fragment {glCreateShader(GL_FRAGMENT_SHADER)};
+  const bool compiled {Resources::compileShader(vertex, vertex_source) && Resources::compileShader(fragment, fragment_source)};
+  const auto program {glCreateProgram()};
+  glAttachShader(program, vertex);
+  glAttachShader(program, fragment);
+  glLinkProgram(program);
+  glDeleteShader(vertex);
+  glDeleteShader(fragment);
+  GLint linked {};
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (compiled && linked) return program;
+  glDeleteProgram(program);
+  return 0;
+}
+
+// the chunks packed one after another, like in the vertex arena
+std::vector<renderer::CullCandidate> candidatesOf(std::size_t count) {
+  std::vector<renderer::CullCandidate> candidates {};
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto index {static_cast<GLuint>(i)};
+    candidates.push_back({glm::vec4{}, glm::vec4{}, glm::uvec4{quads_per_chunk * 6u, index * vertices_per_chunk, index, 0u}});
+  }
+  return candidates;
+}
+
+struct Frame {
+  double cpu_ms {};
+  GLuint primitives {};
+};
+
+template <typename Submit>
+Frame measure(Submit&& submit) {
+  GLuint query {};
+  glGenQueries(1, &query);
+  Frame frame {};
+  for (int i = 0; i < frames; ++i) {
+    glBeginQuery(GL_PRIMITIVES_GENERATED, query);
+    const auto start {std::chrono::steady_clock::now()};
+    submit();
+    frame.cpu_ms += std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count();
+    glEndQuery(GL_PRIMITIVES_GENERATED);
+    // not timed, the next frame starts with an idle GPU
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT, &frame.primitives);
+  }
+  glDeleteQueries(1, &query);
+  frame.cpu_ms /= frames;
+  return frame;
+}
+
+} // namespace
+
+int main() {
+  const test::GLContext context {};
+  if (!context.ok()) return test::skipped;
+  std::printf("%s\n", context.renderer());
+
+  const auto program {linkProgram()};
+  CHECK(program != 0);
+  if (!program) return test::result();
+  // somewhere to draw, the context may have no default framebuffer
+  GLuint framebuffer {}, renderbuffer {};
+  glGenFramebuffers(1, &framebuffer);
+  glGenRenderbuffers(1, &renderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 64, 64);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+
+  VAO vao {};
+  vao.bind();
+  UshortArray indices {};
+  mesher::quadIndices(quads_per_chunk, indices);
+  EBO ebo {};
+  ebo.setup(indices);
+  VBO vertices {};
+  vertices.setup(std::vector<ChunkVertex>(max_chunks * vertices_per_chunk));
+  vao.linkAttribI(vertices, 0, 2, GL_UNSIGNED_INT, sizeof(ChunkVertex), nullptr);
+  VBO origins_vbo {};
+  vao.linkAttrib(origins_vbo, 1, 3, GL_FLOAT, sizeof(Point3D), nullptr);
+  vao.setDivisor(1, 1);
+  SSBO indirect_buffer {};
+  glUseProgram(program);
+
+  std::vector<DrawElementsIndirectCommand> commands {};
+  std::vector<Point3D> origins {};
+  std::printf("%8s %16s %16s %10s\n", "chunks", "per chunk ms", "multi draw ms", "speedup");
+  for (std::size_t count = 256; count <= max_chunks; count *= 4) {
+    const auto candidates {candidatesOf(count)};
+    const auto build {[&] {
+      commands.clear();
+      origins.clear();
+      for (const auto& candidate: candidates) {
+        commands.push_back({candidate.draw.x, 1u, 0u, static_cast<GLint>(candidate.draw.y), candidate.draw.z});
+        origins.push_back(Point3D{static_cast<GLfloat>(candidate.draw.z), 0.f, 0.f});
+      }
+      origins_vbo.setup(origins, GL_STREAM_DRAW);
+    }};
+
+    const auto per_chunk {measure([&] {
+      build();
+      for (const auto& command: commands) {
+        glDrawElementsInstancedBaseVertexBaseInstance(
+          GL_TRIANGLES, static_cast<GLsizei>(command.count), GL_UNSIGNED_SHORT, nullptr,
+          1, command.base_vertex, command.base_instance
+        );
+      }
+    })};
+    const auto multi_draw {measure([&] {
+      build();
+      indirect_buffer.setup(commands, GL_STREAM_DRAW);
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer.id());
+      glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    })};
+
+    CHECK(per_chunk.primitives == count * quads_per_chunk * 2u);
+    CHECK(multi_draw.primitives == per_chunk.primitives);
+    std::printf("%8zu %16.3f %16.3f %9.1fx\n", count, per_chunk.cpu_ms, multi_draw.cpu_ms, per_chunk.cpu_ms / multi_draw.cpu_ms);
+  }
+  vao.unbind();
+  CHECK(glGetError() == GL_NO_ERROR);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &framebuffer);
+  glDeleteRenderbuffers(1, &renderbuffer);
+  glDeleteProgram(program);
+  return test::result();
+}
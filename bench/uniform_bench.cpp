@@ -0,0 +1,129 @@
+// Cost of 10k uniform sets of a linked program: asking the driver for the
+// location by name every time, as before the cache, looking the name up in
+// the cache reflected at link time, and using handles resolved once.
+// Needs an OpenGL 4.3 context, it's skipped without one.
+
+#include "check.hpp"
+#include "gl_context.hpp"
+#include "opengl.hpp"
+#include "resources.hpp"
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+using namespace ktp;
+
+constexpr auto vertex_source {R"(#version 430 core
+layout (location = 0) in vec3 position;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 offset;
+void main() { gl_Position = projection * view * model * vec4(position + offset, 1.0); }
+)"};
+
+constexpr auto fragment_source {R"(#version 430 core
+out vec4 color;
+uniform vec4 tint;
+uniform float time;
+void main() { color = tint * (0.5 + 0.5 * sin(time)); }
+)"};
+
+GLuint linkProgram() {
+  const auto vertex {glCreateShader(GL_VERTEX_SHADER)};
+  const auto fragment {glCreateShader(GL_FRAGMENT_SHADER)};
+  const bool compiled {Resources::compileShader(vertex, vertex_source) && Resources::compileShader(fragment, fragment_source)};
+  const auto program {glCreateProgram()};
+  glAttachShader(program, vertex);
+  glAttachShader(program, fragment);
+  glLinkProgram(program);
+  glDeleteShader(vertex);
+  glDeleteShader(fragment);
+  GLint linked {};
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (compiled && linked) return program;
+  glDeleteProgram(program);
+  return 0;
+}
+
+constexpr int sets {10000};
+
+template <typename Function>
+double microseconds(Function&& function) {
+  const auto start {std::chrono::steady_clock::now()};
+  function();
+  glFinish();
+  return std::chrono::duration<double, std::micro>{std::chrono::steady_clock::now() - start}.count();
+}
+
+} // namespace
+
+int main() {
+  const test::GLContext context {};
+  if (!context.ok()) return test::skipped;
+  std::printf("%s\n", context.renderer());
+
+  const auto id {linkProgram()};
+  CHECK(id != 0);
+  if (!id) return test::result();
+  const auto uniforms {ShaderProgram::reflectUniforms(id)};
+  CHECK(!uniforms.empty());
+  const ShaderProgram by_driver {id};
+  const ShaderProgram by_cache {id, &uniforms};
+  glUseProgram(id);
+
+  // the cache and the driver agree, and so does the fallback without a cache
+  for (const auto name: {"model", "view", "projection", "offset", "tint", "time"}) {
+    CHECK(by_cache.getUniformLocation(name) >= 0);
+    CHECK(by_cache.getUniformLocation(name) == by_driver.getUniformLocation(name));
+  }
+  CHECK(by_cache.uniform("model").location == by_driver.uniform("model").location);
+  CHECK(by_driver.uniform("time").valid());
+  CHECK(!by_cache.uniform("not_a_uniform").valid());
+
+  const GLfloat matrix[16] {1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+  const GLfloat vector[4] {1.f, 0.5f, 0.25f, 1.f};
+
+  // a frame's worth of sets, 6 per draw
+  const auto driver_us {microseconds([&] {
+    for (int i = 0; i < sets; i += 6) {
+      by_driver.setMat4f("model", matrix);
+      by_driver.setMat4f("view", matrix);
+      by_driver.setMat4f("projection", matrix);
+      by_driver.setVec3("offset", vector);
+      by_driver.setVec4("tint", vector);
+      by_driver.setFloat("time", static_cast<GLfloat>(i));
+    }
+  })};
+  const auto cache_us {microseconds([&] {
+    for (int i = 0; i < sets; i += 6) {
+      by_cache.setMat4f("model", matrix);
+      by_cache.setMat4f("view", matrix);
+      by_cache.setMat4f("projection", matrix);
+      by_cache.setVec3("offset", vector);
+      by_cache.setVec4("tint", vector);
+      by_cache.setFloat("time", static_cast<GLfloat>(i));
+    }
+  })};
+  const auto model {by_cache.uniform("model")}, view {by_cache.uniform("view")}, projection {by_cache.uniform("projection")};
+  const auto offset {by_cache.uniform("offset")}, tint {by_cache.uniform("tint")}, time {by_cache.uniform("time")};
+  const auto handle_us {microseconds([&] {
+    for (int i = 0; i < sets; i += 6) {
+      by_cache.setMat4f(model, matrix);
+      by_cache.setMat4f(view, matrix);
+      by_cache.setMat4f(projection, matrix);
+      by_cache.setVec3(offset, vector);
+      by_cache.setVec4(tint, vector);
+      by_cache.setFloat(time, static_cast<GLfloat>(i));
+    }
+  })};
+  CHECK(glGetError() == GL_NO_ERROR);
+  glDeleteProgram(id);
+
+  std::printf("per 10k uniform sets\n");
+  std::printf("  glGetUniformLocation %10.1f us\n", driver_us);
+  std::printf("  cache by name        %10.1f us, %.1fx faster\n", cache_us, driver_us / cache_us);
+  std::printf("  cache by handle      %10.1f us, %.1fx faster\n", handle_us, driver_us / handle_us);
+  return test::result();
+}
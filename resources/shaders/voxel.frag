@@ -0,0 +1,43 @@
+#version 430
+
+in vec3 normal;
+in vec2 uv;
+in float ao;
+in float sky_light;
+in float block_light;
+flat in uint layer;
+out vec4 frag_color;
+
+// one colour per block until there is a texture array, see ktp::Blocks
+const vec3 block_colors[11] = vec3[](
+  vec3(1.0, 0.0, 1.0),    // air, never drawn
+  vec3(0.5, 0.5, 0.5),    // stone
+  vec3(0.45, 0.3, 0.15),  // dirt
+  vec3(0.3, 0.65, 0.2),   // grass
+  vec3(0.85, 0.8, 0.55),  // sand
+  vec3(0.2, 0.35, 0.8),   // water
+  vec3(0.95, 0.95, 0.97), // snow
+  vec3(0.2, 0.2, 0.2),    // coal ore
+  vec3(0.75, 0.6, 0.5),   // iron ore
+  vec3(0.95, 0.8, 0.2),   // gold ore
+  vec3(1.0, 0.85, 0.55)   // lamp
+);
+
+const vec3 light_direction = normalize(vec3(0.3, 1.0, 0.5));
+const vec3 lamp_color = vec3(1.0, 0.8, 0.55);
+
+// every level is 80% of the next one, as in Minecraft, so level 0 keeps 3.5%
+float brightness(float level) {
+  return pow(0.8, (1.0 - level) * 15.0);
+}
+
+void main() {
+  vec3 base = block_colors[min(layer, 10u)];
+  // darken the block edges a bit so merged quads still read as blocks
+  vec2 edge = abs(fract(uv) - 0.5);
+  float grid = 1.0 - 0.08 * step(0.47, max(edge.x, edge.y));
+  float diffuse = 0.55 + 0.45 * max(dot(normal, light_direction), 0.0);
+  float occlusion = 0.4 + 0.6 * ao;
+  vec3 light = max(vec3(brightness(sky_light) * diffuse), brightness(block_light) * lamp_color);
+  frag_color = vec4(base * light * occlusion * grid, 1.0);
+}
@@ -0,0 +1,47 @@
+#version 430
+
+// x(5) y(5) z(5) face(3) ao(2) layer(12), sky(4) block(4), see ktp::ChunkVertex
+layout(location = 0) in uvec2 vertex_data;
+// per draw, see ktp::renderer::DrawElementsIndirectCommand::base_instance
+layout(location = 1) in vec3 chunk_origin;
+
+// see ktp::uniforms::Frame
+layout(std140, binding = 0) uniform Frame {
+  mat4 view;
+  mat4 projection;
+  mat4 view_projection;
+  vec4 camera_position;
+  vec4 time;
+};
+
+out vec3 normal;
+out vec2 uv;
+out float ao;
+// the light levels, 0 to 1
+out float sky_light;
+out float block_light;
+flat out uint layer;
+
+const vec3 normals[6] = vec3[](
+  vec3(-1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0),
+  vec3(0.0, -1.0, 0.0), vec3(0.0, 1.0, 0.0),
+  vec3(0.0, 0.0, -1.0), vec3(0.0, 0.0, 1.0)
+);
+
+void main() {
+  uint data = vertex_data.x;
+  vec3 position = vec3(
+    float(data & 31u),
+    float((data >> 5) & 31u),
+    float((data >> 10) & 31u)
+  );
+  uint face = (data >> 15) & 7u;
+  normal = normals[face];
+  // project the position on the face plane so the texture tiles over merged quads
+  uv = face < 2u ? position.zy : (face < 4u ? position.xz : position.xy);
+  ao = float((data >> 18) & 3u) / 3.0;
+  sky_light = float(vertex_data.y & 15u) / 15.0;
+  block_light = float((vertex_data.y >> 4) & 15u) / 15.0;
+  layer = data >> 20;
+  gl_Position = view_projection * vec4(chunk_origin + position, 1.0);
+}
@@ -0,0 +1,35 @@
+#include "camera.hpp"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+ktp::Vector3 ktp::Camera::front() const {
+  const auto yaw {glm::radians(m_yaw)};
+  const auto pitch {glm::radians(m_pitch)};
+  return glm::normalize(Vector3{
+    glm::cos(yaw) * glm::cos(pitch),
+    glm::sin(pitch),
+    glm::sin(yaw) * glm::cos(pitch)
+  });
+}
+
+void ktp::Camera::move(GLfloat forward, GLfloat right, GLfloat up) {
+  const auto direction {front()};
+  const auto side {glm::normalize(glm::cross(direction, Vector3{0.f, 1.f, 0.f}))};
+  m_position += direction * forward + side * right + Vector3{0.f, up, 0.f};
+}
+
+glm::mat4 ktp::Camera::projection(GLfloat aspect) const {
+  return glm::perspective(glm::radians(fov), aspect, near_plane, far_plane);
+}
+
+void ktp::Camera::rotate(GLfloat yaw_delta, GLfloat pitch_delta) {
+  m_yaw += yaw_delta;
+  m_pitch = glm::clamp(m_pitch + pitch_delta, -89.f, 89.f);
+}
+
+glm::mat4 ktp::Camera::view() const {
+  return glm::lookAt(m_position, m_position + front(), Vector3{0.f, 1.f, 0.f});
+}
@@ -0,0 +1,84 @@
+/**
+ * @file camera.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief A first person camera.
+ * @version 0.1
+ * @date 2022-11-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_CAMERA_HPP_)
+#define KETEMINE_SRC_CAMERA_HPP_
+
+#include "types.hpp"
+#include <glm/mat4x4.hpp>
+
+namespace ktp {
+
+/**
+ * @brief A first person camera using yaw and pitch in degrees.
+ */
+class Camera {
+
+ public:
+
+  Camera() = default;
+  Camera(const Point3D& position, GLfloat yaw = 0.f, GLfloat pitch = 0.f): m_position(position), m_yaw(yaw), m_pitch(pitch) {}
+
+  /**
+   * @return The normalized direction the camera is looking at.
+   */
+  Vector3 front() const;
+
+  /**
+   * @brief Moves the camera relative to where it's looking at.
+   * @param forward Distance to move forward (negative goes backwards).
+   * @param right Distance to move to the right (negative goes left).
+   * @param up Distance to move up, in world space.
+   */
+  void move(GLfloat forward, GLfloat right, GLfloat up);
+
+  /**
+   * @return The position of the camera.
+   */
+  const auto& position() const { return m_position; }
+
+  /**
+   * @return The perspective projection matrix.
+   * @param aspect The aspect ratio of the viewport.
+   */
+  glm::mat4 projection(GLfloat aspect) const;
+
+  /**
+   * @brief Rotates the camera. Pitch is clamped to avoid flipping.
+   * @param yaw_delta Degrees to add to the yaw.
+   * @param pitch_delta Degrees to add to the pitch.
+   */
+  void rotate(GLfloat yaw_delta, GLfloat pitch_delta);
+
+  /**
+   * @brief Sets the position of the camera.
+   */
+  void setPosition(const Point3D& position) { m_position = position; }
+
+  /**
+   * @return The view matrix.
+   */
+  glm::mat4 view() const;
+
+  GLfloat fov {70.f};
+  GLfloat near_plane {0.1f};
+  GLfloat far_plane {1000.f};
+
+ private:
+
+  Point3D m_position {};
+  GLfloat m_yaw {};
+  GLfloat m_pitch {};
+};
+
+} // namespace ktp
+
+#endif // KETEMINE_SRC_CAMERA_HPP_
@@ -0,0 +1,80 @@
+#include "chunk.hpp"
+
+#include <algorithm>
+
+// the minimum valid bit width able to address the given number of palette entries
+static GLuint bitsFor(std::size_t palette_size) {
+  if (palette_size <= 1)   return 0;
+  if (palette_size <= 2)   return 1;
+  if (palette_size <= 4)   return 2;
+  if (palette_size <= 16)  return 4;
+  if (palette_size <= 256) return 8;
+  return 16;
+}
+
+void ktp::Chunk::fill(BlockID block) {
+  m_palette.assign(1, block);
+  m_data.clear();
+  m_data.shrink_to_fit();
+  m_bits = 0;
+}
+
+void ktp::Chunk::optimize() {
+  if (m_bits == 0) return;
+  // find the palette entries in use
+  std::vector<bool> used(m_palette.size(), false);
+  for (GLuint i = 0; i < static_cast<GLuint>(volume); ++i) {
+    const auto per_word_shift {s_per_word_shift[m_bits]};
+    const auto word {m_data[i >> per_word_shift]};
+    const auto shift {(i & ((1u << per_word_shift) - 1u)) * m_bits};
+    used[(word >> shift) & ((1ull << m_bits) - 1ull)] = true;
+  }
+  // build the new palette and the translation table
+  std::vector<BlockID> palette {};
+  std::vector<GLuint> remap(m_palette.size(), 0u);
+  for (std::size_t i = 0; i < m_palette.size(); ++i) {
+    if (!used[i]) continue;
+    remap[i] = static_cast<GLuint>(palette.size());
+    palette.push_back(m_palette[i]);
+  }
+  const auto bits {bitsFor(palette.size())};
+  repack(bits, &remap);
+  m_palette = std::move(palette);
+  m_palette.shrink_to_fit();
+}
+
+GLuint ktp::Chunk::paletteIndex(BlockID block) {
+  const auto found {std::find(m_palette.cbegin(), m_palette.cend(), block)};
+  if (found != m_palette.cend()) return static_cast<GLuint>(found - m_palette.cbegin());
+  m_palette.push_back(block);
+  const auto bits {bitsFor(m_palette.size())};
+  if (bits != m_bits) repack(bits);
+  return static_cast<GLuint>(m_palette.size() - 1);
+}
+
+void ktp::Chunk::repack(GLuint bits, const std::vector<GLuint>* remap) {
+  if (bits == 0) {
+    // every block is the same, so there is nothing to index
+    m_data.clear();
+    m_data.shrink_to_fit();
+    m_bits = 0;
+    return;
+  }
+  const auto old_bits {m_bits};
+  const auto old_data {std::move(m_data)};
+  m_bits = bits;
+  m_data.assign(static_cast<std::size_t>(volume) >> s_per_word_shift[m_bits], 0ull);
+  if (old_bits == 0) return; // every index is 0 already
+  const auto old_per_word_shift {s_per_word_shift[old_bits]};
+  for (GLuint i = 0; i < static_cast<GLuint>(volume); ++i) {
+    const auto word {old_data[i >> old_per_word_shift]};
+    const auto shift {(i & ((1u << old_per_word_shift) - 1u)) * old_bits};
+    const auto palette_index {static_cast<GLuint>((word >> shift) & ((1ull << old_bits) - 1ull))};
+    write(i, remap ? (*remap)[palette_index] : palette_index);
+  }
+}
+
+void ktp::Chunk::set(GLuint index, BlockID block) {
+  if (m_bits == 0 && m_palette.front() == block) return;
+  write(index, paletteIndex(block));
+}
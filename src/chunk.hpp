@@ -0,0 +1,222 @@
+/**
+ * @file chunk.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Voxel storage for a 16x16x16 section of the world.
+ * @version 0.1
+ * @date 2022-11-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_CHUNK_HPP_)
+#define KETEMINE_SRC_CHUNK_HPP_
+
+#include "types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ktp {
+
+namespace Blocks {
+
+  constexpr BlockID air   {0};
+  constexpr BlockID stone {1};
+  constexpr BlockID dirt  {2};
+  constexpr BlockID grass {3};
+  constexpr BlockID sand  {4};
+  constexpr BlockID water {5};
+  constexpr BlockID snow  {6};
+  constexpr BlockID coal_ore {7};
+  constexpr BlockID iron_ore {8};
+  constexpr BlockID gold_ore {9};
+  constexpr BlockID lamp     {10};
+
+  /**
+   * @return True if rays and bodies stop at the block, they go through air and water.
+   */
+  constexpr bool solid(BlockID block) { return block != air && block != water; }
+
+} // namespace Blocks
+
+/**
+ * @brief A 16x16x16 section of blocks stored behind a palette.
+ *  Every block is an index into the palette, packed with the minimum power of
+ *  two bit width able to address the palette: 0 bits for uniform sections,
+ *  then 1, 2, 4, 8 and 16. Indices never span two words, so lookups are O(1)
+ *  shifts and masks, and memory grows with the variety of the content
+ *  instead of with the volume.
+ */
+class Chunk {
+
+ public:
+
+  static constexpr GLint size {16};
+  static constexpr GLint volume {size * size * size};
+
+  Chunk() = default;
+  explicit Chunk(BlockID block): m_palette{block} {}
+
+  /**
+   * @return The index of a local position inside the section.
+   */
+  static constexpr GLuint index(GLint x, GLint y, GLint z) {
+    return static_cast<GLuint>((y << 8) | (z << 4) | x);
+  }
+
+  /**
+   * @return The number of bits used by every block index.
+   */
+  auto bitsPerBlock() const { return m_bits; }
+
+  /**
+   * @brief Sets every block of the section to the given one, releasing the indices.
+   * @param block The block to fill the section with.
+   */
+  void fill(BlockID block);
+
+  /**
+   * @brief Gets the block at a local position. No bounds checking!
+   * @param x Local x coordinate [0, 15].
+   * @param y Local y coordinate [0, 15].
+   * @param z Local z coordinate [0, 15].
+   * @return The block id.
+   */
+  BlockID get(GLint x, GLint y, GLint z) const { return get(index(x, y, z)); }
+
+  /**
+   * @brief Gets the block at a given index. No bounds checking!
+   * @param index The index as returned by Chunk::index().
+   * @return The block id.
+   */
+  BlockID get(GLuint index) const {
+    if (m_bits == 0) return m_palette.front();
+    const auto per_word_shift {s_per_word_shift[m_bits]};
+    const auto word {m_data[index >> per_word_shift]};
+    const auto shift {(index & ((1u << per_word_shift) - 1u)) * m_bits};
+    return m_palette[(word >> shift) & ((1ull << m_bits) - 1ull)];
+  }
+
+  /**
+   * @return True if every block in the section is air.
+   */
+  bool isEmpty() const { return m_bits == 0 && m_palette.front() == Blocks::air; }
+
+  /**
+   * @return The approximate memory used by the section in bytes.
+   */
+  std::size_t memoryUsage() const {
+    return sizeof(Chunk) + m_palette.capacity() * sizeof(BlockID) + m_data.capacity() * sizeof(std::uint64_t);
+  }
+
+  /**
+   * @brief Removes unused palette entries and shrinks the indices if possible.
+   */
+  void optimize();
+
+  /**
+   * @return The palette of the section.
+   */
+  const auto& palette() const { return m_palette; }
+
+  /**
+   * @brief Sets the block at a local position. No bounds checking!
+   * @param x Local x coordinate [0, 15].
+   * @param y Local y coordinate [0, 15].
+   * @param z Local z coordinate [0, 15].
+   * @param block The block id.
+   */
+  void set(GLint x, GLint y, GLint z, BlockID block) { set(index(x, y, z), block); }
+
+  /**
+   * @brief Sets the block at a given index. No bounds checking!
+   * @param index The index as returned by Chunk::index().
+   * @param block The block id.
+   */
+  void set(GLuint index, BlockID block);
+
+ private:
+
+  // log2 of the number of indices stored in a word, by bit width
+  static constexpr GLuint s_per_word_shift[17] {0, 6, 5, 0, 4, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 2};
+
+  /**
+   * @brief Finds the palette index of a block, adding it if not present.
+   * @param block The block id.
+   * @return The palette index of the block.
+   */
+  GLuint paletteIndex(BlockID block);
+
+  /**
+   * @brief Repacks every index with a new bit width.
+   * @param bits The new bit width. Must be 0, 1, 2, 4, 8 or 16.
+   * @param remap Optional table translating old palette indices to new ones.
+   */
+  void repack(GLuint bits, const std::vector<GLuint>* remap = nullptr);
+
+  /**
+   * @brief Writes a palette index into the packed data.
+   */
+  void write(GLuint index, GLuint palette_index) {
+    const auto per_word_shift {s_per_word_shift[m_bits]};
+    auto& word {m_data[index >> per_word_shift]};
+    const auto shift {(index & ((1u << per_word_shift) - 1u)) * m_bits};
+    const auto mask {((1ull << m_bits) - 1ull) << shift};
+    word = (word & ~mask) | (static_cast<std::uint64_t>(palette_index) << shift);
+  }
+
+  std::vector<BlockID> m_palette {Blocks::air};
+  std::vector<std::uint64_t> m_data {};
+  GLuint m_bits {0};
+};
+
+enum class LightChannel: std::uint8_t {
+  Sky,
+  Block
+};
+
+/**
+ * @brief The light levels of a section, [0, 15] for the skylight and for the
+ *  light of the blocks, packed as 4 bit nibbles in Chunk::index() order.
+ *  2 KiB per channel, whatever the content of the section.
+ */
+class ChunkLight {
+
+ public:
+
+  /**
+   * @brief Gets the light level of a block. No bounds checking!
+   * @param channel Skylight or block light.
+   * @param index The index as returned by Chunk::index().
+   * @return The light level.
+   */
+  std::uint8_t get(LightChannel channel, GLuint index) const {
+    const auto byte {m_levels[static_cast<std::size_t>(channel)][index >> 1]};
+    return static_cast<std::uint8_t>((byte >> ((index & 1u) << 2)) & 15u);
+  }
+
+  /**
+   * @brief Sets the light level of a block. No bounds checking!
+   * @param channel Skylight or block light.
+   * @param index The index as returned by Chunk::index().
+   * @param level The light level [0, 15].
+   */
+  void set(LightChannel channel, GLuint index, std::uint8_t level) {
+    auto& byte {m_levels[static_cast<std::size_t>(channel)][index >> 1]};
+    const auto shift {(index & 1u) << 2};
+    byte = static_cast<std::uint8_t>((byte & ~(15u << shift)) | ((level & 15u) << shift));
+  }
+
+  bool operator==(const ChunkLight& other) const = default;
+
+ private:
+
+  // the even index in the low nibble of every byte
+  std::array<std::array<std::uint8_t, Chunk::volume / 2>, 2> m_levels {};
+};
+
+} // namespace ktp
+
+#endif // KETEMINE_SRC_CHUNK_HPP_
@@ -0,0 +1,267 @@
+#include "ecs.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+
+namespace {
+
+using namespace ktp;
+
+// the size of every component type, by id
+std::vector<std::size_t> component_sizes {};
+std::mutex component_mutex {};
+
+std::size_t componentSize(ecs::ComponentID id) {
+  std::scoped_lock lock {component_mutex};
+  return component_sizes[id];
+}
+
+// the entities of the benchmark
+
+struct Position {
+  Point3D value {};
+};
+
+struct Velocity {
+  Vector3 value {};
+};
+
+struct Health {
+  GLfloat points {};
+};
+
+struct Lifetime {
+  GLfloat seconds {};
+};
+
+constexpr GLfloat gravity {28.f};
+constexpr GLfloat tick_time {1.f / 60.f};
+constexpr GLfloat particle_lifetime {2.f};
+
+// bounces on the ground at y 0, losing half its speed
+void fall(Point3D& position, Vector3& velocity) {
+  velocity.y -= gravity * tick_time;
+  position += velocity * tick_time;
+  if (position.y < 0.f) {
+    position.y = -position.y;
+    velocity.y *= -0.5f;
+  }
+}
+
+// spent particles come back to life instead of being destroyed, so every
+// tick updates the same entities
+void age(Lifetime& lifetime) {
+  lifetime.seconds -= tick_time;
+  if (lifetime.seconds < 0.f) lifetime.seconds += particle_lifetime;
+}
+
+// the same entities the usual object oriented way
+class Object {
+ public:
+  Object(const Point3D& position, const Vector3& velocity): m_position(position), m_velocity(velocity) {}
+  virtual ~Object() = default;
+  virtual void update() { fall(m_position, m_velocity); }
+ protected:
+  Point3D m_position;
+  Vector3 m_velocity;
+};
+
+class Mob: public Object {
+ public:
+  Mob(const Point3D& position, const Vector3& velocity, GLfloat health): Object(position, velocity), m_health(health) {}
+ protected:
+  GLfloat m_health;
+};
+
+class Particle: public Object {
+ public:
+  Particle(const Point3D& position, const Vector3& velocity, GLfloat seconds): Object(position, velocity), m_lifetime{seconds} {}
+  void update() override {
+    Object::update();
+    age(m_lifetime);
+  }
+ protected:
+  Lifetime m_lifetime;
+};
+
+} // namespace
+
+ktp::ecs::Timing ktp::ecs::benchmark(std::size_t entities, std::size_t ticks) {
+  Timing timing {};
+  timing.entities = entities;
+  if (entities == 0 || ticks == 0) return timing;
+  // a mob, 3 items and 6 particles out of every 10
+  const auto kind {[](std::size_t i) { return i % 10; }};
+  std::mt19937 rng {7};
+  std::uniform_real_distribution<GLfloat> spread {-64.f, 64.f};
+  const auto position {[&rng, &spread]() { return Point3D{spread(rng), spread(rng) + 64.f, spread(rng)}; }};
+  const auto velocity {[&rng, &spread]() { return Vector3{spread(rng), spread(rng), spread(rng)} * 0.1f; }};
+
+  Registry registry {};
+  auto start {std::chrono::steady_clock::now()};
+  for (std::size_t i = 0; i < entities; ++i) {
+    if (kind(i) == 0) {
+      registry.create(Position{position()}, Velocity{velocity()}, Health{20.f});
+    } else if (kind(i) < 4) {
+      registry.create(Position{position()}, Velocity{velocity()});
+    } else {
+      registry.create(Position{position()}, Velocity{velocity()}, Lifetime{particle_lifetime});
+    }
+  }
+  timing.create_ms = std::chrono::duration<GLdouble, std::milli>{std::chrono::steady_clock::now() - start}.count();
+  timing.archetypes = registry.archetypes();
+
+  start = std::chrono::steady_clock::now();
+  for (std::size_t t = 0; t < ticks; ++t) {
+    registry.forEach<Position, Velocity>([](Position& p, Velocity& v) { fall(p.value, v.value); });
+    registry.forEach<Lifetime>([](Lifetime& lifetime) { age(lifetime); });
+  }
+  timing.tick_ms = std::chrono::duration<GLdouble, std::milli>{std::chrono::steady_clock::now() - start}.count() / static_cast<GLdouble>(ticks);
+
+  // big enough batches for the job overhead not to matter
+  constexpr std::size_t batch_size {4096};
+  start = std::chrono::steady_clock::now();
+  for (std::size_t t = 0; t < ticks; ++t) {
+    registry.parallelForEach<Position, Velocity>(batch_size, [](Position& p, Velocity& v) { fall(p.value, v.value); });
+    registry.parallelForEach<Lifetime>(batch_size, [](Lifetime& lifetime) { age(lifetime); });
+  }
+  timing.parallel_tick_ms = std::chrono::duration<GLdouble, std::milli>{std::chrono::steady_clock::now() - start}.count() / static_cast<GLdouble>(ticks);
+
+  std::vector<std::unique_ptr<Object>> objects {};
+  objects.reserve(entities);
+  for (std::size_t i = 0; i < entities; ++i) {
+    if (kind(i) == 0) {
+      objects.push_back(std::make_unique<Mob>(position(), velocity(), 20.f));
+    } else if (kind(i) < 4) {
+      objects.push_back(std::make_unique<Object>(position(), velocity()));
+    } else {
+      objects.push_back(std::make_unique<Particle>(position(), velocity(), particle_lifetime));
+    }
+  }
+  start = std::chrono::steady_clock::now();
+  for (std::size_t t = 0; t < ticks; ++t) {
+    for (auto& object: objects) object->update();
+  }
+  timing.objects_tick_ms = std::chrono::duration<GLdouble, std::milli>{std::chrono::steady_clock::now() - start}.count() / static_cast<GLdouble>(ticks);
+  return timing;
+}
+
+// REGISTRY
+
+ktp::ecs::Entity ktp::ecs::Registry::allocate(Mask mask) {
+  const auto index {archetype(mask)};
+  auto& archetype {m_archetypes[index]};
+  std::uint32_t entity_index {};
+  if (m_free.empty()) {
+    entity_index = static_cast<std::uint32_t>(m_records.size());
+    m_records.emplace_back();
+  } else {
+    entity_index = m_free.back();
+    m_free.pop_back();
+  }
+  auto& record {m_records[entity_index]};
+  const Entity entity {entity_index, record.generation};
+  record.archetype = index;
+  record.row = static_cast<std::uint32_t>(archetype.entities.size());
+  archetype.entities.push_back(entity);
+  for (auto& column: archetype.columns) column.data.resize(column.data.size() + column.size);
+  ++m_size;
+  return entity;
+}
+
+bool ktp::ecs::Registry::alive(Entity entity) const {
+  return entity.index < m_records.size() && m_records[entity.index].generation == entity.generation;
+}
+
+std::uint32_t ktp::ecs::Registry::archetype(Mask mask) {
+  const auto found {m_archetype_index.find(mask)};
+  if (found != m_archetype_index.end()) return found->second;
+  const auto index {static_cast<std::uint32_t>(m_archetypes.size())};
+  auto& archetype {m_archetypes.emplace_back()};
+  archetype.mask = mask;
+  archetype.column_of.fill(no_column);
+  for (ComponentID id = 0; id < max_components; ++id) {
+    if (!(mask & (Mask{1} << id))) continue;
+    archetype.column_of[id] = static_cast<std::uint8_t>(archetype.columns.size());
+    archetype.columns.push_back({componentSize(id), {}});
+  }
+  m_archetype_index.emplace(mask, index);
+  return index;
+}
+
+void ktp::ecs::Registry::clear() {
+  for (auto& archetype: m_archetypes) {
+    for (const auto& entity: archetype.entities) {
+      ++m_records[entity.index].generation;
+      m_free.push_back(entity.index);
+    }
+    archetype.entities.clear();
+    for (auto& column: archetype.columns) column.data.clear();
+  }
+  m_size = 0;
+}
+
+void ktp::ecs::Registry::destroy(Entity entity) {
+  if (!alive(entity)) return;
+  auto& record {m_records[entity.index]};
+  removeRow(record.archetype, record.row);
+  ++record.generation;
+  m_free.push_back(entity.index);
+  --m_size;
+}
+
+void ktp::ecs::Registry::migrate(Entity entity, Mask mask) {
+  // may add an archetype, the references come after
+  const auto to {archetype(mask)};
+  auto& record {m_records[entity.index]};
+  const auto from {record.archetype};
+  const auto row {record.row};
+  if (to == from) return;
+  auto& source {m_archetypes[from]};
+  auto& target {m_archetypes[to]};
+  const auto new_row {static_cast<std::uint32_t>(target.entities.size())};
+  target.entities.push_back(entity);
+  for (ComponentID id = 0; id < max_components; ++id) {
+    const auto column {target.column_of[id]};
+    if (column == no_column) continue;
+    auto& data {target.columns[column].data};
+    const auto size {target.columns[column].size};
+    data.resize(data.size() + size);
+    if (source.column_of[id] != no_column) {
+      std::memcpy(data.data() + new_row * size, source.columns[source.column_of[id]].data.data() + row * size, size);
+    }
+  }
+  removeRow(from, row);
+  record.archetype = to;
+  record.row = new_row;
+}
+
+ktp::ecs::ComponentID ktp::ecs::Registry::registerComponent(std::size_t size) {
+  std::scoped_lock lock {component_mutex};
+  if (component_sizes.size() == max_components) {
+    std::cerr << "ECS error: more than " << max_components << " component types\n";
+    exit(EXIT_FAILURE);
+  }
+  component_sizes.push_back(size);
+  return static_cast<ComponentID>(component_sizes.size() - 1);
+}
+
+void ktp::ecs::Registry::removeRow(std::uint32_t archetype_index, std::uint32_t row) {
+  auto& archetype {m_archetypes[archetype_index]};
+  const auto last {static_cast<std::uint32_t>(archetype.entities.size() - 1)};
+  if (row != last) {
+    const auto moved {archetype.entities[last]};
+    archetype.entities[row] = moved;
+    m_records[moved.index].row = row;
+    for (auto& column: archetype.columns) {
+      std::memcpy(column.data.data() + row * column.size, column.data.data() + last * column.size, column.size);
+    }
+  }
+  archetype.entities.pop_back();
+  for (auto& column: archetype.columns) column.data.resize(column.data.size() - column.size);
+}
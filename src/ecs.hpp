@@ -0,0 +1,327 @@
+/**
+ * @file ecs.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Archetype based entities, for mobs, dropped items and particles.
+ * @version 0.1
+ * @date 2022-12-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_ECS_HPP_)
+#define KETEMINE_SRC_ECS_HPP_
+
+#include "jobs.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace ktp { namespace ecs {
+
+using ComponentID = std::uint32_t;
+// the components of an archetype, a bit per component id
+using Mask = std::uint64_t;
+
+constexpr ComponentID max_components {64};
+
+/**
+ * @brief A handle to an entity. The generation tells apart the entities
+ *  reusing the index of a destroyed one.
+ */
+struct Entity {
+  std::uint32_t index {0xFFFFFFFFu};
+  std::uint32_t generation {};
+  bool operator==(const Entity& other) const = default;
+};
+
+/**
+ * @brief Update times of the same entities stored three ways, see benchmark().
+ */
+struct Timing {
+  std::size_t entities {};
+  std::size_t archetypes {};
+  GLdouble create_ms {};
+  // per tick, the systems run one after the other on the calling thread
+  GLdouble tick_ms {};
+  // per tick, every system split in batches on the job system
+  GLdouble parallel_tick_ms {};
+  // per tick, an object with a virtual update per entity, for comparison
+  GLdouble objects_tick_ms {};
+};
+
+/**
+ * @brief Creates mobs, dropped items and particles and ticks them: gravity,
+ *  bouncing on the ground and particles running out of time.
+ * @param entities How many entities to create.
+ * @param ticks How many ticks to time.
+ * @return The average times.
+ */
+Timing benchmark(std::size_t entities, std::size_t ticks);
+
+/**
+ * @brief Holds the entities, grouped by archetype: the entities having the
+ *  same set of components. Every archetype keeps each component in its own
+ *  dense array, so a system reads only the components it uses, in order,
+ *  and entities cost no allocation of their own. Destroying an entity moves
+ *  the last one of its archetype into the hole.
+ *
+ *  Components must be trivially copyable, they are moved around as bytes.
+ *  Entities can't be created, destroyed or given other components while a
+ *  forEach is running, collect them and do it afterwards.
+ */
+class Registry {
+
+ public:
+
+  /**
+   * @tparam T The component type.
+   * @return The id of the component type, the same for every registry.
+   */
+  template <typename T>
+  static ComponentID componentID() {
+    static_assert(std::is_trivially_copyable_v<T>, "components are copied as bytes");
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "the arrays of components are byte arrays");
+    static const ComponentID id {registerComponent(sizeof(T))};
+    return id;
+  }
+
+  /**
+   * @tparam Ts The component types.
+   * @return The mask of the archetype having those components.
+   */
+  template <typename... Ts>
+  static Mask mask() { return (Mask{} | ... | (Mask{1} << componentID<Ts>())); }
+
+  /**
+   * @brief Gives a component to an entity, moving it to another archetype.
+   *  If it already has one, it's replaced.
+   * @param entity The entity.
+   * @param component The component.
+   */
+  template <typename T>
+  void add(Entity entity, const T& component) {
+    if (!alive(entity)) return;
+    if (!has<T>(entity)) migrate(entity, m_archetypes[m_records[entity.index].archetype].mask | mask<T>());
+    *get<T>(entity) = component;
+  }
+
+  /**
+   * @param entity An entity.
+   * @return True if the entity wasn't destroyed.
+   */
+  bool alive(Entity entity) const;
+
+  /**
+   * @return The number of archetypes, some may be empty.
+   */
+  std::size_t archetypes() const { return m_archetypes.size(); }
+
+  /**
+   * @brief Destroys every entity. The archetypes stay.
+   */
+  void clear();
+
+  /**
+   * @brief Creates an entity with some components.
+   * @param components The components, of different types.
+   * @return The entity.
+   */
+  template <typename... Ts>
+  Entity create(const Ts&... components) {
+    const auto entity {allocate(mask<Ts...>())};
+    ((*get<Ts>(entity) = components), ...);
+    return entity;
+  }
+
+  /**
+   * @brief Destroys an entity, if it's alive.
+   * @param entity The entity.
+   */
+  void destroy(Entity entity);
+
+  /**
+   * @brief Calls a function for every entity having some components. Other
+   *  components of the entities don't matter.
+   * @param function Called with a reference to each component.
+   */
+  template <typename... Ts, typename Function>
+  void forEach(Function&& function) {
+    forEachArchetype<Ts...>([&function](std::size_t count, const Entity*, Ts*... arrays) {
+      for (std::size_t i = 0; i < count; ++i) function(arrays[i]...);
+    });
+  }
+
+  /**
+   * @brief Calls a function for every archetype with entities having some
+   *  components, with the arrays of those components. For loops the compiler
+   *  can vectorize.
+   * @param function Called with the number of entities, the array of
+   *  entities and the array of each component.
+   */
+  template <typename... Ts, typename Function>
+  void forEachArchetype(Function&& function) {
+    const auto required {mask<Ts...>()};
+    for (auto& archetype: m_archetypes) {
+      if ((archetype.mask & required) != required || archetype.entities.empty()) continue;
+      function(archetype.entities.size(), archetype.entities.data(), archetype.template array<Ts>()...);
+    }
+  }
+
+  /**
+   * @param entity An entity.
+   * @return Its component, or nullptr if it has none or it's not alive. Only
+   *  valid until entities are created or destroyed.
+   */
+  template <typename T>
+  T* get(Entity entity) {
+    if (!alive(entity)) return nullptr;
+    const auto& record {m_records[entity.index]};
+    auto& archetype {m_archetypes[record.archetype]};
+    if (!(archetype.mask & mask<T>())) return nullptr;
+    return archetype.template array<T>() + record.row;
+  }
+
+  /**
+   * @param entity An entity.
+   * @return True if the entity is alive and has the component.
+   */
+  template <typename T>
+  bool has(Entity entity) const {
+    return alive(entity) && (m_archetypes[m_records[entity.index].archetype].mask & mask<T>());
+  }
+
+  /**
+   * @brief Like forEach(), but the entities are split in batches run in
+   *  parallel on the job system, whatever archetype they are in. Waits for
+   *  all of them. The function must only touch the components it's given.
+   * @param batch_size The number of entities of every job.
+   * @param function Called with a reference to each component.
+   */
+  template <typename... Ts, typename Function>
+  void parallelForEach(std::size_t batch_size, Function&& function) {
+    // the entities of the archetypes one after the other, every span starts
+    // where the last one ends
+    struct Span {
+      Archetype* archetype;
+      std::size_t first;
+    };
+    std::vector<Span> spans {};
+    std::size_t count {};
+    const auto required {mask<Ts...>()};
+    for (auto& archetype: m_archetypes) {
+      if ((archetype.mask & required) != required || archetype.entities.empty()) continue;
+      spans.push_back({&archetype, count});
+      count += archetype.entities.size();
+    }
+    jobs::parallelFor(count, batch_size, [&spans, &function](std::size_t begin, std::size_t end) {
+      const auto rows {[&function](std::size_t first, std::size_t last, Ts*... arrays) {
+        for (auto row = first; row < last; ++row) function(arrays[row]...);
+      }};
+      // a batch may cross into the next archetypes
+      auto span {std::upper_bound(spans.begin(), spans.end(), begin, [](std::size_t i, const Span& s) { return i < s.first; }) - 1};
+      while (begin < end) {
+        auto& archetype {*span->archetype};
+        const auto last {std::min(end - span->first, archetype.entities.size())};
+        rows(begin - span->first, last, archetype.template array<Ts>()...);
+        begin = span->first + last;
+        ++span;
+      }
+    });
+  }
+
+  /**
+   * @brief Takes a component from an entity, moving it to another archetype.
+   * @param entity The entity.
+   */
+  template <typename T>
+  void remove(Entity entity) {
+    if (!has<T>(entity)) return;
+    migrate(entity, m_archetypes[m_records[entity.index].archetype].mask & ~mask<T>());
+  }
+
+  /**
+   * @return The number of entities alive.
+   */
+  std::size_t size() const { return m_size; }
+
+ private:
+
+  static constexpr std::uint8_t no_column {0xFF};
+
+  struct Column {
+    // of a component
+    std::size_t size {};
+    std::vector<std::byte> data {};
+  };
+
+  struct Archetype {
+    Mask mask {};
+    // in component id order
+    std::vector<Column> columns {};
+    std::vector<Entity> entities {};
+    // the column of every component id
+    std::array<std::uint8_t, max_components> column_of {};
+
+    template <typename T>
+    T* array() { return reinterpret_cast<T*>(columns[column_of[componentID<T>()]].data.data()); }
+  };
+
+  // where an entity is, and the generation of its index
+  struct Record {
+    std::uint32_t archetype {};
+    std::uint32_t row {};
+    std::uint32_t generation {};
+  };
+
+  /**
+   * @brief Creates an entity with zeroed components.
+   * @param mask The components.
+   * @return The entity.
+   */
+  Entity allocate(Mask mask);
+
+  /**
+   * @param mask The components.
+   * @return The index of the archetype, created if it doesn't exist.
+   */
+  std::uint32_t archetype(Mask mask);
+
+  /**
+   * @brief Moves an entity to the archetype of other components, keeping the
+   *  components both have. The new ones are zeroed.
+   * @param entity The entity, alive.
+   * @param mask The new components.
+   */
+  void migrate(Entity entity, Mask mask);
+
+  /**
+   * @param size The size of the component type.
+   * @return The next component id.
+   */
+  static ComponentID registerComponent(std::size_t size);
+
+  /**
+   * @brief Removes a row of an archetype, moving the last one into it.
+   * @param archetype_index The index of the archetype.
+   * @param row The row.
+   */
+  void removeRow(std::uint32_t archetype_index, std::uint32_t row);
+
+  std::vector<Archetype> m_archetypes {};
+  std::unordered_map<Mask, std::uint32_t> m_archetype_index {};
+  std::vector<Record> m_records {};
+  // indices of destroyed entities, reused first
+  std::vector<std::uint32_t> m_free {};
+  std::size_t m_size {};
+};
+
+} } // namespace ecs/ktp
+
+#endif // KETEMINE_SRC_ECS_HPP_
@@ -0,0 +1,180 @@
+#include "frustum.hpp"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define KTP_CULL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define KTP_CULL_SSE2
+#endif
+
+/* AabbArray */
+
+void ktp::AabbArray::clear() {
+  for (std::size_t axis = 0; axis < 3; ++axis) {
+    m_min[axis].clear();
+    m_max[axis].clear();
+  }
+}
+
+void ktp::AabbArray::push(const Point3D& min, const Point3D& max) {
+  for (std::size_t axis = 0; axis < 3; ++axis) {
+    m_min[axis].push_back(min[static_cast<int>(axis)]);
+    m_max[axis].push_back(max[static_cast<int>(axis)]);
+  }
+}
+
+void ktp::AabbArray::reserve(std::size_t count) {
+  for (std::size_t axis = 0; axis < 3; ++axis) {
+    m_min[axis].reserve(count);
+    m_max[axis].reserve(count);
+  }
+}
+
+/* Frustum */
+
+ktp::Frustum::Frustum(const glm::mat4& view_projection) {
+  // the rows of the matrix, glm is column major
+  glm::vec4 rows[4] {};
+  for (int row = 0; row < 4; ++row) {
+    rows[row] = {view_projection[0][row], view_projection[1][row], view_projection[2][row], view_projection[3][row]};
+  }
+  for (std::size_t axis = 0; axis < 3; ++axis) {
+    m_planes[axis * 2]     = rows[3] + rows[axis];
+    m_planes[axis * 2 + 1] = rows[3] - rows[axis];
+  }
+  for (auto& plane: m_planes) {
+    plane /= glm::length(Vector3{plane});
+  }
+}
+
+bool ktp::Frustum::intersects(const Point3D& min, const Point3D& max) const {
+  for (const auto& plane: m_planes) {
+    // the corner furthest along the normal
+    const Point3D corner {
+      plane.x > 0.f ? max.x : min.x,
+      plane.y > 0.f ? max.y : min.y,
+      plane.z > 0.f ? max.z : min.z
+    };
+    if (glm::dot(Vector3{plane}, corner) + plane.w < 0.f) return false;
+  }
+  return true;
+}
+
+// the planes are the same for every box, so instead of selecting the corner
+// furthest along the normal per box, every plane picks the arrays to read
+void ktp::Frustum::cull(const AabbArray& boxes, std::vector<GLuint>& visible) const {
+  const GLfloat* corners[6][3] {};
+  for (std::size_t p = 0; p < 6; ++p) {
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+      corners[p][axis] = m_planes[p][static_cast<int>(axis)] > 0.f ? boxes.max(axis) : boxes.min(axis);
+    }
+  }
+  const auto count {boxes.size()};
+  std::size_t i {0};
+#if defined(KTP_CULL_AVX2)
+  for (; i + 8 <= count; i += 8) {
+    auto inside {_mm256_castsi256_ps(_mm256_set1_epi32(-1))};
+    for (std::size_t p = 0; p < 6; ++p) {
+      auto distance {_mm256_set1_ps(m_planes[p].w)};
+      distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(m_planes[p].x), _mm256_loadu_ps(corners[p][0] + i)));
+      distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(m_planes[p].y), _mm256_loadu_ps(corners[p][1] + i)));
+      distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(m_planes[p].z), _mm256_loadu_ps(corners[p][2] + i)));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+    }
+    const auto mask {_mm256_movemask_ps(inside)};
+    for (GLuint lane = 0; lane < 8; ++lane) {
+      if (mask & (1 << lane)) visible.push_back(static_cast<GLuint>(i) + lane);
+    }
+  }
+#elif defined(KTP_CULL_SSE2)
+  for (; i + 4 <= count; i += 4) {
+    auto inside {_mm_castsi128_ps(_mm_set1_epi32(-1))};
+    for (std::size_t p = 0; p < 6; ++p) {
+      auto distance {_mm_set1_ps(m_planes[p].w)};
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[p].x), _mm_loadu_ps(corners[p][0] + i)));
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[p].y), _mm_loadu_ps(corners[p][1] + i)));
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[p].z), _mm_loadu_ps(corners[p][2] + i)));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+    }
+    const auto mask {_mm_movemask_ps(inside)};
+    for (GLuint lane = 0; lane < 4; ++lane) {
+      if (mask & (1 << lane)) visible.push_back(static_cast<GLuint>(i) + lane);
+    }
+  }
+#endif
+  // the boxes that don't fill a whole register
+  cullScalar(boxes, visible, i);
+}
+
+void ktp::Frustum::cullScalar(const AabbArray& boxes, std::vector<GLuint>& visible, std::size_t first) const {
+  const auto count {boxes.size()};
+  for (auto i = first; i < count; ++i) {
+    bool inside {true};
+    for (const auto& plane: m_planes) {
+      const auto x {plane.x > 0.f ? boxes.max(0)[i] : boxes.min(0)[i]};
+      const auto y {plane.y > 0.f ? boxes.max(1)[i] : boxes.min(1)[i]};
+      const auto z {plane.z > 0.f ? boxes.max(2)[i] : boxes.min(2)[i]};
+      inside &= plane.x * x + plane.y * y + plane.z * z + plane.w >= 0.f;
+    }
+    if (inside) visible.push_back(static_cast<GLuint>(i));
+  }
+}
+
+/* frustum */
+
+ktp::frustum::Throughput ktp::frustum::benchmark(const glm::mat4& view_projection, const Point3D& center, std::size_t count) {
+  auto side {static_cast<GLint>(std::cbrt(static_cast<GLdouble>(count)))};
+  // cbrt() may land just below an exact cube
+  while (static_cast<std::size_t>((side + 1) * (side + 1) * (side + 1)) <= count) ++side;
+  AabbArray boxes {};
+  boxes.reserve(static_cast<std::size_t>(side * side * side));
+  const auto first {glm::floor(center / 16.f) * 16.f - Point3D{static_cast<GLfloat>(side / 2 * 16)}};
+  for (GLint y = 0; y < side; ++y) {
+    for (GLint z = 0; z < side; ++z) {
+      for (GLint x = 0; x < side; ++x) {
+        const auto min {first + Point3D{static_cast<GLfloat>(x), static_cast<GLfloat>(y), static_cast<GLfloat>(z)} * 16.f};
+        boxes.push(min, min + Point3D{16.f});
+      }
+    }
+  }
+  Throughput throughput {};
+  throughput.boxes = boxes.size();
+  if (boxes.size() == 0) return throughput;
+
+  const Frustum frustum {view_projection};
+  // some 10 million boxes per kernel, enough to get past the timer resolution
+  const auto rounds {std::max(std::size_t{1}, std::size_t{10000000} / boxes.size())};
+  std::vector<GLuint> scalar {}, simd {};
+  scalar.reserve(boxes.size());
+  simd.reserve(boxes.size());
+  const auto boxesPerMicrosecond {[&boxes, rounds](auto&& cull, std::vector<GLuint>& visible) {
+    const auto start {std::chrono::steady_clock::now()};
+    for (std::size_t round = 0; round < rounds; ++round) {
+      visible.clear();
+      cull(visible);
+    }
+    const auto microseconds {std::chrono::duration<GLdouble, std::micro>(std::chrono::steady_clock::now() - start).count()};
+    return static_cast<GLdouble>(boxes.size() * rounds) / microseconds;
+  }};
+  throughput.scalar_per_us = boxesPerMicrosecond([&](std::vector<GLuint>& visible) { frustum.cullScalar(boxes, visible); }, scalar);
+  throughput.simd_per_us = boxesPerMicrosecond([&](std::vector<GLuint>& visible) { frustum.cull(boxes, visible); }, simd);
+  throughput.visible = scalar.size();
+  throughput.same = scalar == simd;
+  return throughput;
+}
+
+const char* ktp::frustum::kernel() {
+#if defined(KTP_CULL_AVX2)
+  return "AVX2";
+#elif defined(KTP_CULL_SSE2)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,157 @@
+/**
+ * @file frustum.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief View frustum tests.
+ * @version 0.1
+ * @date 2022-11-30
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_FRUSTUM_HPP_)
+#define KETEMINE_SRC_FRUSTUM_HPP_
+
+#include "types.hpp"
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace ktp {
+
+/**
+ * @brief Axis aligned boxes as a structure of arrays, so the culling kernels
+ *  can load the same coordinate of several boxes at once.
+ */
+class AabbArray {
+
+ public:
+
+  /**
+   * @brief Removes every box, keeping the memory.
+   */
+  void clear();
+
+  /**
+   * @brief Appends a box.
+   * @param min The minimum corner of the box.
+   * @param max The maximum corner of the box.
+   */
+  void push(const Point3D& min, const Point3D& max);
+
+  /**
+   * @brief Reserves memory for a number of boxes.
+   */
+  void reserve(std::size_t count);
+
+  /**
+   * @return The number of boxes.
+   */
+  auto size() const { return m_min[0].size(); }
+
+  /**
+   * @param axis 0 for x, 1 for y, 2 for z.
+   * @return The minimum coordinates of every box along the axis.
+   */
+  const GLfloat* min(std::size_t axis) const { return m_min[axis].data(); }
+
+  /**
+   * @param axis 0 for x, 1 for y, 2 for z.
+   * @return The maximum coordinates of every box along the axis.
+   */
+  const GLfloat* max(std::size_t axis) const { return m_max[axis].data(); }
+
+ private:
+
+  std::array<std::vector<GLfloat>, 3> m_min {};
+  std::array<std::vector<GLfloat>, 3> m_max {};
+};
+
+/**
+ * @brief The six planes of a view frustum, pointing inwards, as (normal, distance).
+ */
+class Frustum {
+
+ public:
+
+  Frustum() = default;
+
+  /**
+   * @brief Extracts the planes from a view projection matrix (Gribb & Hartmann).
+   *  cull_chunks.comp does the same on the GPU.
+   * @param view_projection The view projection matrix.
+   */
+  explicit Frustum(const glm::mat4& view_projection);
+
+  /**
+   * @brief Tests every box, with the widest SIMD kernel the build allows:
+   *  AVX2 when KETEMINE_AVX2 is on, SSE2 on x86 otherwise, scalar elsewhere.
+   *  Same results as intersects().
+   * @param boxes The boxes to test.
+   * @param visible Gets the indices of the boxes that may be visible, in order.
+   */
+  void cull(const AabbArray& boxes, std::vector<GLuint>& visible) const;
+
+  /**
+   * @brief The scalar kernel of cull(), for reference and comparison.
+   * @param boxes The boxes to test.
+   * @param visible Gets the indices of the boxes that may be visible, in order.
+   * @param first The index of the first box to test.
+   */
+  void cullScalar(const AabbArray& boxes, std::vector<GLuint>& visible, std::size_t first = 0) const;
+
+  /**
+   * @brief Tests an axis aligned box. It may return true for some boxes that
+   *  are outside but near a corner of the frustum, never false for a visible one.
+   * @param min The minimum corner of the box.
+   * @param max The maximum corner of the box.
+   * @return True if the box may be visible.
+   */
+  bool intersects(const Point3D& min, const Point3D& max) const;
+
+  /**
+   * @return The planes: left, right, bottom, top, near and far.
+   */
+  const auto& planes() const { return m_planes; }
+
+ private:
+
+  std::array<glm::vec4, 6> m_planes {};
+};
+
+namespace frustum {
+
+/**
+ * @brief Boxes culled per microsecond, see benchmark().
+ */
+struct Throughput {
+  GLdouble scalar_per_us {};
+  GLdouble simd_per_us {};
+  std::size_t boxes {};
+  std::size_t visible {};
+  // the SIMD kernel kept the same boxes as the scalar one
+  bool same {};
+};
+
+/**
+ * @brief Culls a grid of chunk sized boxes around a point many times, with
+ *  the scalar kernel and with the one Frustum::cull() picks.
+ * @param view_projection The view projection matrix.
+ * @param center The center of the grid, usually the camera position.
+ * @param count How many boxes, rounded down to a cube.
+ * @return The boxes per microsecond of each kernel.
+ */
+Throughput benchmark(const glm::mat4& view_projection, const Point3D& center, std::size_t count);
+
+/**
+ * @return The name of the kernel Frustum::cull() uses: AVX2, SSE2 or scalar.
+ */
+const char* kernel();
+
+} // namespace frustum
+
+} // namespace ktp
+
+#endif // KETEMINE_SRC_FRUSTUM_HPP_
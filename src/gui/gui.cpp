@@ -1,10 +1,24 @@
 #include "gui.hpp"
 
+#include "../camera.hpp"
+#include "../ecs.hpp"
+#include "../frustum.hpp"
+#include "../jobs.hpp"
+#include "../ketemine.hpp"
+#include "../light.hpp"
+#include "../mesher.hpp"
+#include "../noise.hpp"
+#include "../physics.hpp"
+#include "../raycast.hpp"
+#include "../region.hpp"
+#include "../renderer.hpp"
 #include "../resources.hpp"
+#include "../streaming.hpp"
 #include "../../lib/imgui/imgui.h"
 #include "../../lib/imgui/imgui_impl_glfw.h"
 #include "../../lib/imgui/imgui_impl_opengl3.h"
 #include "../../lib/imgui/imgui_stdlib.h"
+#include <glm/common.hpp>
 #include <iostream>
 
 void ktp::gui::clean() {
@@ -38,6 +52,17 @@ void ktp::gui::draw() {
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+void ktp::gui::entities() {
+  if (ImGui::TreeNode("Entities")) {
+    static ecs::Timing timing {};
+    if (ImGui::Button("Benchmark 100k entities")) timing = ecs::benchmark(100000, 60);
+    ImGui::Text("%zu entities in %zu archetypes, created in %.2f ms", timing.entities, timing.archetypes, timing.create_ms);
+    ImGui::Text("Tick: %.3f ms, parallel %.3f ms on %u workers", timing.tick_ms, timing.parallel_tick_ms, jobs::threadCount());
+    ImGui::Text("Virtual update per object: %.3f ms", timing.objects_tick_ms);
+    ImGui::TreePop();
+  }
+}
+
 void ktp::gui::mainWindow() {
   ImGui::Begin("keteMine");
   ImGui::Text("Average %.3f ms/frame (%.1f FPS)", 1000.f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
@@ -45,9 +70,117 @@ void ktp::gui::mainWindow() {
     shaders();
     textures();
   }
+  if (ImGui::CollapsingHeader("World", ImGuiTreeNodeFlags_DefaultOpen)) {
+    streaming();
+    renderer();
+    physics();
+    raycast();
+    noise();
+    entities();
+  }
   ImGui::End();
 }
 
+void ktp::gui::noise() {
+  if (ImGui::TreeNode("Noise")) {
+    static noise::Fractal fractal {};
+    static GLdouble samples_per_second[3] {};
+    auto type {static_cast<int>(fractal.type)};
+    ImGui::RadioButton("Perlin", &type, static_cast<int>(noise::Type::Perlin));
+    ImGui::SameLine();
+    ImGui::RadioButton("Simplex", &type, static_cast<int>(noise::Type::Simplex));
+    fractal.type = static_cast<noise::Type>(type);
+    ImGui::SliderInt("Octaves", &fractal.octaves, 1, 8);
+    ImGui::SliderFloat("Warp", &fractal.warp_amplitude, 0.f, 64.f, "%.0f blocks");
+    if (ImGui::Button("Benchmark")) {
+      for (int isa = 0; isa < 3; ++isa) {
+        const auto kernel {static_cast<noise::Isa>(isa)};
+        samples_per_second[isa] = noise::supported(kernel) ? noise::benchmark(fractal, kernel) : 0.0;
+      }
+    }
+    for (int isa = 0; isa < 3; ++isa) {
+      const auto kernel {static_cast<noise::Isa>(isa)};
+      if (!noise::supported(kernel)) {
+        ImGui::Text("%s: not in this build", noise::name(kernel));
+      } else {
+        ImGui::Text("%s: %.2f M samples/s", noise::name(kernel), samples_per_second[isa] / 1000000.0);
+      }
+    }
+    ImGui::TreePop();
+  }
+}
+
+void ktp::gui::physics() {
+  if (ImGui::TreeNode("Physics")) {
+    ImGui::Checkbox("Fly (F)", &keteMine::flying);
+    auto& settings {physics::settings};
+    ImGui::SliderFloat("Gravity", &settings.gravity, 0.f, 60.f);
+    ImGui::SliderFloat("Walk speed", &settings.walk_speed, 1.f, 20.f);
+    ImGui::SliderFloat("Jump speed", &settings.jump_speed, 0.f, 20.f);
+    ImGui::SliderFloat("Step height", &settings.step_height, 0.f, 1.f);
+    const auto& stats {physics::stats};
+    ImGui::Text("Tick: %.0f Hz, %zu ticks last frame, %.3f ms on the physics thread", 1.0 / static_cast<double>(physics::tick_time), stats.ticks, stats.tick_ms);
+    ImGui::Text("Drawn at %.2f between the last two ticks", static_cast<double>(stats.alpha));
+    const auto& body {physics::body()};
+    ImGui::Text("Position: %.2f, %.2f, %.2f", static_cast<double>(body.position.x), static_cast<double>(body.position.y), static_cast<double>(body.position.z));
+    ImGui::Text("Velocity: %.2f, %.2f, %.2f", static_cast<double>(body.velocity.x), static_cast<double>(body.velocity.y), static_cast<double>(body.velocity.z));
+    ImGui::TextUnformatted(body.on_ground ? "On the ground" : "In the air");
+    ImGui::TreePop();
+  }
+}
+
+void ktp::gui::raycast() {
+  if (ImGui::TreeNode("Raycast")) {
+    const auto& camera {keteMine::camera};
+    const auto hit {raycast::cast(keteMine::world, {camera.position(), camera.front(), keteMine::reach})};
+    if (hit.hit) {
+      ImGui::Text("Looking at block %u at %d, %d, %d, face %u, %.2f away", hit.id, hit.block.x, hit.block.y, hit.block.z, hit.face, static_cast<double>(hit.distance));
+    } else {
+      ImGui::Text("Looking at nothing");
+    }
+    ImGui::Text("Selected block: %u (1 to 9, 0 for the lamp)", keteMine::selected_block);
+    ImGui::Text("Left click breaks, middle click places");
+    static raycast::Throughput throughput {};
+    if (ImGui::Button("Benchmark")) throughput = raycast::benchmark(keteMine::world, camera.position(), 100000, 64.f);
+    ImGui::Text("%.2f M rays/s, batched %.2f M rays/s, %.0f%% hit", throughput.rays_per_second / 1e6, throughput.batched_rays_per_second / 1e6, throughput.hit_ratio * 100.0);
+    ImGui::TreePop();
+  }
+}
+
+void ktp::gui::renderer() {
+  if (ImGui::TreeNodeEx("Renderer", ImGuiTreeNodeFlags_DefaultOpen)) {
+    auto& settings {renderer::settings};
+    ImGui::Checkbox("Multi draw indirect", &settings.multi_draw);
+    ImGui::Checkbox("Cave culling", &settings.cave_culling);
+    auto culling {static_cast<int>(settings.culling)};
+    ImGui::Text("Frustum culling:");
+    ImGui::SameLine();
+    ImGui::RadioButton("None", &culling, static_cast<int>(renderer::Culling::None));
+    ImGui::SameLine();
+    ImGui::RadioButton("CPU", &culling, static_cast<int>(renderer::Culling::CPU));
+    ImGui::SameLine();
+    ImGui::RadioButton("GPU", &culling, static_cast<int>(renderer::Culling::GPU));
+    settings.culling = static_cast<renderer::Culling>(culling);
+    const auto& stats {renderer::stats};
+    ImGui::Text("Chunks skipped by cave culling: %zu", stats.cave_culled);
+    if (settings.multi_draw && settings.culling == renderer::Culling::GPU) {
+      ImGui::Text("Chunks: %zu tested on the GPU, %zu draw calls", stats.candidates, stats.draw_calls);
+    } else {
+      ImGui::Text("Chunks drawn: %zu of %zu in %zu draw calls", stats.chunks_drawn, stats.candidates, stats.draw_calls);
+    }
+    ImGui::Text("Submission: %.3f ms (culling %.3f ms)", stats.cpu_ms, stats.cull_ms);
+    static frustum::Throughput throughput {};
+    if (ImGui::Button("Benchmark frustum culling")) {
+      const auto& camera {keteMine::camera};
+      const auto aspect {static_cast<GLfloat>(keteMine::window_size.x) / static_cast<GLfloat>(glm::max(keteMine::window_size.y, 1))};
+      throughput = frustum::benchmark(camera.projection(aspect) * camera.view(), camera.position(), 32768);
+    }
+    ImGui::Text("Scalar: %.1f boxes/us  %s: %.1f boxes/us  (%zu of %zu visible%s)", throughput.scalar_per_us, frustum::kernel(),
+      throughput.simd_per_us, throughput.visible, throughput.boxes, throughput.same ? "" : ", kernels disagree!");
+    ImGui::TreePop();
+  }
+}
+
 void ktp::gui::shaders() {
   if (ImGui::TreeNode("Shaders")) {
     static int selected {0};
@@ -88,6 +221,13 @@ void ktp::gui::shaders() {
         ImGui::EndTabItem();
       }
       ImGui::EndDisabled();
+      bool compute_shader_missing {Resources::shader_programs[selected_name].compute == ""};
+      ImGui::BeginDisabled(compute_shader_missing);
+      if (ImGui::BeginTabItem("Compute shader")) {
+        ImGui::TextWrapped(Resources::shader_programs[selected_name].compute.c_str());
+        ImGui::EndTabItem();
+      }
+      ImGui::EndDisabled();
       ImGui::EndTabBar();
     }
     ImGui::EndChild();
@@ -102,8 +242,54 @@ void ktp::gui::shaders() {
   }
 }
 
+void ktp::gui::streaming() {
+  if (ImGui::TreeNodeEx("Streaming", ImGuiTreeNodeFlags_DefaultOpen)) {
+    auto& settings {streaming::settings};
+    ImGui::SliderInt("View distance", &settings.view_distance, 2, 32, "%d chunks");
+    ImGui::SliderInt("Full detail distance", &settings.lod_distance, 1, 32, "%d chunks");
+    ImGui::SliderInt("Uploads per frame", &settings.upload_budget, 1, 64);
+    ImGui::SliderInt("Jobs in flight", &settings.max_jobs_in_flight, 1, 256);
+    const auto& stats {streaming::stats};
+    ImGui::Text("Seed: %d", settings.seed);
+    ImGui::Text("Chunks loaded: %zu", stats.chunks_loaded);
+    ImGui::Text("Meshes on GPU: %zu (%zu vertices)", stats.meshes_on_gpu, stats.vertices);
+    ImGui::Text("Per level of detail: %zu / %zu / %zu / %zu", stats.lod_meshes[0], stats.lod_meshes[1], stats.lod_meshes[2], stats.lod_meshes[3]);
+    ImGui::Text("Generating: %zu  Meshing: %zu", stats.generating, stats.meshing);
+    ImGui::Text("Lighting: %zu (%zu updates waiting)", stats.lighting, stats.light_updates);
+    ImGui::Text("Pending uploads: %zu (%zu last frame)", stats.pending_uploads, stats.uploaded_last_frame);
+    ImGui::Text("Uploaded: %.1f KB last frame, staging stalls: %zu", static_cast<double>(stats.uploaded_bytes_last_frame) / 1024.0, stats.staging_stalls);
+    const auto arena {streaming::arena().stats()};
+    constexpr double megabyte {1024.0 * 1024.0};
+    ImGui::Text("Vertex arena: %.1f / %.1f MB in %zu meshes", static_cast<double>(arena.used) / megabyte, static_cast<double>(arena.capacity) / megabyte, arena.allocations);
+    ImGui::Text("Fragmentation: %.0f%% (%zu free ranges)", static_cast<double>(arena.fragmentation) * 100.0, arena.free_ranges);
+    if (ImGui::Button("Defragment")) streaming::defragment();
+    ImGui::Text("Storage: %zu chunks loaded, %zu saved (%.1f KB), %zu pending", stats.storage.loaded, stats.storage.saved, static_cast<double>(stats.storage.bytes_written) / 1024.0, stats.storage.pending);
+    static region::Throughput throughput {};
+    if (ImGui::Button("Benchmark storage")) {
+      throughput = region::benchmark(std::filesystem::temp_directory_path() / "ketemine_region_benchmark", keteMine::world, 4096);
+    }
+    ImGui::Text("Save: %.0f chunks/s  Load: %.0f chunks/s  (%.0f bytes/chunk)", throughput.saved_per_second, throughput.loaded_per_second, throughput.bytes_per_chunk);
+    static light::Timing light_timing {};
+    if (ImGui::Button("Benchmark lighting")) light_timing = light::benchmark(64);
+    ImGui::Text("Lamp placed: %.3f ms  removed: %.3f ms  (%zu blocks)", light_timing.place_ms, light_timing.remove_ms, light_timing.blocks);
+    static mesher::Timing mesher_timing {};
+    if (ImGui::Button("Benchmark meshing")) mesher_timing = mesher::benchmark(keteMine::world, 512);
+    ImGui::Text("Flat: %.3f ms/chunk (%zu quads)", mesher_timing.flat_ms, mesher_timing.flat_quads);
+    ImGui::Text("AO and smooth light: %.3f ms/chunk (%zu quads)", mesher_timing.shaded_ms, mesher_timing.shaded_quads);
+    ImGui::TreePop();
+  }
+}
+
 void ktp::gui::textures() {
   if (ImGui::TreeNode("Textures")) {
     ImGui::TreePop();
   }
 }
+
+bool ktp::gui::wantsKeyboard() {
+  return ImGui::GetIO().WantCaptureKeyboard;
+}
+
+bool ktp::gui::wantsMouse() {
+  return ImGui::GetIO().WantCaptureMouse;
+}
@@ -20,10 +20,28 @@ void clean();
 void draw();
 void init(GLFWwindow* window);
 
+void entities();
 void mainWindow();
+void noise();
+void physics();
+void raycast();
+void renderer();
 void shaders();
+void streaming();
 void textures();
 
+/**
+ * @return True if a text field of the GUI has the focus, its keys aren't
+ *  for the world then.
+ */
+bool wantsKeyboard();
+
+/**
+ * @return True if the mouse is over a window of the GUI, its clicks aren't
+ *  for the world then.
+ */
+bool wantsMouse();
+
 } } // namespace gui/ktp
 
 #endif // KETEMINE_SRC_GUI_GUI_HPP_
@@ -0,0 +1,191 @@
+#include "jobs.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+
+namespace {
+
+/**
+ * @brief A double ended queue of jobs. The owner pushes and pops at the back,
+ *  thieves steal from the front, so the oldest (usually biggest) jobs are
+ *  the ones that move between threads.
+ */
+struct WorkQueue {
+
+  void push(ktp::jobs::Job&& job) {
+    std::scoped_lock lock {mutex};
+    jobs.push_back(std::move(job));
+  }
+
+  bool pop(ktp::jobs::Job& job) {
+    std::scoped_lock lock {mutex};
+    if (jobs.empty()) return false;
+    job = std::move(jobs.back());
+    jobs.pop_back();
+    return true;
+  }
+
+  bool steal(ktp::jobs::Job& job) {
+    std::scoped_lock lock {mutex};
+    if (jobs.empty()) return false;
+    job = std::move(jobs.front());
+    jobs.pop_front();
+    return true;
+  }
+
+  std::mutex mutex {};
+  std::deque<ktp::jobs::Job> jobs {};
+};
+
+std::vector<std::unique_ptr<WorkQueue>> mainQueue() {
+  std::vector<std::unique_ptr<WorkQueue>> main_queue {};
+  main_queue.push_back(std::make_unique<WorkQueue>());
+  return main_queue;
+}
+
+// queue 0 belongs to the main thread, 1..n to the workers. Without workers
+// the jobs wait in queue 0 until someone calls wait() or tryRunOne()
+std::vector<std::unique_ptr<WorkQueue>> queues {mainQueue()};
+std::vector<std::thread> workers {};
+std::atomic<bool> running {false};
+// jobs pushed but not yet taken, used to put idle workers to sleep
+std::atomic<std::size_t> queued {0};
+std::atomic<std::size_t> next_queue {0};
+std::mutex sleep_mutex {};
+std::condition_variable sleep_condition {};
+
+// the queue owned by the current thread, -1 for threads outside the system
+thread_local int thread_index {-1};
+
+void push(ktp::jobs::Job&& job) {
+  const auto index {thread_index >= 0
+    ? static_cast<std::size_t>(thread_index)
+    : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size()};
+  queues[index]->push(std::move(job));
+  queued.fetch_add(1, std::memory_order_release);
+  // a worker checking the sleep condition must not miss this job
+  { std::scoped_lock lock {sleep_mutex}; }
+  sleep_condition.notify_one();
+}
+
+bool take(ktp::jobs::Job& job) {
+  if (queued.load(std::memory_order_acquire) == 0) return false;
+  const auto count {queues.size()};
+  const auto own {thread_index >= 0 ? static_cast<std::size_t>(thread_index) : 0};
+  if (thread_index >= 0 && queues[own]->pop(job)) {
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  for (std::size_t i = 1; i <= count; ++i) {
+    if (queues[(own + i) % count]->steal(job)) {
+      queued.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void workerLoop(int index) {
+  thread_index = index;
+  while (running.load(std::memory_order_acquire)) {
+    if (ktp::jobs::tryRunOne()) continue;
+    std::unique_lock lock {sleep_mutex};
+    sleep_condition.wait(lock, [] {
+      return queued.load(std::memory_order_acquire) > 0 || !running.load(std::memory_order_acquire);
+    });
+  }
+}
+
+} // namespace
+
+/* Counter */
+
+bool ktp::jobs::Counter::addContinuation(Job&& job) {
+  std::scoped_lock lock {m_mutex};
+  if (m_pending.load(std::memory_order_relaxed) == 0) return false;
+  m_continuations.push_back(std::move(job));
+  return true;
+}
+
+void ktp::jobs::Counter::decrement() {
+  std::vector<Job> continuations {};
+  {
+    std::scoped_lock lock {m_mutex};
+    if (m_pending.fetch_sub(1, std::memory_order_release) == 1) continuations.swap(m_continuations);
+  }
+  // the counter may be gone by now
+  for (auto& job: continuations) push(std::move(job));
+}
+
+void ktp::jobs::Counter::increment() {
+  std::scoped_lock lock {m_mutex};
+  m_pending.fetch_add(1, std::memory_order_relaxed);
+}
+
+/* jobs */
+
+void ktp::jobs::init(unsigned int thread_count) {
+  if (running.exchange(true)) return;
+  if (thread_count == 0) thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1u;
+  thread_index = 0;
+  for (unsigned int i = 1; i <= thread_count; ++i) queues.push_back(std::make_unique<WorkQueue>());
+  for (unsigned int i = 1; i <= thread_count; ++i) workers.emplace_back(workerLoop, static_cast<int>(i));
+}
+
+void ktp::jobs::parallelFor(std::size_t count, std::size_t batch_size, const std::function<void(std::size_t, std::size_t)>& body) {
+  if (count == 0) return;
+  batch_size = std::max(batch_size, std::size_t{1});
+  Counter counter {};
+  for (std::size_t begin = 0; begin < count; begin += batch_size) {
+    const auto end {std::min(begin + batch_size, count)};
+    run([&body, begin, end] { body(begin, end); }, &counter);
+  }
+  wait(counter);
+}
+
+void ktp::jobs::run(Task task, Counter* counter) {
+  if (counter) counter->increment();
+  push({std::move(task), counter});
+}
+
+void ktp::jobs::runAfter(Counter& dependency, Task task, Counter* counter) {
+  if (counter) counter->increment();
+  Job job {std::move(task), counter};
+  if (!dependency.addContinuation(std::move(job))) push(std::move(job));
+}
+
+void ktp::jobs::shutdown() {
+  if (!running.exchange(false)) return;
+  {
+    std::scoped_lock lock {sleep_mutex};
+    sleep_condition.notify_all();
+  }
+  for (auto& worker: workers) worker.join();
+  workers.clear();
+  queues = mainQueue();
+  queued = 0;
+}
+
+unsigned int ktp::jobs::threadCount() {
+  return static_cast<unsigned int>(workers.size());
+}
+
+bool ktp::jobs::tryRunOne() {
+  Job job {};
+  if (!take(job)) return false;
+  job.task();
+  if (job.counter) job.counter->decrement();
+  return true;
+}
+
+void ktp::jobs::wait(const Counter& counter) {
+  // help while waiting
+  while (!counter.done()) {
+    if (!tryRunOne()) std::this_thread::yield();
+  }
+  // the last decrement() may still hold the lock, the counter can't die until it's done
+  std::scoped_lock lock {counter.m_mutex};
+}
@@ -0,0 +1,140 @@
+/**
+ * @file jobs.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief A work stealing job system.
+ * @version 0.1
+ * @date 2022-11-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_JOBS_HPP_)
+#define KETEMINE_SRC_JOBS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace ktp { namespace jobs {
+
+using Task = std::function<void()>;
+
+class Counter;
+
+/**
+ * @brief A task plus the counter to decrement when it's done.
+ */
+struct Job {
+  Task task {};
+  Counter* counter {nullptr};
+};
+
+/**
+ * @brief Counts the jobs still pending. Use it to wait for a group of jobs
+ *  or to run jobs after a group of jobs. Must outlive the jobs using it.
+ */
+class Counter {
+
+ public:
+
+  Counter() = default;
+  Counter(const Counter& other) = delete;
+  Counter& operator=(const Counter& other) = delete;
+
+  /**
+   * @return True if there are no jobs pending.
+   */
+  bool done() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+  /**
+   * @return The number of jobs pending.
+   */
+  auto pending() const { return m_pending.load(std::memory_order_acquire); }
+
+ private:
+
+  friend void run(Task task, Counter* counter);
+  friend void runAfter(Counter& dependency, Task task, Counter* counter);
+  friend bool tryRunOne();
+  friend void wait(const Counter& counter);
+
+  /**
+   * @brief Queues a job to be scheduled when the counter reaches 0.
+   * @return False if the counter is already 0, so the job must be scheduled now.
+   */
+  bool addContinuation(Job&& job);
+
+  /**
+   * @brief Marks one job as done, scheduling the continuations if it was the last one.
+   */
+  void decrement();
+
+  /**
+   * @brief Adds one pending job.
+   */
+  void increment();
+
+  // read without locking by done(), only written with m_mutex locked
+  std::atomic<int> m_pending {0};
+  mutable std::mutex m_mutex {};
+  std::vector<Job> m_continuations {};
+};
+
+/**
+ * @brief Starts the worker threads. Must be called from the main thread.
+ * @param thread_count The number of workers. 0 means one per core minus the main thread.
+ */
+void init(unsigned int thread_count = 0);
+
+/**
+ * @brief Runs every batch of [0, count) in parallel and waits for all of them.
+ * @param count The number of items.
+ * @param batch_size The number of items of every job.
+ * @param body Called with the [begin, end) range of every batch.
+ */
+void parallelFor(std::size_t count, std::size_t batch_size, const std::function<void(std::size_t, std::size_t)>& body);
+
+/**
+ * @brief Schedules a job. Callable from any thread.
+ * @param task The function to run.
+ * @param counter Optional counter, incremented now and decremented when the task is done.
+ */
+void run(Task task, Counter* counter = nullptr);
+
+/**
+ * @brief Schedules a job that starts when the dependency has no jobs pending.
+ * @param dependency The counter to wait for.
+ * @param task The function to run.
+ * @param counter Optional counter, incremented now and decremented when the task is done.
+ */
+void runAfter(Counter& dependency, Task task, Counter* counter = nullptr);
+
+/**
+ * @brief Stops and joins the worker threads. Pending jobs are discarded.
+ */
+void shutdown();
+
+/**
+ * @return The number of worker threads, not counting the main thread.
+ */
+unsigned int threadCount();
+
+/**
+ * @brief Runs one pending job on the calling thread, if any.
+ * @return True if a job was run.
+ */
+bool tryRunOne();
+
+/**
+ * @brief Waits until the counter has no jobs pending, running other jobs
+ *  on the calling thread meanwhile.
+ * @param counter The counter to wait for.
+ */
+void wait(const Counter& counter);
+
+} } // namespace jobs/ktp
+
+#endif // KETEMINE_SRC_JOBS_HPP_
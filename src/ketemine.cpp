@@ -1,14 +1,28 @@
 #include "ketemine.hpp"
 
+#include "camera.hpp"
+#include "jobs.hpp"
 #include "opengl.hpp"
+#include "physics.hpp"
+#include "raycast.hpp"
+#include "renderer.hpp"
 #include "resources.hpp"
+#include "streaming.hpp"
+#include "uniforms.hpp"
+#include "world.hpp"
 #include "gui/gui.hpp"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 #include <iostream>
 
+ktp::Camera ktp::keteMine::camera {{0.f, 60.f, 0.f}, 45.f, -20.f};
+bool ktp::keteMine::flying {false};
+ktp::BlockID ktp::keteMine::selected_block {ktp::Blocks::stone};
 GLFWwindow* ktp::keteMine::window {nullptr};
 ktp::Size2D ktp::keteMine::window_size {1920, 1080};
+ktp::World ktp::keteMine::world {};
 
 // CALLBACKS
 
@@ -23,6 +37,22 @@ void framebufferSizeCallback(GLFWwindow* window, int width, int height) {
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mode) {
   if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     glfwSetWindowShouldClose(window, GL_TRUE);
+  // the rest, picking blocks and F to fly, are typed into the GUI while one
+  // of its fields has the focus
+  if (ktp::gui::wantsKeyboard()) return;
+  // 1 to 9 pick the blocks with those ids, 0 the lamp
+  if (key >= GLFW_KEY_1 && key <= GLFW_KEY_9 && action == GLFW_PRESS)
+    ktp::keteMine::selected_block = static_cast<ktp::BlockID>(key - GLFW_KEY_0);
+  if (key == GLFW_KEY_0 && action == GLFW_PRESS)
+    ktp::keteMine::selected_block = ktp::Blocks::lamp;
+  if (key == GLFW_KEY_F && action == GLFW_PRESS)
+    ktp::keteMine::flying = !ktp::keteMine::flying;
+}
+
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+  if (action != GLFW_PRESS || ktp::gui::wantsMouse()) return;
+  if (button == GLFW_MOUSE_BUTTON_LEFT) ktp::keteMine::interact(false);
+  else if (button == GLFW_MOUSE_BUTTON_MIDDLE) ktp::keteMine::interact(true);
 }
 
 void windowSizeCallback(GLFWwindow* window, int width, int height) {
@@ -100,6 +130,7 @@ void ktp::keteMine::init() {
   // callbacks
   glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
   glfwSetKeyCallback(window, keyCallback);
+  glfwSetMouseButtonCallback(window, mouseButtonCallback);
   glfwSetWindowSizeCallback(window, windowSizeCallback);
   // GLEW
   glewExperimental = GL_TRUE;
@@ -111,6 +142,9 @@ void ktp::keteMine::init() {
 
   versionInfo();
 
+  jobs::init();
+  std::cout << "Job system running " << jobs::threadCount() << " worker threads\n";
+
   gui::init(window);
 
   contextInfo();
@@ -118,43 +152,132 @@ void ktp::keteMine::init() {
   Resources::loadResources();
 }
 
+void ktp::keteMine::interact(bool place) {
+  const auto hit {raycast::cast(world, {camera.position(), camera.front(), reach})};
+  if (!hit.hit) return;
+  if (!place) {
+    streaming::setBlock(world, hit.block.x, hit.block.y, hit.block.z, Blocks::air);
+    return;
+  }
+  const auto target {raycast::adjacent(hit)};
+  // not inside the player
+  const auto box {physics::bounds(physics::body())};
+  const Point3D low {target};
+  const auto overlap {[&box, &low](int axis) { return box.min[axis] < low[axis] + 1.f && box.max[axis] > low[axis]; }};
+  if (overlap(0) && overlap(1) && overlap(2)) return;
+  streaming::setBlock(world, target.x, target.y, target.z, selected_block);
+}
+
+ktp::physics::Input ktp::keteMine::processInput(GLfloat delta_time) {
+  constexpr GLfloat speed {20.f};
+  constexpr GLfloat mouse_sensitivity {0.1f};
+  // keys typed into a field of the GUI don't move the player, the input is
+  // left neutral
+  const bool keyboard {!gui::wantsKeyboard()};
+  const auto pressed {[keyboard](int key) { return keyboard && glfwGetKey(window, key) == GLFW_PRESS; }};
+  GLfloat forward {}, right {}, up {};
+  if (pressed(GLFW_KEY_W)) forward += 1.f;
+  if (pressed(GLFW_KEY_S)) forward -= 1.f;
+  if (pressed(GLFW_KEY_D)) right += 1.f;
+  if (pressed(GLFW_KEY_A)) right -= 1.f;
+  if (pressed(GLFW_KEY_SPACE)) up += 1.f;
+  if (pressed(GLFW_KEY_LEFT_SHIFT)) up -= 1.f;
+  physics::Input input {};
+  if (flying) {
+    const auto distance {speed * delta_time};
+    camera.move(forward * distance, right * distance, up * distance);
+  } else {
+    // walks on the ground whatever the pitch
+    auto front {camera.front()};
+    front.y = 0.f;
+    if (glm::length(front) > 0.f) {
+      front = glm::normalize(front);
+      const Vector3 side {-front.z, 0.f, front.x};
+      const auto walk {front * forward + side * right};
+      if (glm::length(walk) > 0.f) input.walk = glm::normalize(walk) * physics::settings.walk_speed;
+    }
+    input.jump = up > 0.f;
+  }
+  // mouse look, not while dragging over the GUI
+  static bool looking {false};
+  static double last_x {}, last_y {};
+  double x {}, y {};
+  glfwGetCursorPos(window, &x, &y);
+  if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS && !gui::wantsMouse()) {
+    if (looking) {
+      camera.rotate(static_cast<GLfloat>(x - last_x) * mouse_sensitivity, static_cast<GLfloat>(last_y - y) * mouse_sensitivity);
+    }
+    looking = true;
+  } else {
+    looking = false;
+  }
+  last_x = x;
+  last_y = y;
+  return input;
+}
+
 void ktp::keteMine::run() {
-  FloatArray points {
-     0.0f,  0.5f,  0.0f,
-     0.5f, -0.5f,  0.0f,
-    -0.5f, -0.5f,  0.0f
-  };
-  VBO vbo_points {};
-  vbo_points.setup(points, GL_STATIC_DRAW);
+  streaming::init();
+  physics::init();
 
-  FloatArray colors {
-    1.0f, 0.0f, 0.0f,
-    0.0f, 1.0f, 0.0f,
-    0.0f, 0.0f, 1.0f
-  };
-  VBO vbo_colors {};
-  vbo_colors.setup(colors, GL_STATIC_DRAW);
+  renderer::init();
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
 
-  VAO vao {};
-  vao.linkAttrib(vbo_points, 0, 3, GL_FLOAT, 0, nullptr);
-  vao.linkAttrib(vbo_colors, 1, 3, GL_FLOAT, 0, nullptr);
+  // the per frame constants, shared by every program
+  UBO frame_ubo {};
+  frame_ubo.setup(nullptr, sizeof(uniforms::Frame));
+  frame_ubo.bindBase(uniforms::frame_binding);
+  uniforms::Frame frame {};
 
-  ShaderProgram shader {Resources::getShaderProgram("interpolation")};;
+  const Vector3 eye {0.f, eye_height, 0.f};
+  physics::teleport(camera.position() - eye);
 
+  const auto start_time {glfwGetTime()};
+  auto last_time {start_time};
   while (!glfwWindowShouldClose(window)) {
+    // the physics ticks of the last frame read the world, it can't change
+    // until they are done
+    physics::sync();
     glfwPollEvents();
 
-    glClear(GL_COLOR_BUFFER_BIT);
+    const auto now {glfwGetTime()};
+    const auto delta_time {static_cast<GLfloat>(now - last_time)};
+    const auto input {processInput(delta_time)};
+    last_time = now;
+
+    streaming::update(world, camera.position());
+
+    if (flying) {
+      physics::teleport(camera.position() - eye);
+    } else {
+      // they run while the frame is drawn
+      physics::update(world, input, delta_time);
+      camera.setPosition(physics::position() + eye);
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glViewport(0, 0, window_size.x, window_size.y);
 
-    shader.use();
-    vao.bind();
-    glDrawArrays(GL_TRIANGLES, 0, 3);
+    const auto aspect {static_cast<GLfloat>(window_size.x) / static_cast<GLfloat>(glm::max(window_size.y, 1))};
+    frame.view = camera.view();
+    frame.projection = camera.projection(aspect);
+    frame.view_projection = frame.projection * frame.view;
+    frame.camera_position = glm::vec4(camera.position(), 1.f);
+    frame.time = {static_cast<GLfloat>(now - start_time), delta_time, 0.f, 0.f};
+    frame_ubo.setupSubData(frame);
+
+    renderer::drawChunks(frame.view_projection, camera.position());
 
     gui::draw();
 
     glfwSwapBuffers(window);
   }
+  physics::shutdown();
+  renderer::clean();
+  streaming::save(world);
+  streaming::clean();
+  jobs::shutdown();
   gui::clean();
   glfwDestroyWindow(window);
   glfwTerminate();
@@ -12,17 +12,43 @@
 #if !defined(KETEMINE_SRC_KETEMINE_HPP_)
 #define KETEMINE_SRC_KETEMINE_HPP_
 
+#include "physics.hpp"
 #include "types.hpp"
 
 namespace ktp { namespace keteMine {
 
 void contextInfo();
 void init();
+/**
+ * @brief Casts a ray from the camera and breaks the block it hits, or
+ *  places the selected block against the face it hits.
+ * @param place True to place, false to break.
+ */
+void interact(bool place);
+/**
+ * @brief Looks around while the right mouse button is pressed. Flying, moves
+ *  the camera with WASD, space and shift. Walking, WASD and space are what
+ *  the player does during the next physics ticks.
+ * @param delta_time Seconds since the last frame.
+ * @return The input for the physics ticks.
+ */
+physics::Input processInput(GLfloat delta_time);
 void run();
 void versionInfo();
 
+// of the camera over the feet of the player
+constexpr GLfloat eye_height {1.62f};
+// blocks further than it can't be reached
+constexpr GLfloat reach {8.f};
+
+extern Camera camera;
+// the camera goes through blocks, without physics. Toggled with F
+extern bool flying;
+// placed by interact(), chosen with the number keys
+extern BlockID selected_block;
 extern GLFWwindow* window;
 extern Size2D window_size;
+extern World world;
 
 } } // namespace keteMine / ktp
 
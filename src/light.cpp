@@ -0,0 +1,313 @@
+#include "light.hpp"
+
+#include "jobs.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <tuple>
+
+namespace {
+
+using namespace ktp;
+
+struct Direction {
+  GLint x, y, z;
+};
+
+constexpr std::array<Direction, 6> directions {{
+  { 1,  0,  0},
+  {-1,  0,  0},
+  { 0,  1,  0},
+  { 0, -1,  0},
+  { 0,  0,  1},
+  { 0,  0, -1}
+}};
+constexpr std::size_t down {3};
+
+// skylight at its full level falls straight down without fading
+std::uint8_t received(LightChannel channel, std::size_t direction, std::uint8_t level) {
+  if (channel == LightChannel::Sky && direction == down && level == light::max_level) return level;
+  return level > 0 ? static_cast<std::uint8_t>(level - 1) : std::uint8_t{0};
+}
+
+// what's left of the level a block receives once it went through it
+std::uint8_t absorbed(BlockID block, std::uint8_t level) {
+  const auto absorption {light::absorption(block)};
+  return level > absorption ? static_cast<std::uint8_t>(level - absorption) : std::uint8_t{0};
+}
+
+struct Removal {
+  GLuint index;
+  // the level the block had
+  std::uint8_t level;
+};
+
+std::size_t solve(const ChunkPos& pos, const Chunk& chunk, ChunkLight& light, LightChannel channel, const std::vector<light::Update>& updates, std::vector<light::Handoff>& handoffs, bool spread) {
+  // both queues only grow, the heads walk them
+  std::vector<Removal> removals {};
+  std::vector<GLuint> spreads {};
+  std::size_t changed {};
+
+  const auto kept {[&](GLuint index) {
+    return channel == LightChannel::Block ? light::emission(chunk.get(index)) : std::uint8_t{0};
+  }};
+  // a neighbour that may be the source of the block lost its light
+  const auto lower {[&](GLuint index, std::uint8_t level) {
+    const auto current {light.get(channel, index)};
+    if (current == 0) return;
+    if (current <= absorbed(chunk.get(index), level)) {
+      const auto emitted {kept(index)};
+      light.set(channel, index, emitted);
+      ++changed;
+      removals.push_back({index, current});
+      if (emitted > 0) spreads.push_back(index);
+    } else {
+      // lit by something else, it fills the hole back
+      spreads.push_back(index);
+    }
+  }};
+  const auto raise {[&](GLuint index, std::uint8_t level) {
+    const auto lit {absorbed(chunk.get(index), level)};
+    if (lit <= light.get(channel, index)) return;
+    light.set(channel, index, lit);
+    ++changed;
+    spreads.push_back(index);
+  }};
+
+  for (const auto& update: updates) {
+    if (update.channel != channel) continue;
+    switch (update.kind) {
+      case light::Kind::Propagate: raise(update.index, update.level); break;
+      case light::Kind::Remove: lower(update.index, update.level); break;
+      case light::Kind::Clear: {
+        const auto old_level {light.get(channel, update.index)};
+        const auto emitted {kept(update.index)};
+        if (old_level == emitted) break;
+        light.set(channel, update.index, emitted);
+        ++changed;
+        // a brighter lamp simply spreads over the old light
+        if (emitted < old_level) removals.push_back({update.index, old_level});
+        if (emitted > 0) spreads.push_back(update.index);
+        break;
+      }
+      case light::Kind::Spread: spreads.push_back(update.index); break;
+    }
+  }
+
+  // calls visit(direction, index) for the neighbours inside the chunk and
+  // outside(direction, neighbour position, index) for the ones across the border
+  const auto neighbours {[&pos](GLuint index, const auto& visit, const auto& outside) {
+    const auto x {static_cast<GLint>(index & 15u)};
+    const auto z {static_cast<GLint>((index >> 4) & 15u)};
+    const auto y {static_cast<GLint>(index >> 8)};
+    for (std::size_t d = 0; d < directions.size(); ++d) {
+      const auto nx {x + directions[d].x}, ny {y + directions[d].y}, nz {z + directions[d].z};
+      const auto neighbour {Chunk::index(nx & 15, ny & 15, nz & 15)};
+      if (((nx | ny | nz) & ~15) == 0) {
+        visit(d, neighbour);
+      } else {
+        outside(d, ChunkPos{pos.x + directions[d].x, pos.y + directions[d].y, pos.z + directions[d].z}, neighbour);
+      }
+    }
+  }};
+
+  for (std::size_t head = 0; head < removals.size(); ++head) {
+    const auto removal {removals[head]};
+    neighbours(removal.index,
+      [&](std::size_t d, GLuint neighbour) { lower(neighbour, received(channel, d, removal.level)); },
+      [&](std::size_t d, const ChunkPos& neighbour_pos, GLuint neighbour) {
+        handoffs.push_back({neighbour_pos, {neighbour, received(channel, d, removal.level), channel, light::Kind::Remove}});
+      });
+  }
+  if (!spread) {
+    for (const auto index: spreads) handoffs.push_back({pos, {index, 0, channel, light::Kind::Spread}});
+    return changed;
+  }
+  for (std::size_t head = 0; head < spreads.size(); ++head) {
+    const auto level {light.get(channel, spreads[head])};
+    if (level == 0) continue;
+    neighbours(spreads[head],
+      [&](std::size_t d, GLuint neighbour) { raise(neighbour, received(channel, d, level)); },
+      [&](std::size_t d, const ChunkPos& neighbour_pos, GLuint neighbour) {
+        const auto neighbour_level {received(channel, d, level)};
+        if (neighbour_level > 0) handoffs.push_back({neighbour_pos, {neighbour, neighbour_level, channel, light::Kind::Propagate}});
+      });
+  }
+  return changed;
+}
+
+} // namespace
+
+std::uint8_t ktp::light::absorption(BlockID block) {
+  switch (block) {
+    case Blocks::air:   return 0;
+    case Blocks::water: return 2;
+    default:            return max_level;
+  }
+}
+
+ktp::light::Timing ktp::light::benchmark(std::size_t iterations) {
+  // 3x3x3 chunks of air, the lamp at the corner shared by the 8 chunks around (1, 1, 1)
+  World world {};
+  for (GLint y = 0; y < 3; ++y) {
+    for (GLint z = 0; z < 3; ++z) {
+      for (GLint x = 0; x < 3; ++x) {
+        world.insertChunk({x, y, z}, Chunk{Blocks::air});
+        world.insertLight({x, y, z}, ChunkLight{});
+      }
+    }
+  }
+  constexpr GLint corner {2 * Chunk::size - 1};
+  const auto pos {World::chunkPosition(corner, corner, corner)};
+  const auto index {Chunk::index(World::localCoord(corner), World::localCoord(corner), World::localCoord(corner))};
+
+  Timing timing {};
+  std::vector<Handoff> handoffs {};
+  const auto relightTo {[&](BlockID block) {
+    world.setBlock(corner, corner, corner, block);
+    handoffs.clear();
+    changed(pos, index, false, handoffs);
+    const auto start {std::chrono::steady_clock::now()};
+    const auto blocks {relight(world, handoffs)};
+    const std::chrono::duration<GLdouble, std::milli> elapsed {std::chrono::steady_clock::now() - start};
+    return std::make_pair(elapsed.count(), blocks);
+  }};
+  for (std::size_t i = 0; i < iterations; ++i) {
+    const auto [place_ms, blocks] {relightTo(Blocks::lamp)};
+    const auto [remove_ms, removed] {relightTo(Blocks::air)};
+    timing.place_ms += place_ms;
+    timing.remove_ms += remove_ms;
+    timing.blocks = blocks;
+  }
+  if (iterations > 0) {
+    timing.place_ms /= static_cast<GLdouble>(iterations);
+    timing.remove_ms /= static_cast<GLdouble>(iterations);
+  }
+  return timing;
+}
+
+void ktp::light::border(const ChunkLight& light, const ChunkPos& from, const ChunkPos& to, std::vector<Update>& updates) {
+  const auto offset {to - from};
+  const auto direction {static_cast<std::size_t>(std::find_if(directions.begin(), directions.end(), [&offset](const auto& d) {
+    return d.x == offset.x && d.y == offset.y && d.z == offset.z;
+  }) - directions.begin())};
+  if (direction == directions.size()) return;
+  // (u, v) walks the shared face, the layer of the neighbour touching the
+  // chunk is on one side of it and the one of the chunk on the other
+  const auto last {Chunk::size - 1};
+  const auto at {[&offset](GLint u, GLint v, GLint layer) {
+    if (offset.x != 0) return Chunk::index(layer, u, v);
+    if (offset.y != 0) return Chunk::index(u, layer, v);
+    return Chunk::index(u, v, layer);
+  }};
+  const auto facing {(offset.x + offset.y + offset.z) > 0};
+  for (GLint v = 0; v < Chunk::size; ++v) {
+    for (GLint u = 0; u < Chunk::size; ++u) {
+      const auto source {at(u, v, facing ? last : 0)};
+      const auto target {at(u, v, facing ? 0 : last)};
+      for (const auto channel: {LightChannel::Sky, LightChannel::Block}) {
+        const auto level {received(channel, direction, light.get(channel, source))};
+        if (level > 0) updates.push_back({target, level, channel, Kind::Propagate});
+      }
+    }
+  }
+}
+
+void ktp::light::changed(const ChunkPos& pos, GLuint index, bool open_sky, std::vector<Handoff>& handoffs) {
+  const auto x {static_cast<GLint>(index & 15u)};
+  const auto z {static_cast<GLint>((index >> 4) & 15u)};
+  const auto y {static_cast<GLint>(index >> 8)};
+  for (const auto channel: {LightChannel::Sky, LightChannel::Block}) {
+    handoffs.push_back({pos, {index, 0, channel, Kind::Clear}});
+    // the neighbours light it again if it let light through now
+    for (const auto& d: directions) {
+      const auto nx {x + d.x}, ny {y + d.y}, nz {z + d.z};
+      ChunkPos neighbour_pos {pos};
+      if (((nx | ny | nz) & ~15) != 0) neighbour_pos += ChunkPos{d.x, d.y, d.z};
+      handoffs.push_back({neighbour_pos, {Chunk::index(nx & 15, ny & 15, nz & 15), 0, channel, Kind::Spread}});
+    }
+  }
+  if (open_sky) handoffs.push_back({pos, {index, max_level, LightChannel::Sky, Kind::Propagate}});
+}
+
+std::uint8_t ktp::light::emission(BlockID block) {
+  return block == Blocks::lamp ? max_level : std::uint8_t{0};
+}
+
+std::size_t ktp::light::propagate(const ChunkPos& pos, const Chunk& chunk, ChunkLight& light, const std::vector<Update>& updates, std::vector<Handoff>& handoffs, bool spread) {
+  return solve(pos, chunk, light, LightChannel::Sky, updates, handoffs, spread)
+       + solve(pos, chunk, light, LightChannel::Block, updates, handoffs, spread);
+}
+
+std::size_t ktp::light::relight(World& world, std::vector<Handoff> handoffs) {
+  struct Batch {
+    ChunkPos pos;
+    const Chunk* chunk;
+    ChunkLight* light;
+    std::vector<Update> updates;
+    std::vector<Handoff> handoffs;
+    std::size_t changed;
+  };
+  const auto removing {[](const Handoff& handoff) {
+    return handoff.update.kind == Kind::Remove || handoff.update.kind == Kind::Clear;
+  }};
+  std::vector<Batch> batches {};
+  // spreading while the light is still being removed in another chunk lights
+  // the hole from light that is about to go dark, so every removal is done
+  // before anything spreads, as propagate() does inside a chunk
+  std::vector<Handoff> deferred {};
+  std::size_t changed {};
+  while (!handoffs.empty() || !deferred.empty()) {
+    const auto removal {std::any_of(handoffs.begin(), handoffs.end(), removing)};
+    if (removal) {
+      const auto first_spread {std::stable_partition(handoffs.begin(), handoffs.end(), removing)};
+      deferred.insert(deferred.end(), std::make_move_iterator(first_spread), std::make_move_iterator(handoffs.end()));
+      handoffs.erase(first_spread, handoffs.end());
+    } else {
+      handoffs.insert(handoffs.end(), deferred.begin(), deferred.end());
+      deferred.clear();
+    }
+    // the updates of every chunk together, in the order they were made
+    std::stable_sort(handoffs.begin(), handoffs.end(), [](const Handoff& a, const Handoff& b) {
+      return std::tie(a.pos.x, a.pos.y, a.pos.z) < std::tie(b.pos.x, b.pos.y, b.pos.z);
+    });
+    batches.clear();
+    for (const auto& handoff: handoffs) {
+      if (batches.empty() || batches.back().pos != handoff.pos) {
+        const auto chunk {world.chunk(handoff.pos)};
+        const auto chunk_light {world.light(handoff.pos)};
+        if (!chunk || !chunk_light) continue;
+        batches.push_back({handoff.pos, chunk, chunk_light, {}, {}, 0});
+      }
+      batches.back().updates.push_back(handoff.update);
+    }
+    // every batch writes the light of its own chunk only
+    jobs::parallelFor(batches.size(), 1, [&batches, removal](std::size_t begin, std::size_t end) {
+      for (auto i = begin; i < end; ++i) {
+        auto& batch {batches[i]};
+        batch.changed = propagate(batch.pos, *batch.chunk, *batch.light, batch.updates, batch.handoffs, !removal);
+      }
+    });
+    handoffs.clear();
+    for (const auto& batch: batches) {
+      changed += batch.changed;
+      handoffs.insert(handoffs.end(), batch.handoffs.begin(), batch.handoffs.end());
+    }
+  }
+  return changed;
+}
+
+void ktp::light::seed(const Chunk& chunk, bool open_sky, std::vector<Update>& updates) {
+  if (open_sky) {
+    for (GLint z = 0; z < Chunk::size; ++z) {
+      for (GLint x = 0; x < Chunk::size; ++x) {
+        updates.push_back({Chunk::index(x, Chunk::size - 1, z), max_level, LightChannel::Sky, Kind::Propagate});
+      }
+    }
+  }
+  const auto& palette {chunk.palette()};
+  if (std::none_of(palette.begin(), palette.end(), [](BlockID block) { return emission(block) > 0; })) return;
+  for (GLuint index = 0; index < static_cast<GLuint>(Chunk::volume); ++index) {
+    if (emission(chunk.get(index)) > 0) updates.push_back({index, 0, LightChannel::Block, Kind::Clear});
+  }
+}
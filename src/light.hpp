@@ -0,0 +1,148 @@
+/**
+ * @file light.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Flood fill lighting, skylight and block light.
+ * @version 0.1
+ * @date 2022-12-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_LIGHT_HPP_)
+#define KETEMINE_SRC_LIGHT_HPP_
+
+#include "chunk.hpp"
+#include "types.hpp"
+#include "world.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ktp { namespace light {
+
+// of the skylight and of the brightest lamp, it fades by 1 per block
+constexpr std::uint8_t max_level {15};
+
+/**
+ * @brief What happened to the light of a block.
+ */
+enum class Kind: std::uint8_t {
+  // a neighbour gives the block this level, it's lit if it was darker
+  Propagate,
+  // a neighbour that gave the block this level went dark, it goes dark too
+  // unless it's brighter, then it lights the hole back
+  Remove,
+  // the block itself changed, it only keeps what it emits
+  Clear,
+  // the block spreads its light again, a neighbour changed
+  Spread
+};
+
+/**
+ * @brief A change of the light of a block, in the chunk that owns it.
+ */
+struct Update {
+  GLuint index {};
+  std::uint8_t level {};
+  LightChannel channel {LightChannel::Sky};
+  Kind kind {Kind::Propagate};
+};
+
+/**
+ * @brief An update addressed to a chunk. The light of every chunk is only
+ *  written by the job lighting it, changes crossing its border are handed to
+ *  the neighbour this way.
+ */
+struct Handoff {
+  ChunkPos pos {};
+  Update update {};
+};
+
+/**
+ * @brief Worst case relighting times, see benchmark().
+ */
+struct Timing {
+  GLdouble place_ms {};
+  GLdouble remove_ms {};
+  // blocks whose light changed when the lamp was placed
+  std::size_t blocks {};
+};
+
+/**
+ * @param block The block id.
+ * @return How much light a block takes from the light going through it,
+ *  max_level for the opaque ones.
+ */
+std::uint8_t absorption(BlockID block);
+
+/**
+ * @brief Lights a lamp at the corner of 8 chunks of air, the most blocks and
+ *  chunks a single change can relight, and removes it.
+ * @param iterations How many times to place and remove it.
+ * @return The average times.
+ */
+Timing benchmark(std::size_t iterations);
+
+/**
+ * @brief The updates lighting a chunk from the border of a lit neighbour.
+ * @param light The light of the neighbour.
+ * @param from The position of the neighbour.
+ * @param to The position of the chunk, sharing a face with the neighbour.
+ * @param updates Gets the updates for the chunk.
+ */
+void border(const ChunkLight& light, const ChunkPos& from, const ChunkPos& to, std::vector<Update>& updates);
+
+/**
+ * @brief The updates relighting around a block that changed.
+ * @param pos The chunk position.
+ * @param index The index of the block in the chunk.
+ * @param open_sky True if nothing but the sky is above the block.
+ * @param handoffs Gets the updates for the chunk and its neighbours.
+ */
+void changed(const ChunkPos& pos, GLuint index, bool open_sky, std::vector<Handoff>& handoffs);
+
+/**
+ * @param block The block id.
+ * @return The light level the block emits.
+ */
+std::uint8_t emission(BlockID block);
+
+/**
+ * @brief Runs the updates of a chunk, a breadth first search removing the
+ *  light that lost its source first and then spreading the one left.
+ *  Only touches the light given, so chunks can be lit in parallel.
+ * @param pos The chunk position.
+ * @param chunk The blocks of the chunk.
+ * @param light The light of the chunk.
+ * @param updates The updates for the chunk.
+ * @param handoffs Gets the updates crossing into the neighbours.
+ * @param spread False to only remove light, the blocks left to spread are
+ *  handed back to the chunk itself as Kind::Spread updates.
+ * @return The number of blocks whose light changed.
+ */
+std::size_t propagate(const ChunkPos& pos, const Chunk& chunk, ChunkLight& light, const std::vector<Update>& updates, std::vector<Handoff>& handoffs, bool spread = true);
+
+/**
+ * @brief Runs updates until the light settles, in rounds of chunks lit in
+ *  parallel. The handoffs of a round are the updates of the next one, and
+ *  the removals run to the end before any light spreads. Updates for chunks
+ *  without light are dropped.
+ * @param world The world.
+ * @param handoffs The updates to run.
+ * @return The number of blocks whose light changed.
+ */
+std::size_t relight(World& world, std::vector<Handoff> handoffs);
+
+/**
+ * @brief The updates lighting a chunk that was just generated or loaded, by
+ *  itself: the lamps in it, and the sky if it's the top of the world.
+ * @param chunk The chunk, its light is all 0.
+ * @param open_sky True if nothing but the sky is above the chunk.
+ * @param updates Gets the updates.
+ */
+void seed(const Chunk& chunk, bool open_sky, std::vector<Update>& updates);
+
+} } // namespace light/ktp
+
+#endif // KETEMINE_SRC_LIGHT_HPP_
@@ -0,0 +1,257 @@
+#include "mesher.hpp"
+
+#include "world.hpp"
+#include <chrono>
+#include <utility>
+
+ktp::mesher::Timing ktp::mesher::benchmark(const World& world, std::size_t max_chunks) {
+  Timing timing {};
+  PaddedChunk padded {};
+  ChunkMesh mesh {};
+  std::chrono::duration<GLdouble, std::milli> flat {}, shaded {};
+  std::size_t count {};
+  for (const auto& [pos, chunk]: world.chunks()) {
+    if (count == max_chunks) break;
+    if (chunk.isEmpty()) continue;
+    copyNeighbourhood(world, pos, padded);
+    auto start {std::chrono::steady_clock::now()};
+    greedy(padded, mesh, false);
+    flat += std::chrono::steady_clock::now() - start;
+    timing.flat_quads += mesh.quadCount();
+    start = std::chrono::steady_clock::now();
+    greedy(padded, mesh, true);
+    shaded += std::chrono::steady_clock::now() - start;
+    timing.shaded_quads += mesh.quadCount();
+    ++count;
+  }
+  if (count > 0) {
+    timing.flat_ms = flat.count() / static_cast<GLdouble>(count);
+    timing.shaded_ms = shaded.count() / static_cast<GLdouble>(count);
+  }
+  return timing;
+}
+
+void ktp::mesher::copyNeighbourhood(const World& world, const ChunkPos& pos, PaddedChunk& padded) {
+  // the 27 chunks touching the padded volume and their light, nullptr when not loaded
+  const Chunk* chunks[3][3][3] {};
+  const ChunkLight* lights[3][3][3] {};
+  for (GLint y = -1; y <= 1; ++y) {
+    for (GLint z = -1; z <= 1; ++z) {
+      for (GLint x = -1; x <= 1; ++x) {
+        chunks[y + 1][z + 1][x + 1] = world.chunk({pos.x + x, pos.y + y, pos.z + z});
+        lights[y + 1][z + 1][x + 1] = world.light({pos.x + x, pos.y + y, pos.z + z});
+      }
+    }
+  }
+  constexpr auto chunkOffset {[](GLint coord) { return coord < 0 ? 0 : (coord >= Chunk::size ? 2 : 1); }};
+  for (GLint y = -1; y <= Chunk::size; ++y) {
+    for (GLint z = -1; z <= Chunk::size; ++z) {
+      for (GLint x = -1; x <= Chunk::size; ++x) {
+        const auto chunk {chunks[chunkOffset(y)][chunkOffset(z)][chunkOffset(x)]};
+        const auto chunk_light {lights[chunkOffset(y)][chunkOffset(z)][chunkOffset(x)]};
+        const auto local {Chunk::index(World::localCoord(x), World::localCoord(y), World::localCoord(z))};
+        const auto index {PaddedChunk::index(x, y, z)};
+        padded.blocks[index] = chunk ? chunk->get(local) : Blocks::air;
+        padded.light[index] = chunk_light
+          ? static_cast<std::uint8_t>((chunk_light->get(LightChannel::Sky, local) << 4) | chunk_light->get(LightChannel::Block, local))
+          : PaddedChunk::unlit;
+      }
+    }
+  }
+}
+
+void ktp::mesher::downsample(const Chunk& chunk, GLuint level, PaddedChunk& padded) {
+  padded.blocks.fill(Blocks::air);
+  // too far to tell the light apart, only the occlusion shades them
+  padded.light.fill(PaddedChunk::unlit);
+  const GLint scale {1 << level};
+  const GLint cells {Chunk::size / scale};
+  for (GLint cy = 0; cy < cells; ++cy) {
+    for (GLint cz = 0; cz < cells; ++cz) {
+      for (GLint cx = 0; cx < cells; ++cx) {
+        // a handful of block types at most, a linear count is enough
+        std::array<std::pair<BlockID, GLuint>, 8> counts {};
+        std::size_t types {};
+        for (GLint y = cy * scale; y < (cy + 1) * scale; ++y) {
+          for (GLint z = cz * scale; z < (cz + 1) * scale; ++z) {
+            for (GLint x = cx * scale; x < (cx + 1) * scale; ++x) {
+              const auto block {chunk.get(x, y, z)};
+              if (block == Blocks::air) continue;
+              std::size_t t {0};
+              while (t < types && counts[t].first != block) ++t;
+              if (t == types) {
+                if (types == counts.size()) continue;
+                counts[types++] = {block, 0u};
+              }
+              ++counts[t].second;
+            }
+          }
+        }
+        auto cell {Blocks::air};
+        GLuint best {};
+        for (std::size_t t = 0; t < types; ++t) {
+          if (counts[t].second > best) {
+            best = counts[t].second;
+            cell = counts[t].first;
+          }
+        }
+        padded.blocks[PaddedChunk::index(cx, cy, cz)] = cell;
+      }
+    }
+  }
+}
+
+void ktp::mesher::greedy(const PaddedChunk& padded, ChunkMesh& mesh, bool shaded) {
+  constexpr GLint n {Chunk::size};
+  mesh.clear();
+  // 1 where a block occludes and hides the light behind it, so the corners
+  // are sampled with arithmetic only
+  std::array<std::uint8_t, PaddedChunk::size * PaddedChunk::size * PaddedChunk::size> solid {};
+  for (std::size_t i = 0; i < solid.size(); ++i) solid[i] = padded.blocks[i] != Blocks::air;
+  // the distance between neighbours in the padded arrays, by axis
+  constexpr std::ptrdiff_t strides[3] {1, PaddedChunk::size * PaddedChunk::size, PaddedChunk::size};
+  // the visible faces of the current slice, 0 means no face. The block in
+  // the low 16 bits, then the ao of the 4 corners, 2 bits each, and their
+  // light, 8 bits each. Faces merge when all of it matches
+  std::uint64_t mask[n * n] {};
+  for (GLuint axis = 0; axis < 3; ++axis) {
+    const GLuint u_axis {(axis + 1) % 3};
+    const GLuint v_axis {(axis + 2) % 3};
+    const auto du {strides[u_axis]}, dv {strides[v_axis]};
+    // the corners of a face, in the order of the corners of a quad below
+    const std::ptrdiff_t sides[4][2] {{-du, -dv}, {du, -dv}, {du, dv}, {-du, dv}};
+    for (GLuint positive = 0; positive < 2; ++positive) {
+      const GLuint face {axis * 2 + positive};
+      const GLint step {positive ? 1 : -1};
+      for (GLint slice = 0; slice < n; ++slice) {
+        // face culling against the neighbours
+        GLint pos[3] {};
+        pos[axis] = slice;
+        for (GLint j = 0; j < n; ++j) {
+          pos[v_axis] = j;
+          for (GLint i = 0; i < n; ++i) {
+            pos[u_axis] = i;
+            const auto block {padded.get(pos[0], pos[1], pos[2])};
+            pos[axis] += step;
+            const auto front {static_cast<std::ptrdiff_t>(PaddedChunk::index(pos[0], pos[1], pos[2]))};
+            pos[axis] -= step;
+            const auto neighbour {padded.blocks[static_cast<std::size_t>(front)]};
+            auto& key {mask[j * n + i]};
+            key = neighbour == Blocks::air ? block : Blocks::air;
+            if (key == Blocks::air || !shaded) continue;
+            // the block in front of the face, the two beside the corner and
+            // the one across it. The light of the hidden ones doesn't count
+            const auto front_light {padded.light[static_cast<std::size_t>(front)]};
+            for (std::size_t c = 0; c < 4; ++c) {
+              const auto side_u {static_cast<std::size_t>(front + sides[c][0])};
+              const auto side_v {static_cast<std::size_t>(front + sides[c][1])};
+              const auto across {static_cast<std::size_t>(front + sides[c][0] + sides[c][1])};
+              const GLuint s1 {solid[side_u]}, s2 {solid[side_v]}, sc {solid[across]};
+              const GLuint closed {s1 & s2};
+              const GLuint ao {(3u - s1 - s2 - sc) * (1u - closed)};
+              const GLuint open_u {1u - s1}, open_v {1u - s2}, open_across {(1u - sc) & (1u - closed)};
+              const GLuint count {1u + open_u + open_v + open_across};
+              const GLuint light_u {padded.light[side_u]}, light_v {padded.light[side_v]}, light_across {padded.light[across]};
+              const GLuint sky {(front_light >> 4) + (light_u >> 4) * open_u + (light_v >> 4) * open_v + (light_across >> 4) * open_across};
+              const GLuint block_light {(front_light & 15u) + (light_u & 15u) * open_u + (light_v & 15u) * open_v + (light_across & 15u) * open_across};
+              // rounded averages
+              const auto corner_light {(((sky * 2u + count) / (count * 2u)) << 4) | ((block_light * 2u + count) / (count * 2u))};
+              key |= (static_cast<std::uint64_t>(ao) << (16u + c * 2u)) | (static_cast<std::uint64_t>(corner_light) << (24u + c * 8u));
+            }
+          }
+        }
+        // greedy merge of the faces of the same block and shading
+        const auto plane {static_cast<GLuint>(slice + static_cast<GLint>(positive))};
+        for (GLint j = 0; j < n; ++j) {
+          for (GLint i = 0; i < n;) {
+            const auto key {mask[j * n + i]};
+            if (key == 0) {
+              ++i;
+              continue;
+            }
+            GLint width {1};
+            while (i + width < n && mask[j * n + i + width] == key) ++width;
+            GLint height {1};
+            for (; j + height < n; ++height) {
+              bool row_matches {true};
+              for (GLint k = 0; k < width; ++k) {
+                if (mask[(j + height) * n + i + k] != key) {
+                  row_matches = false;
+                  break;
+                }
+              }
+              if (!row_matches) break;
+            }
+            for (GLint l = 0; l < height; ++l) {
+              for (GLint k = 0; k < width; ++k) mask[(j + l) * n + i + k] = 0;
+            }
+            const auto block {static_cast<GLuint>(key & 0xFFFFu)};
+            GLuint ao[4] {3u, 3u, 3u, 3u}, light[4] {PaddedChunk::unlit, PaddedChunk::unlit, PaddedChunk::unlit, PaddedChunk::unlit};
+            if (shaded) {
+              for (GLuint c = 0; c < 4; ++c) {
+                ao[c] = static_cast<GLuint>(key >> (16u + c * 2u)) & 3u;
+                light[c] = static_cast<GLuint>(key >> (24u + c * 8u)) & 0xFFu;
+              }
+            }
+            // the quads are drawn as the triangles 0 1 2 and 2 3 0, starting
+            // from the next corner splits them along the other diagonal
+            const auto brightness {[&ao, &light](GLuint c) { return ao[c] * 32u + (light[c] >> 4) + (light[c] & 15u); }};
+            const GLuint first {brightness(0) + brightness(2) < brightness(1) + brightness(3) ? 1u : 0u};
+            // the 4 corners, counter clockwise seen from outside
+            const auto w {static_cast<GLuint>(width)}, h {static_cast<GLuint>(height)};
+            const auto u0 {static_cast<GLuint>(i)}, v0 {static_cast<GLuint>(j)};
+            const GLuint corners[4][2] {{0u, 0u}, {w, 0u}, {w, h}, {0u, h}};
+            for (GLuint k = 0; k < 4; ++k) {
+              const auto c {positive ? (first + k) % 4u : (4u - (first + k) % 4u) % 4u};
+              const auto& corner {corners[c]};
+              GLuint vertex[3] {};
+              vertex[axis] = plane;
+              vertex[u_axis] = u0 + corner[0];
+              vertex[v_axis] = v0 + corner[1];
+              mesh.vertices.push_back(ChunkVertex::pack(vertex[0], vertex[1], vertex[2], face, ao[c], block, light[c] >> 4, light[c] & 15u));
+            }
+            i += width;
+          }
+        }
+      }
+    }
+  }
+}
+
+void ktp::mesher::greedy(const World& world, const ChunkPos& pos, ChunkMesh& mesh) {
+  PaddedChunk padded {};
+  copyNeighbourhood(world, pos, padded);
+  greedy(padded, mesh);
+}
+
+void ktp::mesher::lod(const Chunk& chunk, GLuint level, ChunkMesh& mesh) {
+  PaddedChunk padded {};
+  downsample(chunk, level, padded);
+  greedy(padded, mesh);
+  // from cells to blocks, the corners still fit in [0, 16]
+  for (auto& vertex: mesh.vertices) {
+    vertex = ChunkVertex::pack(vertex.x() << level, vertex.y() << level, vertex.z() << level, vertex.face(), vertex.ao(), vertex.layer(), vertex.sky(), vertex.block());
+  }
+}
+
+template <typename T>
+static void fillQuadIndices(std::size_t quad_count, std::vector<T>& indices) {
+  indices.resize(quad_count * 6u);
+  for (std::size_t q = 0; q < quad_count; ++q) {
+    const auto base {static_cast<T>(q * 4u)};
+    indices[q * 6u + 0u] = base;
+    indices[q * 6u + 1u] = static_cast<T>(base + 1u);
+    indices[q * 6u + 2u] = static_cast<T>(base + 2u);
+    indices[q * 6u + 3u] = static_cast<T>(base + 2u);
+    indices[q * 6u + 4u] = static_cast<T>(base + 3u);
+    indices[q * 6u + 5u] = base;
+  }
+}
+
+void ktp::mesher::quadIndices(std::size_t quad_count, UintArray& indices) {
+  fillQuadIndices(quad_count, indices);
+}
+
+void ktp::mesher::quadIndices(std::size_t quad_count, UshortArray& indices) {
+  fillQuadIndices(quad_count, indices);
+}
@@ -0,0 +1,201 @@
+/**
+ * @file mesher.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Chunk meshing utilities.
+ * @version 0.1
+ * @date 2022-11-27
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_MESHER_HPP_)
+#define KETEMINE_SRC_MESHER_HPP_
+
+#include "chunk.hpp"
+#include "types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ktp {
+
+/**
+ * @brief A packed chunk vertex, two 32 bit words:
+ *  x(5) y(5) z(5) face(3) ao(2) layer(12)
+ *  sky(4) block(4), the rest unused
+ *  The position is relative to the chunk origin [0, 16], the face is the
+ *  index of the normal, ao goes from 0 (fully occluded) to 3 and the layer
+ *  is the texture layer of the block. sky and block are the smooth light
+ *  levels at the vertex. The uv corner is not stored, the shader projects
+ *  the position on the face plane, so textures tile over merged quads.
+ *  Unpacked by resources/shaders/voxel.vert.
+ */
+struct ChunkVertex {
+
+  GLuint data {};
+  GLuint light {};
+
+  static constexpr ChunkVertex pack(GLuint x, GLuint y, GLuint z, GLuint face, GLuint ao, GLuint layer, GLuint sky = 15u, GLuint block = 0u) {
+    return {x | (y << 5) | (z << 10) | (face << 15) | (ao << 18) | ((layer & 0xFFFu) << 20), (sky & 15u) | ((block & 15u) << 4)};
+  }
+
+  constexpr GLuint x()     const { return data & 31u; }
+  constexpr GLuint y()     const { return (data >> 5) & 31u; }
+  constexpr GLuint z()     const { return (data >> 10) & 31u; }
+  constexpr GLuint face()  const { return (data >> 15) & 7u; }
+  constexpr GLuint ao()    const { return (data >> 18) & 3u; }
+  constexpr GLuint layer() const { return data >> 20; }
+  constexpr GLuint sky()   const { return light & 15u; }
+  constexpr GLuint block() const { return (light >> 4) & 15u; }
+};
+
+static_assert(sizeof(ChunkVertex) == 2 * sizeof(GLuint));
+
+/**
+ * @brief The mesh of a chunk. Every 4 vertices make a quad.
+ */
+struct ChunkMesh {
+
+  std::vector<ChunkVertex> vertices {};
+
+  void clear() { vertices.clear(); }
+  auto quadCount() const { return vertices.size() / 4u; }
+};
+
+/**
+ * @brief A copy of a chunk and its light plus a 1 block border taken from
+ *  its neighbours, so meshing never has to look outside of it.
+ */
+struct PaddedChunk {
+
+  static constexpr GLint size {Chunk::size + 2};
+
+  /**
+   * @return The index of a padded position. Coordinates go from -1 to 16.
+   */
+  static constexpr std::size_t index(GLint x, GLint y, GLint z) {
+    return static_cast<std::size_t>(((y + 1) * size + (z + 1)) * size + (x + 1));
+  }
+
+  BlockID get(GLint x, GLint y, GLint z) const { return blocks[index(x, y, z)]; }
+
+  // full skylight, what's outside of the lit chunks gets
+  static constexpr std::uint8_t unlit {0xF0};
+
+  std::array<BlockID, size * size * size> blocks {};
+  // skylight in the high nibble, block light in the low one
+  std::array<std::uint8_t, size * size * size> light {};
+};
+
+namespace mesher {
+
+// the worst case is a 3D checkerboard, half of the blocks with 6 faces each
+constexpr std::size_t max_quads {static_cast<std::size_t>(Chunk::volume) / 2u * 6u};
+
+// the coarsest level of detail, cells of 8x8x8 blocks
+constexpr GLuint max_lod {3};
+
+/**
+ * @brief The six faces of a block. The face index is axis * 2 + positive direction.
+ */
+enum Face: GLuint {
+  NegativeX, PositiveX,
+  NegativeY, PositiveY,
+  NegativeZ, PositiveZ
+};
+
+/**
+ * @brief Meshing times of a set of chunks, see benchmark().
+ */
+struct Timing {
+  // per chunk
+  GLdouble flat_ms {};
+  GLdouble shaded_ms {};
+  // quads of all the chunks, shading splits the merged ones
+  std::size_t flat_quads {};
+  std::size_t shaded_quads {};
+};
+
+/**
+ * @brief Meshes chunks of a world at full detail with and without ambient
+ *  occlusion and smooth light. The copies of the chunks aren't timed.
+ * @param world The chunks to mesh.
+ * @param max_chunks How many chunks to mesh at most.
+ * @return The average times.
+ */
+Timing benchmark(const World& world, std::size_t max_chunks);
+
+/**
+ * @brief Copies a chunk, its light and its border from the world.
+ * @param world The world.
+ * @param pos The position of the chunk.
+ * @param padded The padded chunk to fill.
+ */
+void copyNeighbourhood(const World& world, const ChunkPos& pos, PaddedChunk& padded);
+
+/**
+ * @brief Builds a lower detail copy of a chunk, for the far away meshes.
+ *  Every cell of 2^level blocks per side becomes the most common solid block
+ *  in it, or air if there's none, so thin terrain doesn't open holes. The
+ *  cells fill the low corner of the padded copy and everything else is air,
+ *  so greedy() closes the mesh with faces on every border of the chunk. Those
+ *  act as skirts and hide the cracks next to chunks of another level.
+ * @param chunk The chunk.
+ * @param level The level of detail, 1 to max_lod.
+ * @param padded The padded chunk to fill.
+ */
+void downsample(const Chunk& chunk, GLuint level, PaddedChunk& padded);
+
+/**
+ * @brief Builds the mesh of a chunk, culling the hidden faces and merging
+ *  the coplanar faces of the same block into bigger quads. Shaded meshes
+ *  get Minecraft style ambient occlusion and smooth light at every vertex,
+ *  from the 4 blocks around it in front of the face, and only faces with
+ *  the same values at their corners merge. The quads are split along the
+ *  diagonal with the closest values, so the interpolation doesn't show it.
+ * @param padded The chunk and its border.
+ * @param mesh The mesh to fill.
+ * @param shaded False to give every vertex no occlusion and full skylight.
+ */
+void greedy(const PaddedChunk& padded, ChunkMesh& mesh, bool shaded = true);
+
+/**
+ * @brief Builds the mesh of a chunk of the world. See mesher::greedy().
+ * @param world The world.
+ * @param pos The position of the chunk.
+ * @param mesh The mesh to fill.
+ */
+void greedy(const World& world, const ChunkPos& pos, ChunkMesh& mesh);
+
+/**
+ * @brief Builds a lower detail mesh of a chunk, in the same vertex format
+ *  and block units as the full detail one. See mesher::downsample().
+ * @param chunk The chunk.
+ * @param level The level of detail, 1 to max_lod.
+ * @param mesh The mesh to fill.
+ */
+void lod(const Chunk& chunk, GLuint level, ChunkMesh& mesh);
+
+/**
+ * @brief Fills an index array for drawing quads as triangles.
+ *  The same indices are valid for every ChunkMesh.
+ * @param quad_count The number of quads.
+ * @param indices The indices to fill.
+ */
+void quadIndices(std::size_t quad_count, UintArray& indices);
+
+/**
+ * @brief Fills a 16 bit index array for drawing quads as triangles.
+ *  Enough for mesher::max_quads, so valid for any ChunkMesh.
+ * @param quad_count The number of quads.
+ * @param indices The indices to fill.
+ */
+void quadIndices(std::size_t quad_count, UshortArray& indices);
+
+} // namespace mesher
+
+} // namespace ktp
+
+#endif // KETEMINE_SRC_MESHER_HPP_
@@ -0,0 +1,90 @@
+/**
+ * @file mpsc_queue.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief A lock free multiple producer, single consumer queue.
+ * @version 0.1
+ * @date 2022-11-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_MPSC_QUEUE_HPP_)
+#define KETEMINE_SRC_MPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace ktp {
+
+/**
+ * @brief A lock free queue where any thread can push and only one thread consumes.
+ *  Producers push onto an intrusive stack with a CAS, the consumer takes the
+ *  whole stack at once and reverses it, so items come out in push order.
+ * @tparam T The type of the items.
+ */
+template <typename T>
+class MpscQueue {
+
+ public:
+
+  MpscQueue() = default;
+  MpscQueue(const MpscQueue& other) = delete;
+  MpscQueue& operator=(const MpscQueue& other) = delete;
+  ~MpscQueue() { consume([](T&&) {}); }
+
+  /**
+   * @brief Takes every item pushed so far. Only one thread may call it.
+   * @param function Called with every item, in push order.
+   * @return The number of items consumed.
+   */
+  template <typename Function>
+  std::size_t consume(Function&& function) {
+    Node* node {m_head.exchange(nullptr, std::memory_order_acquire)};
+    // reverse the stack
+    Node* reversed {nullptr};
+    while (node) {
+      Node* next {node->next};
+      node->next = reversed;
+      reversed = node;
+      node = next;
+    }
+    std::size_t count {};
+    while (reversed) {
+      Node* next {reversed->next};
+      function(std::move(reversed->value));
+      delete reversed;
+      reversed = next;
+      ++count;
+    }
+    return count;
+  }
+
+  /**
+   * @return True if there was nothing to consume at the time of the call.
+   */
+  bool empty() const { return m_head.load(std::memory_order_relaxed) == nullptr; }
+
+  /**
+   * @brief Pushes an item. Any thread may call it.
+   * @param value The item.
+   */
+  void push(T&& value) {
+    Node* node {new Node{std::move(value), m_head.load(std::memory_order_relaxed)}};
+    while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+ private:
+
+  struct Node {
+    T value;
+    Node* next;
+  };
+
+  std::atomic<Node*> m_head {nullptr};
+};
+
+} // namespace ktp
+
+#endif // KETEMINE_SRC_MPSC_QUEUE_HPP_
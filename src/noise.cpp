@@ -0,0 +1,557 @@
+#include "noise.hpp"
+
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define KTP_NOISE_AVX2
+  #define KTP_NOISE_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define KTP_NOISE_SSE2
+#endif
+
+namespace {
+
+using namespace ktp;
+
+// The kernels are written once, as templates over a few thin wrappers of the
+// registers of every instruction set. Float holds the samples, Int the
+// lattice coordinates and hashes and Mask the result of a comparison, with
+// every bit of the lane set when true. Every wrapper type names the other
+// two and the number of lanes, so the kernels only need the Float type.
+
+/* Scalar */
+
+namespace scalar {
+
+struct Int;
+struct Mask;
+
+struct Float {
+  using Int = scalar::Int;
+  using Mask = scalar::Mask;
+  static constexpr std::size_t width {1};
+  Float(GLfloat value): v{value} {}
+  static Float load(const GLfloat* p) { return *p; }
+  GLfloat v;
+};
+
+struct Int {
+  Int(std::int32_t value): v{static_cast<std::uint32_t>(value)} {}
+  Int(std::uint32_t value): v{value} {}
+  // unsigned, so it wraps around like the SIMD registers
+  std::uint32_t v;
+};
+
+struct Mask {
+  bool v;
+};
+
+inline Float operator+(Float a, Float b) { return a.v + b.v; }
+inline Float operator-(Float a, Float b) { return a.v - b.v; }
+inline Float operator*(Float a, Float b) { return a.v * b.v; }
+inline Mask operator>(Float a, Float b) { return {a.v > b.v}; }
+inline Mask operator>=(Float a, Float b) { return {a.v >= b.v}; }
+inline Float floor(Float a) { return std::floor(a.v); }
+inline Float max(Float a, Float b) { return a.v > b.v ? a.v : b.v; }
+inline void store(GLfloat* p, Float a) { *p = a.v; }
+
+inline Int operator+(Int a, Int b) { return a.v + b.v; }
+inline Int operator*(Int a, Int b) { return a.v * b.v; }
+inline Int operator&(Int a, Int b) { return a.v & b.v; }
+inline Int operator^(Int a, Int b) { return a.v ^ b.v; }
+inline Int operator<<(Int a, int bits) { return a.v << bits; }
+inline Int operator>>(Int a, int bits) { return a.v >> bits; }
+inline Mask operator==(Int a, Int b) { return {a.v == b.v}; }
+inline Mask operator<(Int a, Int b) { return {static_cast<std::int32_t>(a.v) < static_cast<std::int32_t>(b.v)}; }
+
+inline Mask operator&(Mask a, Mask b) { return {a.v && b.v}; }
+inline Mask operator|(Mask a, Mask b) { return {a.v || b.v}; }
+inline Mask operator~(Mask a) { return {!a.v}; }
+
+inline Float select(Mask m, Float a, Float b) { return m.v ? a : b; }
+inline Int select(Mask m, Int a, Int b) { return m.v ? a : b; }
+inline Float toFloat(Int a) { return static_cast<GLfloat>(static_cast<std::int32_t>(a.v)); }
+inline Int toInt(Float a) { return static_cast<std::int32_t>(a.v); }
+// flips the sign of a where the lowest bit of the flag is set
+inline Float flipSign(Float a, Int flag) { return std::bit_cast<GLfloat>(std::bit_cast<std::uint32_t>(a.v) ^ (flag.v << 31)); }
+
+} // namespace scalar
+
+/* SSE2 */
+
+#if defined(KTP_NOISE_SSE2)
+namespace sse2 {
+
+struct Int;
+struct Mask;
+
+struct Float {
+  using Int = sse2::Int;
+  using Mask = sse2::Mask;
+  static constexpr std::size_t width {4};
+  Float(__m128 value): v{value} {}
+  Float(GLfloat value): v{_mm_set1_ps(value)} {}
+  static Float load(const GLfloat* p) { return _mm_loadu_ps(p); }
+  __m128 v;
+};
+
+struct Int {
+  Int(__m128i value): v{value} {}
+  Int(std::int32_t value): v{_mm_set1_epi32(value)} {}
+  __m128i v;
+};
+
+struct Mask {
+  __m128 v;
+};
+
+inline Float operator+(Float a, Float b) { return _mm_add_ps(a.v, b.v); }
+inline Float operator-(Float a, Float b) { return _mm_sub_ps(a.v, b.v); }
+inline Float operator*(Float a, Float b) { return _mm_mul_ps(a.v, b.v); }
+inline Mask operator>(Float a, Float b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline Mask operator>=(Float a, Float b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+// no rounding instructions before SSE4.1: truncate, then fix the negatives
+inline Float floor(Float a) {
+  const auto truncated {_mm_cvtepi32_ps(_mm_cvttps_epi32(a.v))};
+  return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.f)));
+}
+inline Float max(Float a, Float b) { return _mm_max_ps(a.v, b.v); }
+inline void store(GLfloat* p, Float a) { _mm_storeu_ps(p, a.v); }
+
+inline Int operator+(Int a, Int b) { return _mm_add_epi32(a.v, b.v); }
+// no 32 bit multiply before SSE4.1 either: multiply the even and the odd lanes to 64 bits
+inline Int operator*(Int a, Int b) {
+  const auto even {_mm_mul_epu32(a.v, b.v)};
+  const auto odd {_mm_mul_epu32(_mm_srli_si128(a.v, 4), _mm_srli_si128(b.v, 4))};
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+inline Int operator&(Int a, Int b) { return _mm_and_si128(a.v, b.v); }
+inline Int operator^(Int a, Int b) { return _mm_xor_si128(a.v, b.v); }
+inline Int operator<<(Int a, int bits) { return _mm_slli_epi32(a.v, bits); }
+inline Int operator>>(Int a, int bits) { return _mm_srli_epi32(a.v, bits); }
+inline Mask operator==(Int a, Int b) { return {_mm_castsi128_ps(_mm_cmpeq_epi32(a.v, b.v))}; }
+inline Mask operator<(Int a, Int b) { return {_mm_castsi128_ps(_mm_cmplt_epi32(a.v, b.v))}; }
+
+inline Mask operator&(Mask a, Mask b) { return {_mm_and_ps(a.v, b.v)}; }
+inline Mask operator|(Mask a, Mask b) { return {_mm_or_ps(a.v, b.v)}; }
+inline Mask operator~(Mask a) { return {_mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1)))}; }
+
+inline Float select(Mask m, Float a, Float b) { return _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)); }
+inline Int select(Mask m, Int a, Int b) {
+  const auto mask {_mm_castps_si128(m.v)};
+  return _mm_or_si128(_mm_and_si128(mask, a.v), _mm_andnot_si128(mask, b.v));
+}
+inline Float toFloat(Int a) { return _mm_cvtepi32_ps(a.v); }
+inline Int toInt(Float a) { return _mm_cvttps_epi32(a.v); }
+inline Float flipSign(Float a, Int flag) { return _mm_xor_ps(a.v, _mm_castsi128_ps(_mm_slli_epi32(flag.v, 31))); }
+
+} // namespace sse2
+#endif
+
+/* AVX2 */
+
+#if defined(KTP_NOISE_AVX2)
+namespace avx2 {
+
+struct Int;
+struct Mask;
+
+struct Float {
+  using Int = avx2::Int;
+  using Mask = avx2::Mask;
+  static constexpr std::size_t width {8};
+  Float(__m256 value): v{value} {}
+  Float(GLfloat value): v{_mm256_set1_ps(value)} {}
+  static Float load(const GLfloat* p) { return _mm256_loadu_ps(p); }
+  __m256 v;
+};
+
+struct Int {
+  Int(__m256i value): v{value} {}
+  Int(std::int32_t value): v{_mm256_set1_epi32(value)} {}
+  __m256i v;
+};
+
+struct Mask {
+  __m256 v;
+};
+
+inline Float operator+(Float a, Float b) { return _mm256_add_ps(a.v, b.v); }
+inline Float operator-(Float a, Float b) { return _mm256_sub_ps(a.v, b.v); }
+inline Float operator*(Float a, Float b) { return _mm256_mul_ps(a.v, b.v); }
+inline Mask operator>(Float a, Float b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+inline Mask operator>=(Float a, Float b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+inline Float floor(Float a) { return _mm256_floor_ps(a.v); }
+inline Float max(Float a, Float b) { return _mm256_max_ps(a.v, b.v); }
+inline void store(GLfloat* p, Float a) { _mm256_storeu_ps(p, a.v); }
+
+inline Int operator+(Int a, Int b) { return _mm256_add_epi32(a.v, b.v); }
+inline Int operator*(Int a, Int b) { return _mm256_mullo_epi32(a.v, b.v); }
+inline Int operator&(Int a, Int b) { return _mm256_and_si256(a.v, b.v); }
+inline Int operator^(Int a, Int b) { return _mm256_xor_si256(a.v, b.v); }
+inline Int operator<<(Int a, int bits) { return _mm256_slli_epi32(a.v, bits); }
+inline Int operator>>(Int a, int bits) { return _mm256_srli_epi32(a.v, bits); }
+inline Mask operator==(Int a, Int b) { return {_mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v))}; }
+inline Mask operator<(Int a, Int b) { return {_mm256_castsi256_ps(_mm256_cmpgt_epi32(b.v, a.v))}; }
+
+inline Mask operator&(Mask a, Mask b) { return {_mm256_and_ps(a.v, b.v)}; }
+inline Mask operator|(Mask a, Mask b) { return {_mm256_or_ps(a.v, b.v)}; }
+inline Mask operator~(Mask a) { return {_mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))}; }
+
+inline Float select(Mask m, Float a, Float b) { return _mm256_blendv_ps(b.v, a.v, m.v); }
+inline Int select(Mask m, Int a, Int b) { return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b.v), _mm256_castsi256_ps(a.v), m.v)); }
+inline Float toFloat(Int a) { return _mm256_cvtepi32_ps(a.v); }
+inline Int toInt(Float a) { return _mm256_cvttps_epi32(a.v); }
+inline Float flipSign(Float a, Int flag) { return _mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_slli_epi32(flag.v, 31))); }
+
+} // namespace avx2
+#endif
+
+/* Kernels */
+
+// the lattice coordinates are multiplied by these before hashing, so
+// neighbouring cells get unrelated hashes
+constexpr std::int32_t prime_x {501125321};
+constexpr std::int32_t prime_y {1136930381};
+constexpr std::int32_t prime_z {1720413743};
+
+template <typename Float>
+using IntOf = typename Float::Int;
+
+template <typename Float>
+IntOf<Float> hash(IntOf<Float> seed, IntOf<Float> x, IntOf<Float> y) {
+  auto h {(seed ^ x ^ y) * IntOf<Float>{0x27d4eb2d}};
+  return h ^ (h >> 15);
+}
+
+template <typename Float>
+IntOf<Float> hash(IntOf<Float> seed, IntOf<Float> x, IntOf<Float> y, IntOf<Float> z) {
+  auto h {(seed ^ x ^ y ^ z) * IntOf<Float>{0x27d4eb2d}};
+  return h ^ (h >> 15);
+}
+
+// dot product with one of 8 gradients picked by the low bits of the hash
+template <typename Float>
+Float gradient(IntOf<Float> h, Float x, Float y) {
+  using Int = IntOf<Float>;
+  const auto x_first {(h & Int{4}) == Int{0}};
+  const auto u {select(x_first, x, y)};
+  const auto v {select(x_first, y, x)};
+  return flipSign(u, h) + flipSign(v * Float{2.f}, h >> 1);
+}
+
+// dot product with one of the 12 gradients of improved Perlin noise, picked
+// by the low bits of the hash, the 4 extra values repeat some of them
+template <typename Float>
+Float gradient(IntOf<Float> h, Float x, Float y, Float z) {
+  using Int = IntOf<Float>;
+  const auto low {h & Int{15}};
+  const auto u {select(low < Int{8}, x, y)};
+  const auto v {select(low < Int{4}, y, select((low == Int{12}) | (low == Int{14}), x, z))};
+  return flipSign(u, h) + flipSign(v, h >> 1);
+}
+
+template <typename Float>
+Float fade(Float t) {
+  return t * t * t * (t * (t * Float{6.f} - Float{15.f}) + Float{10.f});
+}
+
+template <typename Float>
+Float lerp(Float a, Float b, Float t) {
+  return a + (b - a) * t;
+}
+
+template <typename Float>
+Float perlin(Float x, Float y, IntOf<Float> seed) {
+  using Int = IntOf<Float>;
+  const auto x_floor {floor(x)}, y_floor {floor(y)};
+  const auto x0 {toInt(x_floor) * Int{prime_x}}, y0 {toInt(y_floor) * Int{prime_y}};
+  const auto x1 {x0 + Int{prime_x}}, y1 {y0 + Int{prime_y}};
+  const auto fx0 {x - x_floor}, fy0 {y - y_floor};
+  const auto fx1 {fx0 - Float{1.f}}, fy1 {fy0 - Float{1.f}};
+  const auto u {fade(fx0)}, v {fade(fy0)};
+  const auto n0 {lerp(gradient(hash<Float>(seed, x0, y0), fx0, fy0), gradient(hash<Float>(seed, x1, y0), fx1, fy0), u)};
+  const auto n1 {lerp(gradient(hash<Float>(seed, x0, y1), fx0, fy1), gradient(hash<Float>(seed, x1, y1), fx1, fy1), u)};
+  return lerp(n0, n1, v) * Float{0.507f};
+}
+
+template <typename Float>
+Float perlin(Float x, Float y, Float z, IntOf<Float> seed) {
+  using Int = IntOf<Float>;
+  const auto x_floor {floor(x)}, y_floor {floor(y)}, z_floor {floor(z)};
+  const auto x0 {toInt(x_floor) * Int{prime_x}}, y0 {toInt(y_floor) * Int{prime_y}}, z0 {toInt(z_floor) * Int{prime_z}};
+  const auto x1 {x0 + Int{prime_x}}, y1 {y0 + Int{prime_y}}, z1 {z0 + Int{prime_z}};
+  const auto fx0 {x - x_floor}, fy0 {y - y_floor}, fz0 {z - z_floor};
+  const auto fx1 {fx0 - Float{1.f}}, fy1 {fy0 - Float{1.f}}, fz1 {fz0 - Float{1.f}};
+  const auto u {fade(fx0)}, v {fade(fy0)}, w {fade(fz0)};
+  const auto n00 {lerp(gradient(hash<Float>(seed, x0, y0, z0), fx0, fy0, fz0), gradient(hash<Float>(seed, x1, y0, z0), fx1, fy0, fz0), u)};
+  const auto n10 {lerp(gradient(hash<Float>(seed, x0, y1, z0), fx0, fy1, fz0), gradient(hash<Float>(seed, x1, y1, z0), fx1, fy1, fz0), u)};
+  const auto n01 {lerp(gradient(hash<Float>(seed, x0, y0, z1), fx0, fy0, fz1), gradient(hash<Float>(seed, x1, y0, z1), fx1, fy0, fz1), u)};
+  const auto n11 {lerp(gradient(hash<Float>(seed, x0, y1, z1), fx0, fy1, fz1), gradient(hash<Float>(seed, x1, y1, z1), fx1, fy1, fz1), u)};
+  return lerp(lerp(n00, n10, v), lerp(n01, n11, v), w) * Float{0.936f};
+}
+
+// the contribution of a simplex corner, fading to 0 at the given squared radius
+template <typename Float>
+Float corner(Float radius, Float gradient_dot, Float distance) {
+  auto t {max(radius - distance, Float{0.f})};
+  t = t * t;
+  return t * t * gradient_dot;
+}
+
+template <typename Float>
+Float simplex(Float x, Float y, IntOf<Float> seed) {
+  using Int = IntOf<Float>;
+  constexpr GLfloat skew {0.366025403f};   // (sqrt(3) - 1) / 2
+  constexpr GLfloat unskew {0.211324865f}; // (3 - sqrt(3)) / 6
+  const auto s {(x + y) * Float{skew}};
+  const auto i {floor(x + s)}, j {floor(y + s)};
+  const auto t {(i + j) * Float{unskew}};
+  const auto x0 {x - (i - t)}, y0 {y - (j - t)};
+  // the middle corner is one step along x in the lower triangle, along y in the upper one
+  const auto lower {x0 > y0};
+  const auto x1 {x0 - select(lower, Float{1.f}, Float{0.f}) + Float{unskew}};
+  const auto y1 {y0 - select(lower, Float{0.f}, Float{1.f}) + Float{unskew}};
+  const auto x2 {x0 - Float{1.f - 2.f * unskew}}, y2 {y0 - Float{1.f - 2.f * unskew}};
+  const auto hx0 {toInt(i) * Int{prime_x}}, hy0 {toInt(j) * Int{prime_y}};
+  const auto hx1 {hx0 + select(lower, Int{prime_x}, Int{0})};
+  const auto hy1 {hy0 + select(lower, Int{0}, Int{prime_y})};
+  const auto hx2 {hx0 + Int{prime_x}}, hy2 {hy0 + Int{prime_y}};
+  const Float radius {0.5f};
+  const auto n0 {corner(radius, gradient(hash<Float>(seed, hx0, hy0), x0, y0), x0 * x0 + y0 * y0)};
+  const auto n1 {corner(radius, gradient(hash<Float>(seed, hx1, hy1), x1, y1), x1 * x1 + y1 * y1)};
+  const auto n2 {corner(radius, gradient(hash<Float>(seed, hx2, hy2), x2, y2), x2 * x2 + y2 * y2)};
+  return (n0 + n1 + n2) * Float{40.f};
+}
+
+template <typename Float>
+Float simplex(Float x, Float y, Float z, IntOf<Float> seed) {
+  using Int = IntOf<Float>;
+  constexpr GLfloat skew {1.f / 3.f};
+  constexpr GLfloat unskew {1.f / 6.f};
+  const auto s {(x + y + z) * Float{skew}};
+  const auto i {floor(x + s)}, j {floor(y + s)}, k {floor(z + s)};
+  const auto t {(i + j + k) * Float{unskew}};
+  const auto x0 {x - (i - t)}, y0 {y - (j - t)}, z0 {z - (k - t)};
+  // which of the 6 tetrahedra of the cube: the second corner steps along the
+  // biggest coordinate, the third one along the two biggest
+  const auto x_ge_y {x0 >= y0}, y_ge_z {y0 >= z0}, x_ge_z {x0 >= z0};
+  const auto i1 {x_ge_y & x_ge_z}, j1 {~x_ge_y & y_ge_z}, k1 {~x_ge_z & ~y_ge_z};
+  const auto i2 {x_ge_y | x_ge_z}, j2 {~x_ge_y | y_ge_z}, k2 {~(x_ge_z & y_ge_z)};
+  const Float one {1.f}, zero {0.f};
+  const auto x1 {x0 - select(i1, one, zero) + Float{unskew}};
+  const auto y1 {y0 - select(j1, one, zero) + Float{unskew}};
+  const auto z1 {z0 - select(k1, one, zero) + Float{unskew}};
+  const auto x2 {x0 - select(i2, one, zero) + Float{2.f * unskew}};
+  const auto y2 {y0 - select(j2, one, zero) + Float{2.f * unskew}};
+  const auto z2 {z0 - select(k2, one, zero) + Float{2.f * unskew}};
+  const auto x3 {x0 - Float{1.f - 3.f * unskew}};
+  const auto y3 {y0 - Float{1.f - 3.f * unskew}};
+  const auto z3 {z0 - Float{1.f - 3.f * unskew}};
+  const auto hx0 {toInt(i) * Int{prime_x}}, hy0 {toInt(j) * Int{prime_y}}, hz0 {toInt(k) * Int{prime_z}};
+  const Int px {prime_x}, py {prime_y}, pz {prime_z}, none {0};
+  const auto h0 {hash<Float>(seed, hx0, hy0, hz0)};
+  const auto h1 {hash<Float>(seed, hx0 + select(i1, px, none), hy0 + select(j1, py, none), hz0 + select(k1, pz, none))};
+  const auto h2 {hash<Float>(seed, hx0 + select(i2, px, none), hy0 + select(j2, py, none), hz0 + select(k2, pz, none))};
+  const auto h3 {hash<Float>(seed, hx0 + px, hy0 + py, hz0 + pz)};
+  const Float radius {0.6f};
+  const auto n0 {corner(radius, gradient(h0, x0, y0, z0), x0 * x0 + y0 * y0 + z0 * z0)};
+  const auto n1 {corner(radius, gradient(h1, x1, y1, z1), x1 * x1 + y1 * y1 + z1 * z1)};
+  const auto n2 {corner(radius, gradient(h2, x2, y2, z2), x2 * x2 + y2 * y2 + z2 * z2)};
+  const auto n3 {corner(radius, gradient(h3, x3, y3, z3), x3 * x3 + y3 * y3 + z3 * z3)};
+  return (n0 + n1 + n2 + n3) * Float{32.f};
+}
+
+template <typename Float>
+Float single(noise::Type type, Float x, Float y, IntOf<Float> seed) {
+  return type == noise::Type::Perlin ? perlin(x, y, seed) : simplex(x, y, seed);
+}
+
+template <typename Float>
+Float single(noise::Type type, Float x, Float y, Float z, IntOf<Float> seed) {
+  return type == noise::Type::Perlin ? perlin(x, y, z, seed) : simplex(x, y, z, seed);
+}
+
+// the warp offsets use their own seeds, so they don't follow the noise they displace
+constexpr GLint warp_seed_x {0x5851F42D};
+constexpr GLint warp_seed_y {0x14057B7E};
+constexpr GLint warp_seed_z {0x2C9277B5};
+
+template <typename Float>
+Float fbm(const noise::Fractal& fractal, Float x, Float y) {
+  using Int = IntOf<Float>;
+  if (fractal.warp_amplitude > 0.f) {
+    const Float wx {x * Float{fractal.warp_frequency}}, wy {y * Float{fractal.warp_frequency}};
+    const Float amplitude {fractal.warp_amplitude};
+    x = x + single(fractal.type, wx, wy, Int{fractal.seed ^ warp_seed_x}) * amplitude;
+    y = y + single(fractal.type, wx, wy, Int{fractal.seed ^ warp_seed_y}) * amplitude;
+  }
+  x = x * Float{fractal.frequency};
+  y = y * Float{fractal.frequency};
+  Float sum {0.f};
+  GLfloat amplitude {1.f}, total {0.f};
+  for (GLint octave = 0; octave < fractal.octaves; ++octave) {
+    sum = sum + single(fractal.type, x, y, Int{fractal.seed} + Int{octave}) * Float{amplitude};
+    total += amplitude;
+    amplitude *= fractal.gain;
+    x = x * Float{fractal.lacunarity};
+    y = y * Float{fractal.lacunarity};
+  }
+  return total > 0.f ? sum * Float{1.f / total} : sum;
+}
+
+template <typename Float>
+Float fbm(const noise::Fractal& fractal, Float x, Float y, Float z) {
+  using Int = IntOf<Float>;
+  if (fractal.warp_amplitude > 0.f) {
+    const Float wx {x * Float{fractal.warp_frequency}}, wy {y * Float{fractal.warp_frequency}}, wz {z * Float{fractal.warp_frequency}};
+    const Float amplitude {fractal.warp_amplitude};
+    x = x + single(fractal.type, wx, wy, wz, Int{fractal.seed ^ warp_seed_x}) * amplitude;
+    y = y + single(fractal.type, wx, wy, wz, Int{fractal.seed ^ warp_seed_y}) * amplitude;
+    z = z + single(fractal.type, wx, wy, wz, Int{fractal.seed ^ warp_seed_z}) * amplitude;
+  }
+  x = x * Float{fractal.frequency};
+  y = y * Float{fractal.frequency};
+  z = z * Float{fractal.frequency};
+  Float sum {0.f};
+  GLfloat amplitude {1.f}, total {0.f};
+  for (GLint octave = 0; octave < fractal.octaves; ++octave) {
+    sum = sum + single(fractal.type, x, y, z, Int{fractal.seed} + Int{octave}) * Float{amplitude};
+    total += amplitude;
+    amplitude *= fractal.gain;
+    x = x * Float{fractal.lacunarity};
+    y = y * Float{fractal.lacunarity};
+    z = z * Float{fractal.lacunarity};
+  }
+  return total > 0.f ? sum * Float{1.f / total} : sum;
+}
+
+/**
+ * @brief Samples every whole register of positions.
+ * @return The index of the first position left.
+ */
+template <typename Float>
+std::size_t sampleBatch(const noise::Fractal& fractal, const GLfloat* x, const GLfloat* y, const GLfloat* z, std::size_t count, GLfloat* out) {
+  std::size_t i {0};
+  if (z) {
+    for (; i + Float::width <= count; i += Float::width) {
+      store(out + i, fbm(fractal, Float::load(x + i), Float::load(y + i), Float::load(z + i)));
+    }
+  } else {
+    for (; i + Float::width <= count; i += Float::width) {
+      store(out + i, fbm(fractal, Float::load(x + i), Float::load(y + i)));
+    }
+  }
+  return i;
+}
+
+} // namespace
+
+GLdouble ktp::noise::benchmark(const Fractal& fractal, Isa isa) {
+  constexpr GLint sections {64};
+  Section section {};
+  const auto start {std::chrono::steady_clock::now()};
+  for (GLint i = 0; i < sections; ++i) {
+    fillSection(fractal, {i * Chunk::size, 0, 0}, section, isa);
+  }
+  const auto seconds {std::chrono::duration<GLdouble>(std::chrono::steady_clock::now() - start).count()};
+  return static_cast<GLdouble>(sections * Chunk::volume) / seconds;
+}
+
+ktp::noise::Isa ktp::noise::best() {
+#if defined(KTP_NOISE_AVX2)
+  return Isa::AVX2;
+#elif defined(KTP_NOISE_SSE2)
+  return Isa::SSE2;
+#else
+  return Isa::Scalar;
+#endif
+}
+
+GLfloat ktp::noise::fbm(const Fractal& fractal, GLfloat x, GLfloat y) {
+  return ::fbm(fractal, scalar::Float{x}, scalar::Float{y}).v;
+}
+
+GLfloat ktp::noise::fbm(const Fractal& fractal, GLfloat x, GLfloat y, GLfloat z) {
+  return ::fbm(fractal, scalar::Float{x}, scalar::Float{y}, scalar::Float{z}).v;
+}
+
+void ktp::noise::fillColumn(const Fractal& fractal, GLint x, GLint z, Column& column, Isa isa) {
+  Column xs {}, zs {};
+  for (GLint local_z = 0; local_z < Chunk::size; ++local_z) {
+    for (GLint local_x = 0; local_x < Chunk::size; ++local_x) {
+      const auto index {static_cast<std::size_t>((local_z << 4) | local_x)};
+      xs[index] = static_cast<GLfloat>(x + local_x);
+      zs[index] = static_cast<GLfloat>(z + local_z);
+    }
+  }
+  sample(fractal, xs.data(), zs.data(), nullptr, column.size(), column.data(), isa);
+}
+
+void ktp::noise::fillSection(const Fractal& fractal, const ChunkPos& origin, Section& section, Isa isa) {
+  Section xs {}, ys {}, zs {};
+  for (GLint y = 0; y < Chunk::size; ++y) {
+    for (GLint z = 0; z < Chunk::size; ++z) {
+      for (GLint x = 0; x < Chunk::size; ++x) {
+        const auto index {Chunk::index(x, y, z)};
+        xs[index] = static_cast<GLfloat>(origin.x + x);
+        ys[index] = static_cast<GLfloat>(origin.y + y);
+        zs[index] = static_cast<GLfloat>(origin.z + z);
+      }
+    }
+  }
+  sample(fractal, xs.data(), ys.data(), zs.data(), section.size(), section.data(), isa);
+}
+
+const char* ktp::noise::name(Isa isa) {
+  switch (isa) {
+    case Isa::Scalar: return "Scalar";
+    case Isa::SSE2:   return "SSE2";
+    case Isa::AVX2:   return "AVX2";
+  }
+  return "";
+}
+
+GLfloat ktp::noise::perlin(GLfloat x, GLfloat y, GLint seed) {
+  return ::perlin(scalar::Float{x}, scalar::Float{y}, scalar::Int{seed}).v;
+}
+
+GLfloat ktp::noise::perlin(GLfloat x, GLfloat y, GLfloat z, GLint seed) {
+  return ::perlin(scalar::Float{x}, scalar::Float{y}, scalar::Float{z}, scalar::Int{seed}).v;
+}
+
+void ktp::noise::sample(const Fractal& fractal, const GLfloat* x, const GLfloat* y, const GLfloat* z, std::size_t count, GLfloat* out, Isa isa) {
+  std::size_t i {0};
+  switch (isa) {
+#if defined(KTP_NOISE_AVX2)
+    case Isa::AVX2:
+      i = sampleBatch<avx2::Float>(fractal, x, y, z, count, out);
+      break;
+#endif
+#if defined(KTP_NOISE_SSE2)
+    case Isa::SSE2:
+      i = sampleBatch<sse2::Float>(fractal, x, y, z, count, out);
+      break;
+#endif
+    default:
+      break;
+  }
+  // the positions that don't fill a whole register
+  sampleBatch<scalar::Float>(fractal, x + i, y + i, z ? z + i : nullptr, count - i, out + i);
+}
+
+GLfloat ktp::noise::simplex(GLfloat x, GLfloat y, GLint seed) {
+  return ::simplex(scalar::Float{x}, scalar::Float{y}, scalar::Int{seed}).v;
+}
+
+GLfloat ktp::noise::simplex(GLfloat x, GLfloat y, GLfloat z, GLint seed) {
+  return ::simplex(scalar::Float{x}, scalar::Float{y}, scalar::Float{z}, scalar::Int{seed}).v;
+}
+
+bool ktp::noise::supported(Isa isa) {
+  return static_cast<int>(isa) <= static_cast<int>(best());
+}
@@ -0,0 +1,152 @@
+/**
+ * @file noise.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Gradient noise for the terrain generator.
+ * @version 0.1
+ * @date 2022-12-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_NOISE_HPP_)
+#define KETEMINE_SRC_NOISE_HPP_
+
+#include "chunk.hpp"
+#include "types.hpp"
+#include <array>
+#include <cstddef>
+
+namespace ktp { namespace noise {
+
+/**
+ * @brief The instruction sets with a batch kernel. AVX2 is only built when
+ *  KETEMINE_AVX2 is on, SSE2 on x86.
+ */
+enum class Isa {
+  Scalar,
+  SSE2,
+  AVX2
+};
+
+enum class Type {
+  Perlin,
+  Simplex
+};
+
+/**
+ * @brief Fractal brownian motion: several octaves of noise, every one with
+ *  a higher frequency and a lower amplitude than the previous. The result is
+ *  normalized to about [-1, 1].
+ */
+struct Fractal {
+  Type type {Type::Simplex};
+  GLint seed {1337};
+  GLint octaves {4};
+  // of the first octave, in cycles per block
+  GLfloat frequency {0.01f};
+  // frequency multiplier between octaves
+  GLfloat lacunarity {2.f};
+  // amplitude multiplier between octaves
+  GLfloat gain {0.5f};
+  // domain warping: the position is displaced by another noise before
+  // sampling, in blocks. 0 disables it
+  GLfloat warp_amplitude {0.f};
+  GLfloat warp_frequency {0.005f};
+};
+
+// a 16x16 heightmap, indexed by (z << 4) | x
+using Column = std::array<GLfloat, Chunk::size * Chunk::size>;
+// a 16x16x16 density field, indexed by Chunk::index()
+using Section = std::array<GLfloat, Chunk::volume>;
+
+/**
+ * @brief Measures the throughput of a batch kernel filling sections.
+ * @param fractal The noise to sample.
+ * @param isa The kernel. Must be supported.
+ * @return The samples per second.
+ */
+GLdouble benchmark(const Fractal& fractal, Isa isa);
+
+/**
+ * @return The widest kernel in the build.
+ */
+Isa best();
+
+/**
+ * @param fractal The noise to sample.
+ * @return The 2D fractal noise at a position, with the scalar kernel.
+ */
+GLfloat fbm(const Fractal& fractal, GLfloat x, GLfloat y);
+
+/**
+ * @param fractal The noise to sample.
+ * @return The 3D fractal noise at a position, with the scalar kernel.
+ */
+GLfloat fbm(const Fractal& fractal, GLfloat x, GLfloat y, GLfloat z);
+
+/**
+ * @brief Samples 2D noise at the blocks of a chunk column, x and z in world coordinates.
+ * @param fractal The noise to sample.
+ * @param x The world x of the first block.
+ * @param z The world z of the first block.
+ * @param column Gets the samples.
+ * @param isa The kernel. Must be supported.
+ */
+void fillColumn(const Fractal& fractal, GLint x, GLint z, Column& column, Isa isa = best());
+
+/**
+ * @brief Samples 3D noise at the blocks of a chunk section.
+ * @param fractal The noise to sample.
+ * @param origin The world position of the first block.
+ * @param section Gets the samples.
+ * @param isa The kernel. Must be supported.
+ */
+void fillSection(const Fractal& fractal, const ChunkPos& origin, Section& section, Isa isa = best());
+
+/**
+ * @return The name of an instruction set.
+ */
+const char* name(Isa isa);
+
+/**
+ * @return Classic 2D Perlin noise at a position, in about [-1, 1].
+ */
+GLfloat perlin(GLfloat x, GLfloat y, GLint seed);
+
+/**
+ * @return Classic 3D Perlin noise at a position, in about [-1, 1].
+ */
+GLfloat perlin(GLfloat x, GLfloat y, GLfloat z, GLint seed);
+
+/**
+ * @brief Samples fractal noise at many positions, given as a structure of arrays.
+ * @param fractal The noise to sample.
+ * @param x The x of every position.
+ * @param y The y of every position.
+ * @param z The z of every position, or nullptr for 2D noise.
+ * @param count The number of positions.
+ * @param out Gets the samples.
+ * @param isa The kernel. Must be supported. The positions that don't fill a
+ *  whole register are sampled with the scalar kernel.
+ */
+void sample(const Fractal& fractal, const GLfloat* x, const GLfloat* y, const GLfloat* z, std::size_t count, GLfloat* out, Isa isa = best());
+
+/**
+ * @return 2D simplex noise at a position, in about [-1, 1].
+ */
+GLfloat simplex(GLfloat x, GLfloat y, GLint seed);
+
+/**
+ * @return 3D simplex noise at a position, in about [-1, 1].
+ */
+GLfloat simplex(GLfloat x, GLfloat y, GLfloat z, GLint seed);
+
+/**
+ * @return True if the kernel is in the build.
+ */
+bool supported(Isa isa);
+
+} } // namespace noise/ktp
+
+#endif // KETEMINE_SRC_NOISE_HPP_
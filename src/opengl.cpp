@@ -1,7 +1,11 @@
 #include "opengl.hpp"
 
 #include <glm/common.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <string>
 
 GLenum ktp::glCheckError_(const char* file, int line) {
@@ -66,6 +70,51 @@ ktp::FloatArray ktp::cube(GLfloat size) {
   return vertices;
 }
 
+/* ShaderProgram */
+
+GLint ktp::ShaderProgram::findLocation(std::uint32_t hash) const {
+  if (!m_uniforms) return -1;
+  const auto found {std::lower_bound(m_uniforms->cbegin(), m_uniforms->cend(), hash, [](const UniformInfo& uniform, std::uint32_t value) {
+    return uniform.hash < value;
+  })};
+  if (found == m_uniforms->cend() || found->hash != hash) return -1;
+  return found->location;
+}
+
+ktp::UniformCache ktp::ShaderProgram::reflectUniforms(GLuint program) {
+  UniformCache uniforms {};
+  GLint count {}, max_name_length {};
+  glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+  glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_name_length);
+  std::string name(static_cast<std::size_t>(max_name_length), '\0');
+  const GLenum properties[] {GL_BLOCK_INDEX, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE};
+  for (GLint i = 0; i < count; ++i) {
+    GLint values[4] {};
+    glGetProgramResourceiv(program, GL_UNIFORM, static_cast<GLuint>(i), 4, properties, 4, nullptr, values);
+    // uniforms in blocks are set through buffers
+    if (values[0] != -1) continue;
+    GLsizei length {};
+    glGetProgramResourceName(program, GL_UNIFORM, static_cast<GLuint>(i), max_name_length, &length, name.data());
+    std::string_view uniform_name {name.data(), static_cast<std::size_t>(length)};
+    const UniformInfo info {hashName(uniform_name), values[1], static_cast<GLenum>(values[2]), values[3]};
+    uniforms.push_back(info);
+    // arrays are reported as "name[0]", make them reachable as "name" too
+    if (uniform_name.ends_with("[0]")) {
+      uniform_name.remove_suffix(3);
+      uniforms.push_back({hashName(uniform_name), info.location, info.type, info.array_size});
+    }
+  }
+  std::sort(uniforms.begin(), uniforms.end(), [](const UniformInfo& a, const UniformInfo& b) { return a.hash < b.hash; });
+  const auto collision {std::adjacent_find(uniforms.cbegin(), uniforms.cend(), [](const UniformInfo& a, const UniformInfo& b) {
+    return a.hash == b.hash;
+  })};
+  if (collision != uniforms.cend()) {
+    std::cerr << "Uniform name hash collision in shader program " << program << ". Falling back to glGetUniformLocation().\n";
+    return {};
+  }
+  return uniforms;
+}
+
 /* VBO */
 
 ktp::VBO::VBO() {
@@ -84,50 +133,166 @@ ktp::EBO::EBO() {
   glGenBuffers(1, &m_id);
 }
 
-void ktp::EBO::generateEBO(FloatArray& vertices, UintArray& indices) {
-  FloatArray unique_coords {};
+// hashes the bits of a vertex, treating -0.f and 0.f as the same value
+static std::size_t hashVertex(const GLfloat* vertex, std::size_t stride) {
+  std::size_t hash {14695981039346656037ull};
+  for (std::size_t i = 0; i < stride; ++i) {
+    // -0.f + 0.f is 0.f
+    const GLfloat value {vertex[i] + 0.f};
+    hash = (hash ^ std::bit_cast<std::uint32_t>(value)) * 1099511628211ull;
+  }
+  return hash ^ (hash >> 32);
+}
+
+void ktp::EBO::generateEBO(FloatArray& vertices, UintArray& indices, std::size_t stride) {
   indices.clear();
-  // push the first element
-  indices.push_back(0);
-  // push the first three coords
-  unique_coords.push_back(vertices[0]);
-  unique_coords.push_back(vertices[1]);
-  unique_coords.push_back(vertices[2]);
-  // find repeated coords by groups of 3
-  for (std::size_t i = 3; i < vertices.size(); i += 3) {
-    bool found {false};
-    for (std::size_t j = 0; j < unique_coords.size(); j += 3) {
-      if (vertices[i] == unique_coords[j] && vertices[i + 1] == unique_coords[j + 1] && vertices[i + 2] == unique_coords[j + 2]) {
-        // coord already in the list
-        found = true;
-        // so, new index will point to...
-        indices.push_back(j / 3u);
+  if (stride == 0 || vertices.size() < stride) return;
+  const std::size_t vertex_count {vertices.size() / stride};
+  // open addressing table holding (index + 1) of the unique vertices, 0 means empty
+  std::size_t table_size {16};
+  while (table_size < vertex_count * 2) table_size <<= 1;
+  const std::size_t mask {table_size - 1};
+  std::vector<GLuint> table(table_size, 0u);
+  FloatArray unique_vertices {};
+  unique_vertices.reserve(vertices.size());
+  indices.reserve(vertex_count);
+  for (std::size_t v = 0; v < vertex_count; ++v) {
+    const GLfloat* vertex {&vertices[v * stride]};
+    std::size_t slot {hashVertex(vertex, stride) & mask};
+    while (true) {
+      if (table[slot] == 0u) {
+        // new unique vertex
+        const auto index {static_cast<GLuint>(unique_vertices.size() / stride)};
+        unique_vertices.insert(unique_vertices.end(), vertex, vertex + stride);
+        table[slot] = index + 1u;
+        indices.push_back(index);
         break;
       }
-    }
-    if (!found) {
-      // new unique coord
-      unique_coords.push_back(vertices[i]);
-      unique_coords.push_back(vertices[i + 1]);
-      unique_coords.push_back(vertices[i + 2]);
-      // the new index points at...
-      indices.push_back((unique_coords.size() - 1u) / 3u);
+      const GLfloat* candidate {&unique_vertices[(table[slot] - 1u) * stride]};
+      if (std::equal(vertex, vertex + stride, candidate)) {
+        // vertex already in the list
+        indices.push_back(table[slot] - 1u);
+        break;
+      }
+      slot = (slot + 1) & mask;
     }
   }
   // the new vertices
-  vertices = std::move(unique_coords);
+  vertices = std::move(unique_vertices);
+}
+
+bool ktp::EBO::generateEBO(FloatArray& vertices, UshortArray& indices, std::size_t stride) {
+  FloatArray unique_vertices {vertices};
+  UintArray wide_indices {};
+  generateEBO(unique_vertices, wide_indices, stride);
+  if (stride == 0 || unique_vertices.size() / stride > std::numeric_limits<GLushort>::max() + 1u) return false;
+  indices.resize(wide_indices.size());
+  std::transform(wide_indices.cbegin(), wide_indices.cend(), indices.begin(), [](GLuint index) {
+    return static_cast<GLushort>(index);
+  });
+  vertices = std::move(unique_vertices);
+  return true;
 }
 
 void ktp::EBO::setup(const UintArray& indices, GLenum usage) {
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), usage);
+  m_type = GL_UNSIGNED_INT;
+}
+
+void ktp::EBO::setup(const UshortArray& indices, GLenum usage) {
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), usage);
+  m_type = GL_UNSIGNED_SHORT;
 }
 
 void ktp::EBO::setup(const GLuint* indices, GLsizeiptr size, GLenum usage) {
+  m_type = GL_UNSIGNED_INT;
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, usage);
 }
 
+/* UBO */
+
+ktp::UBO::UBO() {
+  glGenBuffers(1, &m_id);
+}
+
+void ktp::UBO::setup(const void* data, GLsizeiptr size, GLenum usage) {
+  glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+  glBufferData(GL_UNIFORM_BUFFER, size, data, usage);
+}
+
+/* SSBO */
+
+ktp::SSBO::SSBO() {
+  glGenBuffers(1, &m_id);
+}
+
+void ktp::SSBO::setup(const void* data, GLsizeiptr size, GLenum usage) {
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_id);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, usage);
+}
+
+/* StreamBuffer */
+
+ktp::StreamBuffer::StreamBuffer(GLsizeiptr region_size, GLuint regions):
+ m_region_size(region_size),
+ m_fences(regions, nullptr) {
+  if (!GLEW_VERSION_4_4 && !GLEW_ARB_buffer_storage) return;
+  constexpr GLbitfield flags {GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+  const auto size {region_size * regions};
+  glGenBuffers(1, &m_id);
+  glBindBuffer(GL_COPY_READ_BUFFER, m_id);
+  glBufferStorage(GL_COPY_READ_BUFFER, size, nullptr, flags);
+  m_mapped = static_cast<std::byte*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, flags));
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  if (!m_mapped) {
+    glDeleteBuffers(1, &m_id);
+    m_id = 0;
+  }
+}
+
+GLintptr ktp::StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) {
+  if (!m_mapped) return -1;
+  auto& region_fence {m_fences[m_region]};
+  if (region_fence) {
+    // the GPU may still be reading this region from the last round
+    if (glClientWaitSync(region_fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+      ++m_stalls;
+      while (glClientWaitSync(region_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(region_fence);
+    region_fence = nullptr;
+  }
+  const auto offset {(m_head + alignment - 1) / alignment * alignment};
+  if (offset + size > m_region_size) return -1;
+  m_head = offset + size;
+  return static_cast<GLintptr>(m_region * m_region_size + offset);
+}
+
+void ktp::StreamBuffer::clean() {
+  for (auto& fence: m_fences) {
+    if (fence) glDeleteSync(fence);
+    fence = nullptr;
+  }
+  if (m_id) {
+    glBindBuffer(GL_COPY_READ_BUFFER, m_id);
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &m_id);
+  }
+  m_id = 0;
+  m_mapped = nullptr;
+}
+
+void ktp::StreamBuffer::fence() {
+  if (!m_mapped || m_head == 0) return;
+  m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  m_region = (m_region + 1) % static_cast<GLuint>(m_fences.size());
+  m_head = 0;
+}
+
 /* VAO */
 
 ktp::VAO::VAO() {
@@ -159,3 +324,27 @@ void ktp::VAO::linkAttribFast(GLuint layout, GLuint components, GLenum type, GLs
     offset        // pointer: specifies a offset of the first component of the first generic vertex attribute in the array in the data store
   );
 }
+
+void ktp::VAO::linkAttribI(const VBO& vbo, GLuint layout, GLuint components, GLenum type, GLsizeiptr stride, void* offset) const {
+  glBindVertexArray(m_id);
+  vbo.bind();
+  glEnableVertexAttribArray(layout);
+  glVertexAttribIPointer(
+    layout,       // index: specifies the index of the generic vertex attribute to be modified. Must match the layout in the shader
+    components,   // size: specifies the number of components per generic vertex attribute. Must be 1, 2, 3, 4.
+    type,         // type of the data, must be an integer type
+    static_cast<GLsizei>(stride), // stride: specifies the byte offset between consecutive generic vertex attributes
+    offset        // pointer: specifies a offset of the first component of the first generic vertex attribute in the array in the data store
+  );
+}
+
+void ktp::VAO::linkAttribIFast(GLuint layout, GLuint components, GLenum type, GLsizeiptr stride, void* offset) const {
+  glEnableVertexAttribArray(layout);
+  glVertexAttribIPointer(
+    layout,       // index: specifies the index of the generic vertex attribute to be modified. Must match the layout in the shader
+    components,   // size: specifies the number of components per generic vertex attribute. Must be 1, 2, 3, 4.
+    type,         // type of the data, must be an integer type
+    static_cast<GLsizei>(stride), // stride: specifies the byte offset between consecutive generic vertex attributes
+    offset        // pointer: specifies a offset of the first component of the first generic vertex attribute in the array in the data store
+  );
+}
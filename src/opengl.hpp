@@ -14,7 +14,16 @@
 
 #include "types.hpp"
 #include <GL/glew.h>
+#include <glm/mat2x2.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 namespace ktp {
 
@@ -31,8 +40,52 @@ GLenum glCheckError_(const char* file, int line);
  */
 FloatArray cube(GLfloat size = 1.f);
 
+/**
+ * @brief FNV-1a hash of a name. Usable at compile time.
+ * @param name The name to hash.
+ * @return The 32 bit hash.
+ */
+constexpr std::uint32_t hashName(std::string_view name) {
+  std::uint32_t hash {2166136261u};
+  for (const auto c: name) hash = (hash ^ static_cast<std::uint8_t>(c)) * 16777619u;
+  return hash;
+}
+
+/**
+ * @brief A uniform name hashed at compile time. Only string literals allowed.
+ */
+struct UniformName {
+  consteval UniformName(const char* literal): name(literal), hash(hashName(literal)) {}
+  // kept for the programs without a cache, it's a literal so it never dangles
+  const char* name;
+  std::uint32_t hash;
+};
+
+/**
+ * @brief A resolved uniform location. Get it once with ShaderProgram::uniform().
+ */
+struct UniformHandle {
+  GLint location {-1};
+  bool valid() const { return location >= 0; }
+};
+
+/**
+ * @brief An active uniform of a shader program, as reflected at link time.
+ */
+struct UniformInfo {
+  std::uint32_t hash {};
+  GLint location {-1};
+  GLenum type {};
+  GLint array_size {};
+};
+
+// the active uniforms of a program sorted by hash
+using UniformCache = std::vector<UniformInfo>;
+
 /**
  * @brief A wrapper for an OpenGL shader program.
+ *  If a UniformCache is provided the uniform locations come from it, so
+ *  setting uniforms never asks the driver for the location.
  */
 class ShaderProgram {
 
@@ -40,17 +93,40 @@ class ShaderProgram {
 
   ShaderProgram() = default;
   ShaderProgram(GLuint id): m_id(id) {}
+  ShaderProgram(GLuint id, const UniformCache* uniforms): m_id(id), m_uniforms(uniforms) {}
   /**
    * @return The id of the shader program.
    */
   auto id() const { return m_id; }
 
   /**
-   * @brief Gets the uniform location.
+   * @brief Gets the uniform location. Uses the cache when present.
    * @param name The name of the uniform.
-   * @return The id of the uniform.
+   * @return The id of the uniform, -1 if not found.
+   */
+  GLint getUniformLocation(const char* name) const {
+    if (!m_uniforms) return glGetUniformLocation(m_id, name);
+    return findLocation(hashName(name));
+  }
+
+  /**
+   * @brief Queries every active uniform of a linked program. Uniforms inside
+   *  blocks have no location and are left out.
+   * @param program The id of the shader program.
+   * @return The uniforms sorted by name hash. Empty if two names share a hash.
    */
-  auto getUniformLocation(const char* name) const { return glGetUniformLocation(m_id, name); }
+  static UniformCache reflectUniforms(GLuint program);
+
+  /**
+   * @brief Gets a handle to a uniform, to use with the handle setters.
+   * @param name The name of the uniform, hashed at compile time.
+   * @return The handle, invalid if the uniform is not active. Without a cache
+   *  the location is queried to the driver by name.
+   */
+  UniformHandle uniform(UniformName name) const {
+    if (!m_uniforms) return {glGetUniformLocation(m_id, name.name)};
+    return {findLocation(name.hash)};
+  }
 
   /**
    * @brief Sets a boolean uniform. Uses glUniform1i()
@@ -58,7 +134,7 @@ class ShaderProgram {
    * @param value The value to be set.
    */
   void setBool(const char* name, bool value) const {
-    glUniform1i(glGetUniformLocation(m_id, name), (int)value);
+    glUniform1i(getUniformLocation(name), (int)value);
   }
 
   /**
@@ -67,7 +143,7 @@ class ShaderProgram {
    * @param value The value to be set.
    */
   void setInt(const char* name, GLint value) const {
-    glUniform1i(glGetUniformLocation(m_id, name), value);
+    glUniform1i(getUniformLocation(name), value);
   }
 
   /**
@@ -76,7 +152,7 @@ class ShaderProgram {
    * @param value The value to be set.
    */
   void setFloat(const char* name, GLfloat value) const {
-    glUniform1f(glGetUniformLocation(m_id, name), value);
+    glUniform1f(getUniformLocation(name), value);
   }
 
   /**
@@ -85,7 +161,7 @@ class ShaderProgram {
    * @param value A pointer to the values to be set.
    */
   void setFloat4(const char* name, const GLfloat* value) const {
-    glUniform4f(glGetUniformLocation(m_id, name), value[0], value[1], value[2], value[3]);
+    glUniform4f(getUniformLocation(name), value[0], value[1], value[2], value[3]);
   }
 
   /**
@@ -94,7 +170,7 @@ class ShaderProgram {
    * @param value A pointer to the values to be set.
    */
   void setMat2f(const char* name, const GLfloat* value, GLboolean transpose = GL_FALSE) const {
-    glUniformMatrix2fv(glGetUniformLocation(m_id, name), 1, transpose, value);
+    glUniformMatrix2fv(getUniformLocation(name), 1, transpose, value);
   }
 
   /**
@@ -103,7 +179,7 @@ class ShaderProgram {
    * @param value A pointer to the values to be set.
    */
   void setMat3f(const char* name, const GLfloat* value, GLboolean transpose = GL_FALSE) const {
-    glUniformMatrix3fv(glGetUniformLocation(m_id, name), 1, transpose, value);
+    glUniformMatrix3fv(getUniformLocation(name), 1, transpose, value);
   }
 
   /**
@@ -112,7 +188,7 @@ class ShaderProgram {
    * @param value A pointer to the values to be set.
    */
   void setMat4f(const char* name, const GLfloat* value, GLboolean transpose = GL_FALSE) const {
-    glUniformMatrix4fv(glGetUniformLocation(m_id, name), 1, transpose, value);
+    glUniformMatrix4fv(getUniformLocation(name), 1, transpose, value);
   }
 
   /**
@@ -121,7 +197,7 @@ class ShaderProgram {
    * @param value The value to be set.
    */
   void setUint(const char* name, GLuint value) const {
-    glUniform1ui(glGetUniformLocation(m_id, name), value);
+    glUniform1ui(getUniformLocation(name), value);
   }
 
   /**
@@ -130,7 +206,7 @@ class ShaderProgram {
    * @param value A pointer to the values to be set.
    */
   void setVec2(const char* name, const GLfloat* value) const {
-    glUniform2fv(glGetUniformLocation(m_id, name), 1, value);
+    glUniform2fv(getUniformLocation(name), 1, value);
   }
 
   /**
@@ -140,7 +216,7 @@ class ShaderProgram {
    * @param y value.
    */
   void setVec2(const char* name, GLfloat x, GLfloat y) const {
-    glUniform2f(glGetUniformLocation(m_id, name), x, y);
+    glUniform2f(getUniformLocation(name), x, y);
   }
 
   /**
@@ -149,7 +225,7 @@ class ShaderProgram {
    * @param value A pointer to the values to be set.
    */
   void setVec3(const char* name, const GLfloat* value) const {
-    glUniform3fv(glGetUniformLocation(m_id, name), 1, value);
+    glUniform3fv(getUniformLocation(name), 1, value);
   }
 
   /**
@@ -160,7 +236,7 @@ class ShaderProgram {
    * @param z value.
    */
   void setVec3(const char* name, GLfloat x, GLfloat y, GLfloat z) const {
-    glUniform3f(glGetUniformLocation(m_id, name), x, y, z);
+    glUniform3f(getUniformLocation(name), x, y, z);
   }
 
   /**
@@ -169,7 +245,7 @@ class ShaderProgram {
    * @param value A pointer to the values to be set.
    */
   void setVec4(const char* name, const GLfloat* value) const {
-    glUniform4fv(glGetUniformLocation(m_id, name), 1, value);
+    glUniform4fv(getUniformLocation(name), 1, value);
   }
 
   /**
@@ -181,7 +257,139 @@ class ShaderProgram {
    * @param w value.
    */
   void setVec4(const char* name, GLfloat x, GLfloat y, GLfloat z, GLfloat w) const {
-    glUniform4f(glGetUniformLocation(m_id, name), x, y, z, w);
+    glUniform4f(getUniformLocation(name), x, y, z, w);
+  }
+
+  /**
+   * @brief Sets a boolean uniform. Uses glUniform1i()
+   * @param uniform The handle of the uniform.
+   * @param value The value to be set.
+   */
+  void setBool(UniformHandle uniform, bool value) const {
+    glUniform1i(uniform.location, (int)value);
+  }
+
+  /**
+   * @brief Sets an int uniform. Uses glUniform1i()
+   * @param uniform The handle of the uniform.
+   * @param value The value to be set.
+   */
+  void setInt(UniformHandle uniform, GLint value) const {
+    glUniform1i(uniform.location, value);
+  }
+
+  /**
+   * @brief Sets a float uniform. Uses glUniform1f()
+   * @param uniform The handle of the uniform.
+   * @param value The value to be set.
+   */
+  void setFloat(UniformHandle uniform, GLfloat value) const {
+    glUniform1f(uniform.location, value);
+  }
+
+  /**
+   * @brief Sets a vec4 of floats uniform. Uses glUniform4f()
+   * @param uniform The handle of the uniform.
+   * @param value A pointer to the values to be set.
+   */
+  void setFloat4(UniformHandle uniform, const GLfloat* value) const {
+    glUniform4f(uniform.location, value[0], value[1], value[2], value[3]);
+  }
+
+  /**
+   * @brief Sets a 2x2 matrix uniform. Uses glUniformMatrix2fv()
+   * @param uniform The handle of the uniform.
+   * @param value A pointer to the values to be set.
+   */
+  void setMat2f(UniformHandle uniform, const GLfloat* value, GLboolean transpose = GL_FALSE) const {
+    glUniformMatrix2fv(uniform.location, 1, transpose, value);
+  }
+
+  /**
+   * @brief Sets a 3x3 matrix uniform. Uses glUniformMatrix3fv()
+   * @param uniform The handle of the uniform.
+   * @param value A pointer to the values to be set.
+   */
+  void setMat3f(UniformHandle uniform, const GLfloat* value, GLboolean transpose = GL_FALSE) const {
+    glUniformMatrix3fv(uniform.location, 1, transpose, value);
+  }
+
+  /**
+   * @brief Sets a 4x4 matrix uniform. Uses glUniformMatrix4fv()
+   * @param uniform The handle of the uniform.
+   * @param value A pointer to the values to be set.
+   */
+  void setMat4f(UniformHandle uniform, const GLfloat* value, GLboolean transpose = GL_FALSE) const {
+    glUniformMatrix4fv(uniform.location, 1, transpose, value);
+  }
+
+  /**
+   * @brief Sets an unsigned int uniform. Uses glUniform1ui()
+   * @param uniform The handle of the uniform.
+   * @param value The value to be set.
+   */
+  void setUint(UniformHandle uniform, GLuint value) const {
+    glUniform1ui(uniform.location, value);
+  }
+
+  /**
+   * @brief Sets a 2 component vector uniform. Uses glUniform2fv()
+   * @param uniform The handle of the uniform.
+   * @param value A pointer to the values to be set.
+   */
+  void setVec2(UniformHandle uniform, const GLfloat* value) const {
+    glUniform2fv(uniform.location, 1, value);
+  }
+
+  /**
+   * @brief Sets a 2 component vector uniform. Uses glUniform2f()
+   * @param uniform The handle of the uniform.
+   * @param x value.
+   * @param y value.
+   */
+  void setVec2(UniformHandle uniform, GLfloat x, GLfloat y) const {
+    glUniform2f(uniform.location, x, y);
+  }
+
+  /**
+   * @brief Sets a 3 component vector uniform. Uses glUniform3fv()
+   * @param uniform The handle of the uniform.
+   * @param value A pointer to the values to be set.
+   */
+  void setVec3(UniformHandle uniform, const GLfloat* value) const {
+    glUniform3fv(uniform.location, 1, value);
+  }
+
+  /**
+   * @brief Sets a 3 component vector uniform. Uses glUniform3f()
+   * @param uniform The handle of the uniform.
+   * @param x value.
+   * @param y value.
+   * @param z value.
+   */
+  void setVec3(UniformHandle uniform, GLfloat x, GLfloat y, GLfloat z) const {
+    glUniform3f(uniform.location, x, y, z);
+  }
+
+  /**
+   * @brief Sets a 4 component vector uniform. Uses glUniform4fv()
+   * @param uniform The handle of the uniform.
+   * @param value A pointer to the values to be set.
+   */
+  void setVec4(UniformHandle uniform, const GLfloat* value) const {
+    glUniform4fv(uniform.location, 1, value);
+  }
+
+  /**
+   * @brief Sets a 4 component vector uniform. Uses glUniform4f()
+   * @param uniform The handle of the uniform.
+   * @param x value.
+   * @param y value.
+   * @param z value.
+   * @param w value.
+   */
+  void setVec4(UniformHandle uniform, GLfloat x, GLfloat y, GLfloat z, GLfloat w) const {
+    glUniform4f(uniform.location, x, y, z, w);
   }
 
   /**
@@ -191,7 +399,14 @@ class ShaderProgram {
 
  private:
 
+  /**
+   * @brief Binary search of a hash in the cache.
+   * @return The location of the uniform, -1 if not found.
+   */
+  GLint findLocation(std::uint32_t hash) const;
+
   GLuint m_id {};
+  const UniformCache* m_uniforms {nullptr};
 };
 
 /**
@@ -219,6 +434,11 @@ class VBO {
    */
   void bind() const { glBindBuffer(GL_ARRAY_BUFFER, m_id); }
 
+  /**
+   * @return The OpenGL name of the buffer, to bind it as another target.
+   */
+  auto id() const { return m_id; }
+
   /**
    * @brief Sets up the data for the buffer.
    * @param vertices A pointer to an array of floats to use as data.
@@ -307,16 +527,29 @@ class EBO {
     if (this != &other) {
       if (m_id) glDeleteBuffers(1, &m_id);
       m_id = std::exchange(other.m_id, 0);
+      m_type = other.m_type;
     }
     return *this;
   }
 
   /**
-   * @brief Generates an EBO by removing duplicate coordinates and creating an index array.
-   * @param vertices Vector of vertices.
+   * @brief Generates an EBO by removing duplicate vertices and creating an index array.
+   *  Runs in linear time using a hash table over the vertex attributes.
+   * @param vertices Vector of interleaved vertex attributes.
    * @param indices Vector of indices.
+   * @param stride The number of floats per vertex, default 3 (xyz only).
    */
-  static void generateEBO(FloatArray& vertices, UintArray& indices);
+  static void generateEBO(FloatArray& vertices, UintArray& indices, std::size_t stride = 3);
+
+  /**
+   * @brief Generates an EBO with 16 bit indices by removing duplicate vertices.
+   *  If the unique vertices don't fit in 16 bit indices nothing is modified.
+   * @param vertices Vector of interleaved vertex attributes.
+   * @param indices Vector of indices.
+   * @param stride The number of floats per vertex, default 3 (xyz only).
+   * @return True if the indices fit in 16 bits. False otherwise.
+   */
+  static bool generateEBO(FloatArray& vertices, UshortArray& indices, std::size_t stride = 3);
 
   /**
    * @brief Binds the EBO.
@@ -329,6 +562,12 @@ class EBO {
    */
   void setup(const UintArray& indices, GLenum usage = GL_STATIC_DRAW);
 
+  /**
+   * @brief Sets up the data for the buffer.
+   * @param vertices A std::vector of ushorts to use as data.
+   */
+  void setup(const UshortArray& indices, GLenum usage = GL_STATIC_DRAW);
+
   /**
    * @brief Sets up the data for the buffer.
    * @param indices A pointer to an array of unsigned ints to use as data.
@@ -336,6 +575,12 @@ class EBO {
    */
   void setup(const GLuint* indices, GLsizeiptr size, GLenum usage = GL_STATIC_DRAW);
 
+  /**
+   * @return The type of the indices last uploaded, GL_UNSIGNED_INT or GL_UNSIGNED_SHORT.
+   *  Use it as the type parameter of glDrawElements().
+   */
+  auto type() const { return m_type; }
+
   /**
    * @brief Unbinds the EBO.
    */
@@ -344,6 +589,330 @@ class EBO {
  private:
 
   GLuint m_id {};
+  GLenum m_type {GL_UNSIGNED_INT};
+};
+
+/**
+ * @brief Compile time checks of the layout of the buffer blocks shared with
+ *  the shaders. A C++ struct mirrors a GLSL block only if every member starts
+ *  at the base alignment of its GLSL type and takes as many bytes as GLSL
+ *  expects. Use KTP_STD140_MEMBER and KTP_STD430_MEMBER after the struct.
+ */
+namespace layout {
+
+enum class Rule { std140, std430 };
+
+constexpr std::size_t roundUp(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+template <std::size_t Alignment, std::size_t Size>
+struct BasicTraits {
+  static constexpr std::size_t alignment {Alignment};
+  static constexpr std::size_t size {Size};
+};
+
+/**
+ * @brief The base alignment and the size in bytes of a GLSL type inside a
+ *  block. Types without a specialization are not allowed in a block.
+ * @tparam R The layout rule of the block.
+ * @tparam T The C++ type of the member.
+ */
+template <Rule R, typename T>
+struct Traits;
+
+template <Rule R> struct Traits<R, GLfloat>: BasicTraits<4, 4> {};
+template <Rule R> struct Traits<R, GLint>: BasicTraits<4, 4> {};
+template <Rule R> struct Traits<R, GLuint>: BasicTraits<4, 4> {};
+template <Rule R> struct Traits<R, glm::vec2>: BasicTraits<8, 8> {};
+template <Rule R> struct Traits<R, glm::ivec2>: BasicTraits<8, 8> {};
+template <Rule R> struct Traits<R, glm::uvec2>: BasicTraits<8, 8> {};
+// a vec3 is aligned as a vec4, but a scalar can follow in the last 4 bytes
+template <Rule R> struct Traits<R, glm::vec3>: BasicTraits<16, 12> {};
+template <Rule R> struct Traits<R, glm::ivec3>: BasicTraits<16, 12> {};
+template <Rule R> struct Traits<R, glm::uvec3>: BasicTraits<16, 12> {};
+template <Rule R> struct Traits<R, glm::vec4>: BasicTraits<16, 16> {};
+template <Rule R> struct Traits<R, glm::ivec4>: BasicTraits<16, 16> {};
+template <Rule R> struct Traits<R, glm::uvec4>: BasicTraits<16, 16> {};
+// matrices are arrays of columns
+template <Rule R> struct Traits<R, glm::mat2>: BasicTraits<R == Rule::std140 ? 16 : 8, R == Rule::std140 ? 32 : 16> {};
+template <Rule R> struct Traits<R, glm::mat3>: BasicTraits<16, 48> {};
+template <Rule R> struct Traits<R, glm::mat4>: BasicTraits<16, 64> {};
+
+// std140 rounds the alignment and the stride of arrays up to a vec4, std430 doesn't
+template <Rule R, typename T, std::size_t N>
+struct Traits<R, T[N]> {
+  static constexpr std::size_t alignment {R == Rule::std140 ? roundUp(Traits<R, T>::alignment, 16) : Traits<R, T>::alignment};
+  static constexpr std::size_t size {roundUp(Traits<R, T>::size, alignment) * N};
+};
+
+template <Rule R, typename T, std::size_t N>
+struct Traits<R, std::array<T, N>>: Traits<R, T[N]> {};
+
+/**
+ * @brief Checks a member of a block.
+ * @tparam R The layout rule of the block.
+ * @tparam T The C++ type of the member.
+ * @param offset The offset of the member in the C++ struct.
+ * @return True if the member is where GLSL expects it and has the size GLSL expects.
+ */
+template <Rule R, typename T>
+constexpr bool matches(std::size_t offset) {
+  return offset % Traits<R, T>::alignment == 0 && sizeof(T) == Traits<R, T>::size;
+}
+
+} // namespace layout
+
+#define KTP_STD140_MEMBER(block, member) \
+  static_assert(ktp::layout::matches<ktp::layout::Rule::std140, decltype(block::member)>(offsetof(block, member)), \
+    #block "::" #member " doesn't follow the std140 layout")
+
+#define KTP_STD430_MEMBER(block, member) \
+  static_assert(ktp::layout::matches<ktp::layout::Rule::std430, decltype(block::member)>(offsetof(block, member)), \
+    #block "::" #member " doesn't follow the std430 layout")
+
+/**
+ * @brief A RAII uniform buffer object wrapper.
+ */
+class UBO {
+
+ public:
+
+  UBO();
+  UBO(const UBO& other) = delete;
+  UBO(UBO&& other) { *this = std::move(other); }
+  ~UBO() { if (m_id) glDeleteBuffers(1, &m_id); }
+  UBO& operator=(const UBO& other) = delete;
+  UBO& operator=(UBO&& other) {
+    if (this != &other) {
+      if (m_id) glDeleteBuffers(1, &m_id);
+      m_id = std::exchange(other.m_id, 0);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Binds the UBO.
+   */
+  void bind() const { glBindBuffer(GL_UNIFORM_BUFFER, m_id); }
+
+  /**
+   * @brief Binds the UBO to an indexed binding point, where every program
+   *  with a block using that binding reads it.
+   * @param binding The binding point.
+   */
+  void bindBase(GLuint binding) const { glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_id); }
+
+  /**
+   * @brief Sets up the data for the buffer.
+   * @param data A pointer to the data, or nullptr to just allocate it.
+   * @param size The size in bytes of the data.
+   * @param usage The usage type, default GL_DYNAMIC_DRAW.
+   */
+  void setup(const void* data, GLsizeiptr size, GLenum usage = GL_DYNAMIC_DRAW);
+
+  /**
+   * @brief Sets up the data for the buffer.
+   * @tparam T A struct following the std140 layout.
+   * @param block The data.
+   * @param usage The usage type, default GL_DYNAMIC_DRAW.
+   */
+  template <typename T>
+  void setup(const T& block, GLenum usage = GL_DYNAMIC_DRAW) {
+    setup(&block, sizeof(T), usage);
+  }
+
+  /**
+   * @brief Replaces the data of the buffer without reallocating the data store.
+   * @tparam T A struct following the std140 layout.
+   * @param block The data.
+   * @param offset The offset into the data store, measured in bytes.
+   */
+  template <typename T>
+  void setupSubData(const T& block, GLintptr offset = 0) {
+    glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(T), &block);
+  }
+
+  /**
+   * @brief Unbinds the UBO.
+   */
+  void unbind() const { glBindBuffer(GL_UNIFORM_BUFFER, 0); }
+
+ private:
+
+  GLuint m_id {};
+};
+
+/**
+ * @brief A RAII shader storage buffer object wrapper.
+ */
+class SSBO {
+
+ public:
+
+  SSBO();
+  SSBO(const SSBO& other) = delete;
+  SSBO(SSBO&& other) { *this = std::move(other); }
+  ~SSBO() { if (m_id) glDeleteBuffers(1, &m_id); }
+  SSBO& operator=(const SSBO& other) = delete;
+  SSBO& operator=(SSBO&& other) {
+    if (this != &other) {
+      if (m_id) glDeleteBuffers(1, &m_id);
+      m_id = std::exchange(other.m_id, 0);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Binds the SSBO.
+   */
+  void bind() const { glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_id); }
+
+  /**
+   * @brief Binds the SSBO to an indexed binding point.
+   * @param binding The binding point.
+   */
+  void bindBase(GLuint binding) const { glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_id); }
+
+  /**
+   * @return The OpenGL name of the buffer, to bind it as another target.
+   */
+  auto id() const { return m_id; }
+
+  /**
+   * @brief Sets up the data for the buffer.
+   * @param data A pointer to the data, or nullptr to just allocate it.
+   * @param size The size in bytes of the data.
+   * @param usage The usage type, default GL_DYNAMIC_DRAW.
+   */
+  void setup(const void* data, GLsizeiptr size, GLenum usage = GL_DYNAMIC_DRAW);
+
+  /**
+   * @brief Sets up the data for the buffer.
+   * @tparam T A struct following the std430 layout.
+   * @param elements A std::vector of Ts to use as data.
+   * @param usage The usage type, default GL_DYNAMIC_DRAW.
+   */
+  template <typename T>
+  void setup(const std::vector<T>& elements, GLenum usage = GL_DYNAMIC_DRAW) {
+    setup(elements.data(), static_cast<GLsizeiptr>(elements.size() * sizeof(T)), usage);
+  }
+
+  /**
+   * @brief Replaces the data of the buffer without reallocating the data store.
+   * @tparam T A struct following the std430 layout.
+   * @param elements A std::vector of Ts to use as data.
+   * @param offset The offset into the data store, measured in bytes.
+   */
+  template <typename T>
+  void setupSubData(const std::vector<T>& elements, GLintptr offset = 0) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_id);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, static_cast<GLsizeiptr>(elements.size() * sizeof(T)), elements.data());
+  }
+
+  /**
+   * @brief Unbinds the SSBO.
+   */
+  void unbind() const { glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0); }
+
+ private:
+
+  GLuint m_id {};
+};
+
+/**
+ * @brief A persistently mapped buffer split in regions used round robin, so
+ *  the CPU writes one region while the GPU still reads the others. A fence
+ *  guards every region and writing to it again waits for the GPU. Needs
+ *  OpenGL 4.4 or ARB_buffer_storage, check valid() before using it.
+ */
+class StreamBuffer {
+
+ public:
+
+  /**
+   * @brief Creates and maps the buffer, if the driver supports it.
+   * @param region_size The size in bytes of every region.
+   * @param regions The number of regions, default 3 (triple buffering).
+   */
+  StreamBuffer(GLsizeiptr region_size, GLuint regions = 3);
+  StreamBuffer(const StreamBuffer& other) = delete;
+  StreamBuffer(StreamBuffer&& other) { *this = std::move(other); }
+  ~StreamBuffer() { clean(); }
+  StreamBuffer& operator=(const StreamBuffer& other) = delete;
+  StreamBuffer& operator=(StreamBuffer&& other) {
+    if (this != &other) {
+      clean();
+      m_id = std::exchange(other.m_id, 0);
+      m_mapped = std::exchange(other.m_mapped, nullptr);
+      m_region_size = other.m_region_size;
+      m_fences = std::move(other.m_fences);
+      m_region = other.m_region;
+      m_head = other.m_head;
+      m_stalls = other.m_stalls;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Reserves space in the current region. The first allocation of a
+   *  region waits until the GPU is done with it.
+   * @param size The size in bytes to reserve.
+   * @param alignment The alignment of the returned offset, default 4.
+   * @return The offset into the buffer of the reserved space, or -1 if it doesn't
+   *  fit in what's left of the region.
+   */
+  GLintptr allocate(GLsizeiptr size, GLsizeiptr alignment = 4);
+
+  /**
+   * @param offset An offset returned by allocate().
+   * @return A pointer to the mapped memory at that offset.
+   */
+  auto data(GLintptr offset) const { return m_mapped + offset; }
+
+  /**
+   * @brief Fences the current region and moves to the next one. Call it after
+   *  issuing the commands that read what was written in the region.
+   */
+  void fence();
+
+  /**
+   * @return The OpenGL name of the buffer, bind it as GL_COPY_READ_BUFFER to copy from it.
+   */
+  auto id() const { return m_id; }
+
+  /**
+   * @return The size in bytes of every region.
+   */
+  auto regionSize() const { return m_region_size; }
+
+  /**
+   * @return How many times allocate() had to wait for the GPU.
+   */
+  auto stalls() const { return m_stalls; }
+
+  /**
+   * @return The bytes reserved so far in the current region.
+   */
+  auto used() const { return m_head; }
+
+  /**
+   * @return True if the buffer is mapped and ready to use.
+   */
+  bool valid() const { return m_mapped != nullptr; }
+
+ private:
+
+  void clean();
+
+  GLuint m_id {};
+  std::byte* m_mapped {nullptr};
+  GLsizeiptr m_region_size {};
+  std::vector<GLsync> m_fences {};
+  GLuint m_region {};
+  GLsizeiptr m_head {};
+  std::size_t m_stalls {};
 };
 
 /**
@@ -395,6 +964,38 @@ class VAO {
    */
   void linkAttribFast(GLuint layout, GLuint components, GLenum type, GLsizeiptr stride, void* offset, GLboolean normalize = GL_FALSE) const;
 
+  /**
+   * @brief Specifies how OpenGL should interpret the vertex buffer data as integers whenever a draw call is made.
+   *  Uses glVertexAttribIPointer(), so the values reach the shader unconverted. Use it with int/uint shader inputs.
+   * @param vbo The vertex buffer object to be binded.
+   * @param layout Specifies the index of the generic vertex attribute to be modified. Must match the layout in the shader.
+   * @param components Specifies the number of components per generic vertex attribute. Must be 1, 2, 3, 4.
+   * @param type Type of the data. Must be an integer type.
+   * @param stride Specifies the byte offset between consecutive generic vertex attributes.
+   * @param offset Specifies a offset of the first component of the first generic vertex attribute in the array in the data store.
+   */
+  void linkAttribI(const VBO& vbo, GLuint layout, GLuint components, GLenum type, GLsizeiptr stride, void* offset) const;
+
+  /**
+   * @brief Specifies how OpenGL should interpret the vertex buffer data as integers whenever a draw call is made. IT DOESN'T BIND ANYTHING!
+   * @param layout Specifies the index of the generic vertex attribute to be modified. Must match the layout in the shader.
+   * @param components Specifies the number of components per generic vertex attribute. Must be 1, 2, 3, 4.
+   * @param type Type of the data. Must be an integer type.
+   * @param stride Specifies the byte offset between consecutive generic vertex attributes.
+   * @param offset Specifies a offset of the first component of the first generic vertex attribute in the array in the data store.
+   */
+  void linkAttribIFast(GLuint layout, GLuint components, GLenum type, GLsizeiptr stride, void* offset) const;
+
+  /**
+   * @brief Sets how often a vertex attribute advances. Binds the VAO.
+   * @param layout The index of the generic vertex attribute.
+   * @param divisor 0 to advance every vertex, N to advance every N instances.
+   */
+  void setDivisor(GLuint layout, GLuint divisor) const {
+    glBindVertexArray(m_id);
+    glVertexAttribDivisor(layout, divisor);
+  }
+
   /**
    * @brief Unbinds the VAO.
    */
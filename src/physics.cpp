@@ -0,0 +1,296 @@
+#include "physics.hpp"
+
+#include "chunk.hpp"
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+ktp::physics::Settings ktp::physics::settings {};
+ktp::physics::Stats ktp::physics::stats {};
+
+namespace {
+
+using namespace ktp;
+
+// faces closer than this to a block are touching it, not inside it
+constexpr GLfloat epsilon {1e-3f};
+
+// the player, only touched by the ticker while it runs
+physics::Body player {};
+// a copy of it for everyone else, published by sync()
+physics::Body published {};
+// the two last states, published by sync()
+Point3D previous {}, current {};
+// simulation time not ticked yet
+GLfloat accumulator {};
+// interpolation of the frame, drawn after the next sync() like the states
+GLfloat pending_alpha {};
+
+// what the ticker leaves for sync()
+struct Result {
+  Point3D previous {};
+  Point3D current {};
+  std::size_t ticks {};
+  GLdouble ms {};
+};
+
+// the ticks update() hands to the ticker
+struct Work {
+  const World* world {nullptr};
+  physics::Input input {};
+  std::size_t ticks {};
+  physics::Settings config {};
+};
+
+Result result {};
+// set by update() when it started ticks, cleared by sync()
+bool running {false};
+
+// The ticker is a thread of its own instead of a job: the job queues are
+// full of chunks to generate, light and mesh while streaming, the ticks
+// would wait behind them and sync() would end up running those on the main
+// thread. Without it, see init(), the ticks run on the calling thread.
+std::thread ticker {};
+// guards the three below, changed is notified when any of them changes
+std::mutex ticker_mutex {};
+std::condition_variable ticker_changed {};
+Work work {};
+// work is waiting or being ticked
+bool queued {false};
+bool stopping {false};
+
+void offset(physics::AABB& box, int axis, GLfloat distance) {
+  box.min[axis] += distance;
+  box.max[axis] += distance;
+}
+
+// the blocks a box covers on an axis, not the ones it only touches
+void span(const physics::AABB& box, int axis, GLint& first, GLint& last) {
+  first = static_cast<GLint>(std::floor(box.min[axis] + epsilon));
+  last = static_cast<GLint>(std::floor(box.max[axis] - epsilon));
+}
+
+// true if any block under the box in a layer of blocks across an axis is solid
+bool solidLayer(const World& world, const physics::AABB& box, int axis, GLint layer) {
+  const int a {(axis + 1) % 3}, b {(axis + 2) % 3};
+  GLint a_first {}, a_last {}, b_first {}, b_last {};
+  span(box, a, a_first, a_last);
+  span(box, b, b_first, b_last);
+  BlockPos block {};
+  block[axis] = layer;
+  for (block[a] = a_first; block[a] <= a_last; ++block[a]) {
+    for (block[b] = b_first; block[b] <= b_last; ++block[b]) {
+      if (Blocks::solid(world.getBlock(block.x, block.y, block.z))) return true;
+    }
+  }
+  return false;
+}
+
+bool overlaps(const World& world, const physics::AABB& box) {
+  GLint first {}, last {};
+  span(box, 1, first, last);
+  for (auto layer = first; layer <= last; ++layer) {
+    if (solidLayer(world, box, 1, layer)) return true;
+  }
+  return false;
+}
+
+// how far the box goes along an axis before its leading face touches a
+// solid block, checking the layers of blocks it goes through in order
+GLfloat sweep(const World& world, const physics::AABB& box, int axis, GLfloat distance) {
+  if (distance > 0.f) {
+    const auto face {box.max[axis]};
+    const auto first {static_cast<GLint>(std::ceil(face - epsilon))};
+    const auto last {static_cast<GLint>(std::ceil(face + distance)) - 1};
+    for (auto layer = first; layer <= last; ++layer) {
+      if (solidLayer(world, box, axis, layer)) return glm::max(static_cast<GLfloat>(layer) - face, 0.f);
+    }
+  } else if (distance < 0.f) {
+    const auto face {box.min[axis]};
+    const auto first {static_cast<GLint>(std::floor(face + epsilon)) - 1};
+    const auto last {static_cast<GLint>(std::floor(face + distance))};
+    for (auto layer = first; layer >= last; --layer) {
+      if (solidLayer(world, box, axis, layer)) return glm::min(static_cast<GLfloat>(layer + 1) - face, 0.f);
+    }
+  }
+  return distance;
+}
+
+// the horizontal part of a move, x then z, returns how far it went
+Vector3 slide(const World& world, physics::AABB& box, const Vector3& displacement) {
+  Vector3 moved {};
+  moved.x = sweep(world, box, 0, displacement.x);
+  offset(box, 0, moved.x);
+  moved.z = sweep(world, box, 2, displacement.z);
+  offset(box, 2, moved.z);
+  return moved;
+}
+
+bool blocked(GLfloat moved, GLfloat wanted) {
+  return std::abs(wanted - moved) > 0.f;
+}
+
+// the tick job gets a copy of the settings, the GUI changes them meanwhile
+void moveBody(const World& world, physics::Body& body, const Vector3& displacement, const physics::Settings& config) {
+  auto box {physics::bounds(body)};
+  const auto vertical {sweep(world, box, 1, displacement.y)};
+  offset(box, 1, vertical);
+  bool on_ground {displacement.y < 0.f && blocked(vertical, displacement.y)};
+
+  auto slid {box};
+  auto moved {slide(world, slid, displacement)};
+  const bool hit_wall {blocked(moved.x, displacement.x) || blocked(moved.z, displacement.z)};
+  if (hit_wall && (body.on_ground || on_ground) && config.step_height > 0.f) {
+    // tries again from higher up and comes back down, keeping it if it goes further
+    auto stepped {box};
+    const auto up {sweep(world, stepped, 1, config.step_height)};
+    offset(stepped, 1, up);
+    const auto stepped_moved {slide(world, stepped, displacement)};
+    offset(stepped, 1, sweep(world, stepped, 1, -up));
+    const auto distance {[](const Vector3& v) { return v.x * v.x + v.z * v.z; }};
+    if (distance(stepped_moved) > distance(moved)) {
+      slid = stepped;
+      moved = stepped_moved;
+      on_ground = true;
+    }
+  }
+
+  if (blocked(moved.x, displacement.x)) body.velocity.x = 0.f;
+  if (blocked(vertical, displacement.y)) body.velocity.y = 0.f;
+  if (blocked(moved.z, displacement.z)) body.velocity.z = 0.f;
+  body.on_ground = on_ground;
+  body.position = {(slid.min.x + slid.max.x) * 0.5f, slid.min.y, (slid.min.z + slid.max.z) * 0.5f};
+}
+
+void tickBody(const World& world, physics::Body& body, const physics::Input& input, const physics::Settings& config) {
+  if (overlaps(world, physics::bounds(body))) {
+    body.position.y = std::floor(body.position.y) + 1.f;
+    body.velocity = {};
+    body.on_ground = false;
+    return;
+  }
+  body.velocity.x = input.walk.x;
+  body.velocity.z = input.walk.z;
+  if (input.jump && body.on_ground) body.velocity.y = config.jump_speed;
+  body.velocity.y = glm::max(body.velocity.y - config.gravity * physics::tick_time, -config.max_fall_speed);
+  moveBody(world, body, body.velocity * physics::tick_time, config);
+}
+
+void runTicks(const Work& ticks) {
+  const auto start {std::chrono::steady_clock::now()};
+  for (std::size_t i = 0; i < ticks.ticks; ++i) {
+    result.previous = player.position;
+    tickBody(*ticks.world, player, ticks.input, ticks.config);
+  }
+  result.current = player.position;
+  result.ticks = ticks.ticks;
+  result.ms = std::chrono::duration<GLdouble, std::milli>{std::chrono::steady_clock::now() - start}.count();
+}
+
+void tickerLoop() {
+  std::unique_lock lock {ticker_mutex};
+  while (true) {
+    ticker_changed.wait(lock, [] { return stopping || queued; });
+    if (!queued) return;
+    const auto ticks {work};
+    lock.unlock();
+    runTicks(ticks);
+    lock.lock();
+    queued = false;
+    ticker_changed.notify_all();
+  }
+}
+
+} // namespace
+
+ktp::physics::AABB ktp::physics::bounds(const Body& body) {
+  const Vector3 extent {body.half_width, 0.f, body.half_width};
+  return {body.position - extent, body.position + extent + Vector3{0.f, body.height, 0.f}};
+}
+
+const ktp::physics::Body& ktp::physics::body() {
+  return published;
+}
+
+void ktp::physics::init() {
+  if (ticker.joinable()) return;
+  stopping = false;
+  ticker = std::thread{tickerLoop};
+}
+
+void ktp::physics::move(const World& world, Body& body, const Vector3& displacement) {
+  moveBody(world, body, displacement, settings);
+}
+
+ktp::Point3D ktp::physics::position() {
+  return glm::mix(previous, current, stats.alpha);
+}
+
+void ktp::physics::shutdown() {
+  sync();
+  if (!ticker.joinable()) return;
+  {
+    std::lock_guard lock {ticker_mutex};
+    stopping = true;
+  }
+  ticker_changed.notify_all();
+  ticker.join();
+}
+
+void ktp::physics::sync() {
+  if (running) {
+    // only waits, the ticker has nothing else to run before the ticks
+    std::unique_lock lock {ticker_mutex};
+    ticker_changed.wait(lock, [] { return !queued; });
+    running = false;
+    published = player;
+    previous = result.previous;
+    current = result.current;
+    stats.ticks = result.ticks;
+    stats.tick_ms = result.ms;
+  }
+  stats.alpha = pending_alpha;
+}
+
+void ktp::physics::teleport(const Point3D& position) {
+  player.position = position;
+  player.velocity = {};
+  player.on_ground = false;
+  published = player;
+  previous = current = position;
+}
+
+void ktp::physics::tick(const World& world, Body& body, const Input& input) {
+  tickBody(world, body, input, settings);
+}
+
+void ktp::physics::update(const World& world, const Input& input, GLfloat delta_time) {
+  sync();
+  accumulator += glm::min(delta_time, settings.max_frame_time);
+  const auto ticks {static_cast<std::size_t>(accumulator / tick_time)};
+  accumulator -= static_cast<GLfloat>(ticks) * tick_time;
+  pending_alpha = accumulator / tick_time;
+  if (ticks == 0) return;
+  // nothing to stand on yet, it waits where it is
+  const auto& p {player.position};
+  if (!world.chunk(World::chunkPosition(static_cast<GLint>(std::floor(p.x)), static_cast<GLint>(std::floor(p.y)), static_cast<GLint>(std::floor(p.z))))) {
+    previous = current = player.position;
+    return;
+  }
+  running = true;
+  const Work ticks_due {&world, input, ticks, settings};
+  if (!ticker.joinable()) {
+    runTicks(ticks_due);
+    return;
+  }
+  {
+    std::lock_guard lock {ticker_mutex};
+    work = ticks_due;
+    queued = true;
+  }
+  ticker_changed.notify_all();
+}
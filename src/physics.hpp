@@ -0,0 +1,152 @@
+/**
+ * @file physics.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Fixed timestep physics, boxes moving against the blocks.
+ * @version 0.1
+ * @date 2022-12-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_PHYSICS_HPP_)
+#define KETEMINE_SRC_PHYSICS_HPP_
+
+#include "types.hpp"
+#include "world.hpp"
+#include <cstddef>
+
+namespace ktp { namespace physics {
+
+// seconds simulated by a tick, whatever the frame rate
+constexpr GLfloat tick_time {1.f / 60.f};
+
+struct Settings {
+  // blocks per second squared
+  GLfloat gravity {28.f};
+  GLfloat max_fall_speed {60.f};
+  // blocks per second
+  GLfloat walk_speed {4.3f};
+  GLfloat jump_speed {9.f};
+  // the highest ledge walked onto without jumping, in blocks. The blocks are
+  // whole cubes, so anything lower than 1 is never used
+  GLfloat step_height {1.f};
+  // frames slower than this don't get more ticks, the game slows down
+  // instead of ticking ever more to catch up
+  GLfloat max_frame_time {0.25f};
+};
+
+struct Stats {
+  // ticks run by the last update(), and the time they took
+  std::size_t ticks {};
+  GLdouble tick_ms {};
+  // between the two last states, where the frame is drawn
+  GLfloat alpha {};
+};
+
+struct AABB {
+  Point3D min {};
+  Point3D max {};
+};
+
+/**
+ * @brief A box standing upright, it doesn't rotate.
+ */
+struct Body {
+  // the centre of the bottom face
+  Point3D position {};
+  Vector3 velocity {};
+  GLfloat half_width {0.3f};
+  GLfloat height {1.8f};
+  bool on_ground {false};
+};
+
+/**
+ * @brief What the player wants to do during the next ticks.
+ */
+struct Input {
+  // horizontal, in blocks per second
+  Vector3 walk {};
+  bool jump {false};
+};
+
+extern Settings settings;
+extern Stats stats;
+
+/**
+ * @param body The body.
+ * @return The box of the body.
+ */
+AABB bounds(const Body& body);
+
+/**
+ * @return The body of the player, as of the last sync(). Safe to read
+ *  while the ticks run.
+ */
+const Body& body();
+
+/**
+ * @brief Starts the thread running the ticks of update(), apart from the job
+ *  system so they never wait behind other jobs.
+ */
+void init();
+
+/**
+ * @brief Moves a body as far as it goes before touching a solid block, a
+ *  swept box against the block grid one axis at a time, vertical first. It
+ *  slides along what it touches and walks up ledges up to
+ *  Settings::step_height when it's on the ground.
+ * @param world The world.
+ * @param body The body, its velocity is zeroed on the axes that hit a block.
+ * @param displacement How far it tries to go.
+ */
+void move(const World& world, Body& body, const Vector3& displacement);
+
+/**
+ * @brief Where the player is drawn this frame, interpolated between the two
+ *  last states so the movement is smooth at any frame rate.
+ * @return The position of the player.
+ */
+Point3D position();
+
+/**
+ * @brief Waits for the ticks running, if any, and stops the physics thread.
+ */
+void shutdown();
+
+/**
+ * @brief Waits for the ticks running on the physics thread, if any, and
+ *  publishes their results. It doesn't run other jobs meanwhile. The world
+ *  must not change while they run, so call it before anything modifies it.
+ */
+void sync();
+
+/**
+ * @brief Puts the player somewhere, stopped. Call sync() first.
+ * @param position The new position of the player.
+ */
+void teleport(const Point3D& position);
+
+/**
+ * @brief Simulates a body for one tick: walking, jumping and gravity. A body
+ *  stuck inside blocks is pushed up a block instead.
+ * @param world The world.
+ * @param body The body.
+ * @param input What the body tries to do.
+ */
+void tick(const World& world, Body& body, const Input& input);
+
+/**
+ * @brief Adds the frame time to the simulation time and runs the ticks due on
+ *  the physics thread, they are waited for by the next sync(). Before init()
+ *  they run on the calling thread instead. The ticks are skipped while the
+ *  chunk of the player isn't loaded.
+ * @param world The world, it must not change until the next sync().
+ * @param input What the player does during the ticks.
+ * @param delta_time Seconds since the last frame.
+ */
+void update(const World& world, const Input& input, GLfloat delta_time);
+
+} } // namespace physics/ktp
+
+#endif // KETEMINE_SRC_PHYSICS_HPP_
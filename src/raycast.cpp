@@ -0,0 +1,141 @@
+#include "raycast.hpp"
+
+#include "jobs.hpp"
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace {
+
+using namespace ktp;
+
+// remembers the chunk of the last block read, the rays read many in a row
+class BlockReader {
+
+ public:
+
+  explicit BlockReader(const World& world): m_world(world) {}
+
+  BlockID get(const BlockPos& block) {
+    const auto pos {World::chunkPosition(block.x, block.y, block.z)};
+    if (pos != m_pos) {
+      m_pos = pos;
+      m_chunk = m_world.chunk(pos);
+    }
+    if (!m_chunk) return Blocks::air;
+    return m_chunk->get(World::localCoord(block.x), World::localCoord(block.y), World::localCoord(block.z));
+  }
+
+ private:
+
+  const World& m_world;
+  ChunkPos m_pos {std::numeric_limits<GLint>::min()};
+  const Chunk* m_chunk {nullptr};
+};
+
+// golden angle spiral, even enough for a benchmark
+std::vector<raycast::Ray> sphereRays(const Point3D& origin, std::size_t count, GLfloat max_distance) {
+  std::vector<raycast::Ray> rays(count);
+  const auto golden_angle {static_cast<GLfloat>(std::numbers::pi * (3.0 - std::sqrt(5.0)))};
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto y {1.f - 2.f * (static_cast<GLfloat>(i) + 0.5f) / static_cast<GLfloat>(count)};
+    const auto radius {std::sqrt(1.f - y * y)};
+    const auto angle {golden_angle * static_cast<GLfloat>(i)};
+    rays[i] = {origin, {radius * std::cos(angle), y, radius * std::sin(angle)}, max_distance};
+  }
+  return rays;
+}
+
+raycast::Hit traverse(BlockReader& reader, const raycast::Ray& ray) {
+  raycast::Hit hit {};
+  const auto length {glm::length(ray.direction)};
+  if (!(length > 0.f)) return hit;
+  const auto direction {ray.direction / length};
+  BlockPos block {glm::floor(ray.origin)};
+  // along the ray, the distance to cross a whole block and to the next border
+  BlockPos step {};
+  Vector3 t_delta {}, t_max {};
+  constexpr auto infinity {std::numeric_limits<GLfloat>::infinity()};
+  for (int axis = 0; axis < 3; ++axis) {
+    if (direction[axis] > 0.f) {
+      step[axis] = 1;
+      t_delta[axis] = 1.f / direction[axis];
+      t_max[axis] = (static_cast<GLfloat>(block[axis] + 1) - ray.origin[axis]) * t_delta[axis];
+    } else if (direction[axis] < 0.f) {
+      step[axis] = -1;
+      t_delta[axis] = -1.f / direction[axis];
+      t_max[axis] = (ray.origin[axis] - static_cast<GLfloat>(block[axis])) * t_delta[axis];
+    } else {
+      t_delta[axis] = t_max[axis] = infinity;
+    }
+  }
+  GLfloat distance {};
+  GLuint face {raycast::inside};
+  while (true) {
+    const auto id {reader.get(block)};
+    if (Blocks::solid(id)) return {true, block, id, face, distance};
+    // the closest border is crossed next
+    const int axis {t_max.x < t_max.y ? (t_max.x < t_max.z ? 0 : 2) : (t_max.y < t_max.z ? 1 : 2)};
+    distance = t_max[axis];
+    if (distance > ray.max_distance) return hit;
+    block[axis] += step[axis];
+    t_max[axis] += t_delta[axis];
+    // going up the axis the ray goes in through the negative face
+    face = static_cast<GLuint>(axis * 2) + (step[axis] > 0 ? 0u : 1u);
+  }
+}
+
+} // namespace
+
+ktp::BlockPos ktp::raycast::adjacent(const Hit& hit) {
+  auto block {hit.block};
+  if (hit.face == inside) return block;
+  block[static_cast<int>(hit.face / 2)] += hit.face % 2 ? 1 : -1;
+  return block;
+}
+
+ktp::raycast::Throughput ktp::raycast::benchmark(const World& world, const Point3D& origin, std::size_t count, GLfloat max_distance) {
+  Throughput throughput {};
+  if (count == 0) return throughput;
+  const auto rays {sphereRays(origin, count, max_distance)};
+  std::vector<Hit> hits(count);
+
+  auto start {std::chrono::steady_clock::now()};
+  for (std::size_t i = 0; i < count; ++i) hits[i] = cast(world, rays[i]);
+  const std::chrono::duration<GLdouble> single {std::chrono::steady_clock::now() - start};
+
+  start = std::chrono::steady_clock::now();
+  cast(world, rays, hits);
+  const std::chrono::duration<GLdouble> batched {std::chrono::steady_clock::now() - start};
+
+  std::size_t hit_count {};
+  for (const auto& hit: hits) hit_count += hit.hit;
+  throughput.rays_per_second = static_cast<GLdouble>(count) / single.count();
+  throughput.batched_rays_per_second = static_cast<GLdouble>(count) / batched.count();
+  throughput.hit_ratio = static_cast<GLdouble>(hit_count) / static_cast<GLdouble>(count);
+  return throughput;
+}
+
+ktp::raycast::Hit ktp::raycast::cast(const World& world, const Ray& ray) {
+  BlockReader reader {world};
+  return traverse(reader, ray);
+}
+
+void ktp::raycast::cast(const World& world, const std::vector<Ray>& rays, std::vector<Hit>& hits) {
+  hits.resize(rays.size());
+  // enough rays per batch to be worth a job
+  constexpr std::size_t batch_size {64};
+  jobs::parallelFor(rays.size(), batch_size, [&world, &rays, &hits](std::size_t begin, std::size_t end) {
+    // rays close to each other in the batch often share chunks
+    BlockReader reader {world};
+    for (auto i = begin; i < end; ++i) hits[i] = traverse(reader, rays[i]);
+  });
+}
+
+bool ktp::raycast::lineOfSight(const World& world, const Point3D& from, const Point3D& to) {
+  const auto direction {to - from};
+  return !cast(world, {from, direction, glm::length(direction)}).hit;
+}
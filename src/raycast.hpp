@@ -0,0 +1,103 @@
+/**
+ * @file raycast.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Voxel raycasting, for block picking and line of sight.
+ * @version 0.1
+ * @date 2022-12-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_RAYCAST_HPP_)
+#define KETEMINE_SRC_RAYCAST_HPP_
+
+#include "chunk.hpp"
+#include "types.hpp"
+#include "world.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace ktp { namespace raycast {
+
+// the face of a hit when the ray starts inside the block
+constexpr GLuint inside {6};
+
+struct Ray {
+  Point3D origin {};
+  // doesn't need to be normalized
+  Vector3 direction {0.f, 0.f, -1.f};
+  GLfloat max_distance {};
+};
+
+struct Hit {
+  bool hit {false};
+  BlockPos block {};
+  BlockID id {Blocks::air};
+  // the face the ray went in through, see mesher::Face, or inside
+  GLuint face {inside};
+  // from the origin of the ray to where it went in
+  GLfloat distance {};
+};
+
+/**
+ * @brief Rays per second, see benchmark().
+ */
+struct Throughput {
+  GLdouble rays_per_second {};
+  GLdouble batched_rays_per_second {};
+  // of the rays that hit a block
+  GLdouble hit_ratio {};
+};
+
+/**
+ * @param hit A hit outside of the block.
+ * @return The position of the block in front of the face that was hit,
+ *  where a block placed against it goes.
+ */
+BlockPos adjacent(const Hit& hit);
+
+/**
+ * @brief Casts rays in every direction, evenly spread over the sphere,
+ *  one at a time and then batched.
+ * @param world The world.
+ * @param origin Where the rays start.
+ * @param count How many rays to cast each way.
+ * @param max_distance How far the rays go.
+ * @return The rays per second.
+ */
+Throughput benchmark(const World& world, const Point3D& origin, std::size_t count, GLfloat max_distance);
+
+/**
+ * @brief Walks the blocks along a ray, one block per step, in the order the
+ *  ray goes through them (Amanatides and Woo, "A Fast Voxel Traversal
+ *  Algorithm for Ray Tracing"). The blocks are read from the chunks
+ *  directly, the chunk is only looked up again when the ray leaves it.
+ *  Stops at the first Blocks::solid() block, chunks not loaded are taken
+ *  as air.
+ * @param world The world.
+ * @param ray The ray.
+ * @return The first block hit, if any.
+ */
+Hit cast(const World& world, const Ray& ray);
+
+/**
+ * @brief Casts a batch of rays in parallel on the job system, for the many
+ *  line of sight queries of a frame. Waits for all of them.
+ * @param world The world, not modified while the rays are cast.
+ * @param rays The rays.
+ * @param hits Gets a hit per ray, in the same order.
+ */
+void cast(const World& world, const std::vector<Ray>& rays, std::vector<Hit>& hits);
+
+/**
+ * @param world The world.
+ * @param from A point.
+ * @param to Another point.
+ * @return True if no block is in the way between both points.
+ */
+bool lineOfSight(const World& world, const Point3D& from, const Point3D& to);
+
+} } // namespace raycast/ktp
+
+#endif // KETEMINE_SRC_RAYCAST_HPP_
@@ -0,0 +1,427 @@
+#include "region.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#if defined(_WIN32)
+  #define NOMINMAX
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+using namespace ktp;
+
+constexpr std::size_t table_bytes {region::size * region::size * sizeof(std::uint32_t)};
+// the length of a payload before the compression byte
+constexpr std::size_t length_bytes {sizeof(std::uint32_t)};
+// the lower 8 bits of a table entry
+constexpr std::size_t max_sectors {255};
+
+void logError(const std::string& msg, const std::filesystem::path& path) {
+  std::cerr << msg << " file: \"" << path.string() << "\"\n";
+}
+
+std::uint32_t readU32(const std::uint8_t* data) {
+  return static_cast<std::uint32_t>(data[0])
+       | (static_cast<std::uint32_t>(data[1]) << 8)
+       | (static_cast<std::uint32_t>(data[2]) << 16)
+       | (static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+void writeU32(std::uint8_t* data, std::uint32_t value) {
+  for (std::size_t i = 0; i < 4; ++i) data[i] = static_cast<std::uint8_t>(value >> (i * 8));
+}
+
+std::size_t sectors(std::size_t bytes) {
+  return (bytes + region::sector_size - 1) / region::sector_size;
+}
+
+/* Codec */
+
+void writeVarint(std::vector<std::uint8_t>& out, GLuint value) {
+  while (value >= 0x80u) {
+    out.push_back(static_cast<std::uint8_t>(value | 0x80u));
+    value >>= 7;
+  }
+  out.push_back(static_cast<std::uint8_t>(value));
+}
+
+bool readVarint(const std::uint8_t*& data, const std::uint8_t* end, GLuint& value) {
+  value = 0;
+  for (GLuint shift = 0; shift < 32 && data != end; shift += 7) {
+    const auto byte {*data++};
+    value |= static_cast<GLuint>(byte & 0x7Fu) << shift;
+    if (!(byte & 0x80u)) return true;
+  }
+  return false;
+}
+
+// the compression byte followed by the data, run length encoded unless that's bigger
+void encode(const Chunk& chunk, std::vector<std::uint8_t>& payload) {
+  payload.clear();
+  payload.push_back(static_cast<std::uint8_t>(region::Compression::Rle));
+  GLuint index {0};
+  while (index < static_cast<GLuint>(Chunk::volume)) {
+    const auto block {chunk.get(index)};
+    GLuint run {1};
+    while (index + run < static_cast<GLuint>(Chunk::volume) && chunk.get(index + run) == block) ++run;
+    writeVarint(payload, run);
+    writeVarint(payload, block);
+    index += run;
+  }
+  constexpr std::size_t raw_bytes {1 + Chunk::volume * sizeof(BlockID)};
+  if (payload.size() <= raw_bytes) return;
+  payload.clear();
+  payload.push_back(static_cast<std::uint8_t>(region::Compression::None));
+  for (GLuint i = 0; i < static_cast<GLuint>(Chunk::volume); ++i) {
+    const auto block {chunk.get(i)};
+    payload.push_back(static_cast<std::uint8_t>(block));
+    payload.push_back(static_cast<std::uint8_t>(block >> 8));
+  }
+}
+
+bool decode(const std::vector<std::uint8_t>& payload, Chunk& chunk) {
+  if (payload.empty()) return false;
+  const auto* data {payload.data() + 1};
+  const auto* end {payload.data() + payload.size()};
+  chunk.fill(Blocks::air);
+  switch (static_cast<region::Compression>(payload.front())) {
+    case region::Compression::None: {
+      if (static_cast<std::size_t>(end - data) != Chunk::volume * sizeof(BlockID)) return false;
+      for (GLuint i = 0; i < static_cast<GLuint>(Chunk::volume); ++i, data += 2) {
+        const auto block {static_cast<BlockID>(data[0] | (data[1] << 8))};
+        if (block != Blocks::air) chunk.set(i, block);
+      }
+      break;
+    }
+    case region::Compression::Rle: {
+      GLuint index {0};
+      while (data != end) {
+        GLuint run {}, block {};
+        if (!readVarint(data, end, run) || !readVarint(data, end, block)) return false;
+        if (run == 0 || run > static_cast<GLuint>(Chunk::volume) - index || block > 0xFFFFu) return false;
+        // uniform sections, the most common ones, don't need the indices
+        if (run == static_cast<GLuint>(Chunk::volume)) {
+          chunk.fill(static_cast<BlockID>(block));
+        } else if (block != Blocks::air) {
+          for (GLuint i = index; i < index + run; ++i) chunk.set(i, static_cast<BlockID>(block));
+        }
+        index += run;
+      }
+      if (index != static_cast<GLuint>(Chunk::volume)) return false;
+      break;
+    }
+    default:
+      return false;
+  }
+  chunk.optimize();
+  return true;
+}
+
+} // namespace
+
+/* RegionFile */
+
+ktp::region::RegionFile::RegionFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+  const auto file {CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)};
+  if (file == INVALID_HANDLE_VALUE) {
+    logError("Could NOT open region", path);
+    return;
+  }
+  m_file = file;
+  LARGE_INTEGER file_size {};
+  GetFileSizeEx(file, &file_size);
+  m_size = static_cast<std::size_t>(file_size.QuadPart);
+#else
+  m_file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (m_file < 0) {
+    logError("Could NOT open region", path);
+    return;
+  }
+  struct stat info {};
+  ::fstat(m_file, &info);
+  m_size = static_cast<std::size_t>(info.st_size);
+#endif
+  if (m_size < table_bytes) {
+    // new file, or one that died before the table was written
+    const std::vector<std::uint8_t> empty(table_bytes, 0u);
+    if (!writeAt(0, empty.data(), empty.size())) {
+      logError("Could NOT write region", path);
+      return;
+    }
+    m_size = table_bytes;
+  }
+  // a file cut in the middle of a payload
+  m_size -= m_size % sector_size;
+  map();
+  if (!m_view) {
+    logError("Could NOT map region", path);
+    return;
+  }
+  for (std::size_t i = 0; i < m_table.size(); ++i) {
+    m_table[i] = readU32(m_view + i * sizeof(std::uint32_t));
+  }
+}
+
+ktp::region::RegionFile::~RegionFile() {
+  unmap();
+#if defined(_WIN32)
+  if (m_file) CloseHandle(m_file);
+#else
+  if (m_file >= 0) ::close(m_file);
+#endif
+}
+
+void ktp::region::RegionFile::map() {
+#if defined(_WIN32)
+  m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!m_mapping) return;
+  m_view = static_cast<const std::uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, m_size));
+#else
+  const auto view {::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_file, 0)};
+  m_view = view != MAP_FAILED ? static_cast<const std::uint8_t*>(view) : nullptr;
+#endif
+}
+
+bool ktp::region::RegionFile::read(std::size_t index, std::vector<std::uint8_t>& payload) const {
+  std::shared_lock lock {m_mutex};
+  const auto entry {m_table[index]};
+  if (entry == 0 || !m_view) return false;
+  const auto offset {static_cast<std::size_t>(entry >> 8) * sector_size};
+  const auto capacity {static_cast<std::size_t>(entry & 0xFFu) * sector_size};
+  if (capacity < length_bytes || offset + capacity > m_size) return false;
+  const auto length {readU32(m_view + offset)};
+  if (length == 0 || length > capacity - length_bytes) return false;
+  payload.assign(m_view + offset + length_bytes, m_view + offset + length_bytes + length);
+  return true;
+}
+
+void ktp::region::RegionFile::unmap() {
+#if defined(_WIN32)
+  if (m_view) UnmapViewOfFile(m_view);
+  if (m_mapping) CloseHandle(m_mapping);
+  m_mapping = nullptr;
+#else
+  if (m_view) ::munmap(const_cast<std::uint8_t*>(m_view), m_size);
+#endif
+  m_view = nullptr;
+}
+
+bool ktp::region::RegionFile::valid() const {
+  std::shared_lock lock {m_mutex};
+  return m_view != nullptr;
+}
+
+bool ktp::region::RegionFile::write(std::size_t index, const std::vector<std::uint8_t>& payload) {
+  const auto needed {sectors(length_bytes + payload.size())};
+  if (payload.empty() || needed > max_sectors) return false;
+  std::vector<std::uint8_t> bytes(needed * sector_size, 0u);
+  writeU32(bytes.data(), static_cast<std::uint32_t>(payload.size()));
+  std::memcpy(bytes.data() + length_bytes, payload.data(), payload.size());
+
+  std::unique_lock lock {m_mutex};
+  if (!m_view) return false;
+  auto offset {static_cast<std::size_t>(m_table[index] >> 8)};
+  const auto capacity {static_cast<std::size_t>(m_table[index] & 0xFFu)};
+  // the old sectors are left unused, like Anvil does until the file is
+  // compacted. A file cut short may have lost them, then it's appended too
+  const auto grows {needed > capacity || (offset + capacity) * sector_size > m_size};
+  if (grows) offset = m_size / sector_size;
+  // the payload first, so the table never points to sectors not written yet
+  if (!writeAt(offset * sector_size, bytes.data(), bytes.size())) return false;
+  const auto entry {static_cast<std::uint32_t>((offset << 8) | needed)};
+  std::uint8_t entry_bytes[4] {};
+  writeU32(entry_bytes, entry);
+  if (!writeAt(index * sizeof(std::uint32_t), entry_bytes, sizeof(entry_bytes))) return false;
+  m_table[index] = entry;
+  if (grows) {
+    // the mapping doesn't grow with the file
+    unmap();
+    m_size = (offset + needed) * sector_size;
+    map();
+  }
+  return m_view != nullptr;
+}
+
+bool ktp::region::RegionFile::writeAt(std::size_t offset, const void* data, std::size_t bytes) {
+#if defined(_WIN32)
+  OVERLAPPED overlapped {};
+  overlapped.Offset = static_cast<DWORD>(offset);
+  overlapped.OffsetHigh = static_cast<DWORD>(static_cast<std::uint64_t>(offset) >> 32);
+  DWORD written {};
+  return WriteFile(m_file, data, static_cast<DWORD>(bytes), &written, &overlapped) && written == bytes;
+#else
+  const auto* cursor {static_cast<const std::uint8_t*>(data)};
+  while (bytes > 0) {
+    const auto written {::pwrite(m_file, cursor, bytes, static_cast<off_t>(offset))};
+    if (written <= 0) return false;
+    cursor += written;
+    offset += static_cast<std::size_t>(written);
+    bytes -= static_cast<std::size_t>(written);
+  }
+  return true;
+#endif
+}
+
+/* Storage */
+
+ktp::region::Storage::Storage(const std::filesystem::path& directory): m_directory{directory} {
+  std::error_code error {};
+  std::filesystem::create_directories(m_directory, error);
+  if (error) logError("Could NOT create the world directory", m_directory);
+  m_thread = std::thread{&Storage::run, this};
+}
+
+ktp::region::Storage::~Storage() {
+  {
+    std::lock_guard lock {m_queue_mutex};
+    m_stop = true;
+  }
+  m_queue_changed.notify_all();
+  m_thread.join();
+}
+
+void ktp::region::Storage::flush() {
+  std::unique_lock lock {m_queue_mutex};
+  m_queue_changed.wait(lock, [this] { return m_pending.empty(); });
+}
+
+bool ktp::region::Storage::load(const ChunkPos& pos, Chunk& chunk) {
+  std::vector<std::uint8_t> payload {};
+  bool found {false};
+  {
+    // the latest save wins, even if it's not written yet
+    std::lock_guard lock {m_queue_mutex};
+    const auto pending {m_pending.find(pos)};
+    if (pending != m_pending.end()) {
+      payload = pending->second.payload;
+      found = true;
+    }
+  }
+  if (!found) {
+    const auto file {region(pos, false)};
+    found = file && file->read(index(pos), payload);
+  }
+  if (!found) return false;
+  if (!decode(payload, chunk)) {
+    logError("Corrupt chunk " + std::to_string(pos.x) + " " + std::to_string(pos.y) + " " + std::to_string(pos.z) + " in region", m_directory);
+    return false;
+  }
+  ++m_loaded;
+  return true;
+}
+
+ktp::region::RegionFile* ktp::region::Storage::region(const ChunkPos& pos, bool create) {
+  const ChunkPos region_pos {pos.x >> 5, pos.y, pos.z >> 5};
+  std::lock_guard lock {m_regions_mutex};
+  auto& file {m_regions[region_pos]};
+  if (!file) {
+    const auto path {m_directory / ("r." + std::to_string(region_pos.x) + "." + std::to_string(region_pos.y) + "." + std::to_string(region_pos.z) + ".ktr")};
+    if (!create && !std::filesystem::exists(path)) {
+      m_regions.erase(region_pos);
+      return nullptr;
+    }
+    file = std::make_unique<RegionFile>(path);
+  }
+  return file->valid() ? file.get() : nullptr;
+}
+
+void ktp::region::Storage::run() {
+  std::unique_lock lock {m_queue_mutex};
+  while (true) {
+    m_queue_changed.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+    // the queue is drained before stopping, nothing saved is lost
+    if (m_queue.empty()) return;
+    const auto pos {m_queue.front()};
+    m_queue.pop_front();
+    auto& pending {m_pending[pos]};
+    pending.queued = false;
+    const auto version {pending.version};
+    const auto payload {pending.payload};
+    lock.unlock();
+
+    const auto file {region(pos, true)};
+    const auto written {file && file->write(index(pos), payload)};
+    if (written) {
+      ++m_saved;
+      m_bytes_written += payload.size();
+    } else {
+      logError("Could NOT save chunk " + std::to_string(pos.x) + " " + std::to_string(pos.y) + " " + std::to_string(pos.z) + " in region", m_directory);
+    }
+
+    lock.lock();
+    const auto still_pending {m_pending.find(pos)};
+    if (!still_pending->second.queued && still_pending->second.version == version) m_pending.erase(still_pending);
+    m_queue_changed.notify_all();
+  }
+}
+
+void ktp::region::Storage::save(const ChunkPos& pos, const Chunk& chunk) {
+  std::vector<std::uint8_t> payload {};
+  encode(chunk, payload);
+  {
+    std::lock_guard lock {m_queue_mutex};
+    auto& pending {m_pending[pos]};
+    pending.payload = std::move(payload);
+    ++pending.version;
+    if (!pending.queued) {
+      pending.queued = true;
+      m_queue.push_back(pos);
+    }
+  }
+  m_queue_changed.notify_all();
+}
+
+ktp::region::Storage::Stats ktp::region::Storage::stats() const {
+  Stats stats {};
+  stats.loaded = m_loaded;
+  stats.saved = m_saved;
+  stats.bytes_written = m_bytes_written;
+  {
+    std::lock_guard lock {m_queue_mutex};
+    stats.pending = m_pending.size();
+  }
+  return stats;
+}
+
+/* Benchmark */
+
+ktp::region::Throughput ktp::region::benchmark(const std::filesystem::path& directory, const World& world, std::size_t max_chunks) {
+  Throughput throughput {};
+  std::vector<ChunkPos> positions {};
+  for (const auto& [pos, chunk]: world.chunks()) {
+    if (positions.size() == max_chunks) break;
+    positions.push_back(pos);
+  }
+  if (positions.empty()) return throughput;
+  std::error_code error {};
+  std::filesystem::remove_all(directory, error);
+  {
+    Storage storage {directory};
+    const auto save_start {std::chrono::steady_clock::now()};
+    for (const auto& pos: positions) storage.save(pos, *world.chunk(pos));
+    storage.flush();
+    const auto save_seconds {std::chrono::duration<GLdouble>(std::chrono::steady_clock::now() - save_start).count()};
+
+    Chunk chunk {};
+    const auto load_start {std::chrono::steady_clock::now()};
+    for (const auto& pos: positions) storage.load(pos, chunk);
+    const auto load_seconds {std::chrono::duration<GLdouble>(std::chrono::steady_clock::now() - load_start).count()};
+
+    const auto count {static_cast<GLdouble>(positions.size())};
+    throughput.saved_per_second = count / save_seconds;
+    throughput.loaded_per_second = count / load_seconds;
+    throughput.bytes_per_chunk = static_cast<GLdouble>(storage.stats().bytes_written) / count;
+  }
+  std::filesystem::remove_all(directory, error);
+  return throughput;
+}
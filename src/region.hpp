@@ -0,0 +1,232 @@
+/**
+ * @file region.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Chunk persistence in region files.
+ * @version 0.1
+ * @date 2022-12-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_REGION_HPP_)
+#define KETEMINE_SRC_REGION_HPP_
+
+#include "chunk.hpp"
+#include "types.hpp"
+#include "world.hpp"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ktp { namespace region {
+
+// chunks per side of a region, every file holds one layer of size x size chunks
+constexpr GLint size {32};
+// payloads start at multiples of it
+constexpr std::size_t sector_size {512};
+
+/**
+ * @brief How a chunk payload is stored. The first byte of every payload.
+ */
+enum class Compression: std::uint8_t {
+  // every block as a little endian 16 bit id, in Chunk::index() order
+  None = 1,
+  // runs of equal blocks in Chunk::index() order, as pairs of LEB128
+  // varints: run length, block id
+  Rle = 2
+};
+
+/**
+ * @brief A file holding the chunks of a region, in the spirit of Minecraft's
+ *  Anvil format. It starts with a table of size * size little endian 32 bit
+ *  entries, the offset in sectors of a payload in the upper 24 bits and its
+ *  length in sectors in the lower 8, 0 when the chunk isn't stored. A
+ *  payload is its length in bytes as 32 bits, the compression byte and the
+ *  data. Reads copy from a read only mapping of the file and can run on any
+ *  number of threads, writes take the file for themselves.
+ */
+class RegionFile {
+
+ public:
+
+  /**
+   * @brief Opens a region file, creating it if it doesn't exist.
+   * @param path The path of the file.
+   */
+  explicit RegionFile(const std::filesystem::path& path);
+  RegionFile(const RegionFile& other) = delete;
+  RegionFile& operator=(const RegionFile& other) = delete;
+  ~RegionFile();
+
+  /**
+   * @brief Copies the payload of a chunk.
+   * @param index The index of the chunk in the table, see region::index().
+   * @param payload Gets the compression byte and the data.
+   * @return False if the chunk isn't stored or its payload is corrupt.
+   */
+  bool read(std::size_t index, std::vector<std::uint8_t>& payload) const;
+
+  /**
+   * @return True if the file could be opened and mapped.
+   */
+  bool valid() const;
+
+  /**
+   * @brief Stores the payload of a chunk. It's written over the old one when
+   *  it fits in its sectors, appended at the end of the file otherwise.
+   * @param index The index of the chunk in the table, see region::index().
+   * @param payload The compression byte and the data.
+   * @return False if the payload is too big or the file couldn't be written.
+   */
+  bool write(std::size_t index, const std::vector<std::uint8_t>& payload);
+
+ private:
+
+  void map();
+  void unmap();
+  bool writeAt(std::size_t offset, const void* data, std::size_t bytes);
+
+#if defined(_WIN32)
+  void* m_file {nullptr};
+  void* m_mapping {nullptr};
+#else
+  int m_file {-1};
+#endif
+  const std::uint8_t* m_view {nullptr};
+  // always a multiple of sector_size
+  std::size_t m_size {};
+  std::array<std::uint32_t, size * size> m_table {};
+  // shared by the readers, exclusive for the writer
+  mutable std::shared_mutex m_mutex {};
+};
+
+/**
+ * @brief The chunks of a world, saved in region files in a directory.
+ *  Saves are compressed on the calling thread and written on an I/O thread,
+ *  the chunks waiting to be written are still found by load().
+ */
+class Storage {
+
+ public:
+
+  struct Stats {
+    std::size_t loaded {};
+    std::size_t saved {};
+    std::size_t pending {};
+    std::size_t regions {};
+    std::size_t bytes_written {};
+  };
+
+  /**
+   * @brief Starts the I/O thread.
+   * @param directory Where the region files are, created if needed.
+   */
+  explicit Storage(const std::filesystem::path& directory);
+  Storage(const Storage& other) = delete;
+  Storage& operator=(const Storage& other) = delete;
+
+  /**
+   * @brief Writes every pending chunk and stops the I/O thread.
+   */
+  ~Storage();
+
+  /**
+   * @brief Waits until every chunk saved so far is written.
+   */
+  void flush();
+
+  /**
+   * @brief Loads a chunk. Callable from any thread.
+   * @param pos The chunk position.
+   * @param chunk Gets the chunk.
+   * @return False if the chunk was never saved.
+   */
+  bool load(const ChunkPos& pos, Chunk& chunk);
+
+  /**
+   * @brief Queues a chunk to be written. Callable from any thread.
+   * @param pos The chunk position.
+   * @param chunk The chunk to save.
+   */
+  void save(const ChunkPos& pos, const Chunk& chunk);
+
+  /**
+   * @return What was read and written so far.
+   */
+  Stats stats() const;
+
+ private:
+
+  struct Pending {
+    std::vector<std::uint8_t> payload {};
+    // bumped by every save, so a save arriving during a write isn't dropped
+    std::uint64_t version {};
+    bool queued {false};
+  };
+
+  /**
+   * @return The file of the region holding the chunk, or nullptr if it
+   *  doesn't exist and create is false.
+   */
+  RegionFile* region(const ChunkPos& pos, bool create);
+
+  /**
+   * @brief The loop of the I/O thread.
+   */
+  void run();
+
+  std::filesystem::path m_directory {};
+  std::mutex m_regions_mutex {};
+  std::unordered_map<ChunkPos, std::unique_ptr<RegionFile>, ChunkPosHash> m_regions {};
+  mutable std::mutex m_queue_mutex {};
+  std::condition_variable m_queue_changed {};
+  std::deque<ChunkPos> m_queue {};
+  std::unordered_map<ChunkPos, Pending, ChunkPosHash> m_pending {};
+  bool m_stop {false};
+  std::atomic<std::size_t> m_loaded {};
+  std::atomic<std::size_t> m_saved {};
+  std::atomic<std::size_t> m_bytes_written {};
+  std::thread m_thread {};
+};
+
+/**
+ * @brief Save and load rates of a set of chunks, see benchmark().
+ */
+struct Throughput {
+  GLdouble saved_per_second {};
+  GLdouble loaded_per_second {};
+  GLdouble bytes_per_chunk {};
+};
+
+/**
+ * @brief Saves the chunks of a world to a temporary storage, waiting for the
+ *  I/O thread, then loads them back. The directory is deleted afterwards.
+ * @param directory An empty directory for the region files.
+ * @param world The chunks to save.
+ * @param max_chunks How many chunks to save at most.
+ * @return The chunks per second.
+ */
+Throughput benchmark(const std::filesystem::path& directory, const World& world, std::size_t max_chunks);
+
+/**
+ * @param pos The chunk position.
+ * @return The index of a chunk in the table of its region file.
+ */
+constexpr std::size_t index(const ChunkPos& pos) {
+  return static_cast<std::size_t>(((pos.z & (size - 1)) * size) + (pos.x & (size - 1)));
+}
+
+} } // namespace region/ktp
+
+#endif // KETEMINE_SRC_REGION_HPP_
@@ -0,0 +1,192 @@
+#include "renderer.hpp"
+
+#include "resources.hpp"
+#include "streaming.hpp"
+#include "world.hpp"
+#include <glm/common.hpp>
+#include <chrono>
+#include <memory>
+#include <unordered_set>
+
+namespace {
+
+using namespace ktp;
+
+constexpr GLuint cull_group_size {64};
+constexpr GLuint candidates_binding {1};
+constexpr GLuint commands_binding {2};
+constexpr GLuint draw_count_binding {0};
+
+ShaderProgram voxel_shader {};
+ShaderProgram cull_shader {};
+UniformHandle candidate_count_uniform {};
+
+// rebuilt every frame, one entry per chunk mesh
+std::vector<renderer::CullCandidate> candidates {};
+std::vector<renderer::DrawElementsIndirectCommand> commands {};
+std::vector<Point3D> origins {};
+// the chunks the cave culling found
+std::unordered_set<ChunkPos, ChunkPosHash> reachable {};
+// the same boxes as the candidates, for the SIMD culling on the CPU
+AabbArray boxes {};
+std::vector<GLuint> visible {};
+std::unique_ptr<SSBO> candidates_buffer {};
+std::unique_ptr<SSBO> indirect_buffer {};
+// the atomic counter the compute pass compacts the draws with
+std::unique_ptr<SSBO> draw_count_buffer {};
+// per instance attribute, base_instance picks the entry of every draw
+std::unique_ptr<VBO> origins_vbo {};
+
+void gpuCull() {
+  const auto count {static_cast<GLuint>(candidates.size())};
+  candidates_buffer->setup(candidates, GL_STREAM_DRAW);
+  candidates_buffer->bindBase(candidates_binding);
+  indirect_buffer->setup(nullptr, static_cast<GLsizeiptr>(count * sizeof(renderer::DrawElementsIndirectCommand)), GL_STREAM_DRAW);
+  if (!GLEW_ARB_indirect_parameters) {
+    // every slot is drawn, the ones the pass doesn't fill must draw nothing
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+  }
+  indirect_buffer->bindBase(commands_binding);
+  constexpr GLuint zero {};
+  glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, draw_count_buffer->id());
+  glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(GLuint), &zero);
+  glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, draw_count_binding, draw_count_buffer->id());
+
+  cull_shader.use();
+  cull_shader.setUint(candidate_count_uniform, count);
+  glDispatchCompute((count + cull_group_size - 1) / cull_group_size, 1, 1);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+} // namespace
+
+ktp::renderer::Settings ktp::renderer::settings {};
+ktp::renderer::Stats ktp::renderer::stats {};
+
+void ktp::renderer::clean() {
+  candidates_buffer.reset();
+  indirect_buffer.reset();
+  draw_count_buffer.reset();
+  origins_vbo.reset();
+}
+
+void ktp::renderer::cullChunks(const Frustum& frustum, const std::vector<CullCandidate>& candidates, std::vector<DrawElementsIndirectCommand>& commands) {
+  for (const auto& candidate: candidates) {
+    if (!frustum.intersects(Point3D{candidate.aabb_min}, Point3D{candidate.aabb_max})) continue;
+    commands.push_back({candidate.draw.x, 1u, 0u, static_cast<GLint>(candidate.draw.y), candidate.draw.z});
+  }
+}
+
+void ktp::renderer::drawChunks(const glm::mat4& view_projection, const Point3D& camera_position) {
+  const auto start {std::chrono::steady_clock::now()};
+  const auto& arena {streaming::arena()};
+  candidates.clear();
+  commands.clear();
+  origins.clear();
+  boxes.clear();
+  const auto camera_block {glm::floor(camera_position)};
+  const auto camera_chunk {World::chunkPosition(
+    static_cast<GLint>(camera_block.x),
+    static_cast<GLint>(camera_block.y),
+    static_cast<GLint>(camera_block.z)
+  )};
+  // out of the generated world there's nothing to start from
+  const auto& graph {streaming::visibilityGraph()};
+  const auto cave_culling {settings.cave_culling && graph.contains(camera_chunk)};
+  if (cave_culling) graph.search(camera_chunk, reachable);
+  stats.cave_culled = 0;
+  for (const auto& [pos, mesh]: streaming::meshes()) {
+    if (cave_culling && !reachable.count(pos)) {
+      ++stats.cave_culled;
+      continue;
+    }
+    boxes.push(mesh.origin, mesh.origin + Point3D{Chunk::size});
+    candidates.push_back({
+      glm::vec4{mesh.origin, 0.f},
+      glm::vec4{mesh.origin + Point3D{Chunk::size}, 0.f},
+      glm::uvec4{
+        static_cast<GLuint>(mesh.index_count),
+        static_cast<GLuint>(arena.baseVertex(mesh.allocation)),
+        static_cast<GLuint>(origins.size()),
+        0u
+      }
+    });
+    origins.push_back(mesh.origin);
+  }
+  stats.candidates = candidates.size();
+  stats.chunks_drawn = 0;
+  stats.draw_calls = 0;
+  stats.cull_ms = 0.0;
+  if (candidates.empty()) {
+    stats.cpu_ms = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return;
+  }
+
+  const auto gpu_culling {settings.multi_draw && settings.culling == Culling::GPU};
+  if (gpu_culling) {
+    gpuCull();
+  } else if (settings.culling == Culling::None) {
+    for (const auto& candidate: candidates) {
+      commands.push_back({candidate.draw.x, 1u, 0u, static_cast<GLint>(candidate.draw.y), candidate.draw.z});
+    }
+  } else {
+    const auto cull_start {std::chrono::steady_clock::now()};
+    visible.clear();
+    Frustum{view_projection}.cull(boxes, visible);
+    for (const auto index: visible) {
+      const auto& draw {candidates[index].draw};
+      commands.push_back({draw.x, 1u, 0u, static_cast<GLint>(draw.y), draw.z});
+    }
+    stats.cull_ms = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - cull_start).count();
+  }
+  if (!gpu_culling) stats.chunks_drawn = commands.size();
+
+  // orphaned every frame, so the driver doesn't wait for the last frame's draws
+  origins_vbo->setup(origins, GL_STREAM_DRAW);
+  voxel_shader.use();
+  streaming::vao().bind();
+  if (gpu_culling) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer->id());
+    const auto max_count {static_cast<GLsizei>(candidates.size())};
+    if (GLEW_ARB_indirect_parameters) {
+      glBindBuffer(GL_PARAMETER_BUFFER_ARB, draw_count_buffer->id());
+      glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, 0, max_count, 0);
+      glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+    } else {
+      glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, max_count, 0);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    stats.draw_calls = 1;
+  } else if (!commands.empty() && settings.multi_draw) {
+    indirect_buffer->setup(commands, GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer->id());
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    stats.draw_calls = 1;
+  } else {
+    for (const auto& command: commands) {
+      glDrawElementsInstancedBaseVertexBaseInstance(
+        GL_TRIANGLES, static_cast<GLsizei>(command.count), GL_UNSIGNED_SHORT, nullptr,
+        1, command.base_vertex, command.base_instance
+      );
+    }
+    stats.draw_calls = commands.size();
+  }
+  streaming::vao().unbind();
+  stats.cpu_ms = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ktp::renderer::init() {
+  voxel_shader = Resources::getShaderProgram("voxel");
+  cull_shader = Resources::getShaderProgram("cull_chunks");
+  candidate_count_uniform = cull_shader.uniform("candidate_count");
+  candidates_buffer = std::make_unique<SSBO>();
+  indirect_buffer = std::make_unique<SSBO>();
+  draw_count_buffer = std::make_unique<SSBO>();
+  draw_count_buffer->setup(nullptr, sizeof(GLuint));
+  origins_vbo = std::make_unique<VBO>();
+  const auto& vao {streaming::vao()};
+  vao.linkAttrib(*origins_vbo, 1, 3, GL_FLOAT, sizeof(Point3D), nullptr);
+  vao.setDivisor(1, 1);
+  vao.unbind();
+}
@@ -0,0 +1,114 @@
+/**
+ * @file renderer.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Draws the chunk meshes.
+ * @version 0.1
+ * @date 2022-11-30
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_RENDERER_HPP_)
+#define KETEMINE_SRC_RENDERER_HPP_
+
+#include "frustum.hpp"
+#include "opengl.hpp"
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace ktp { namespace renderer {
+
+/**
+ * @brief The layout glMultiDrawElementsIndirect() reads from the indirect buffer.
+ */
+struct DrawElementsIndirectCommand {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first_index;
+  GLint base_vertex;
+  // indexes the per draw attributes, the chunk origin
+  GLuint base_instance;
+};
+
+static_assert(sizeof(DrawElementsIndirectCommand) == 5 * sizeof(GLuint));
+
+/**
+ * @brief A chunk to test against the frustum, the Candidate struct of cull_chunks.comp.
+ */
+struct CullCandidate {
+  // w unused
+  glm::vec4 aabb_min;
+  glm::vec4 aabb_max;
+  // x: index count, y: base vertex, z: base instance
+  glm::uvec4 draw;
+};
+
+KTP_STD430_MEMBER(CullCandidate, aabb_min);
+KTP_STD430_MEMBER(CullCandidate, aabb_max);
+KTP_STD430_MEMBER(CullCandidate, draw);
+
+enum class Culling { None, CPU, GPU };
+
+struct Settings {
+  // one glMultiDrawElementsIndirect() instead of a draw call per chunk
+  bool multi_draw {true};
+  // GPU culling needs multi_draw, otherwise it's done on the CPU
+  Culling culling {Culling::GPU};
+  // skip the chunks the camera can't see through air, before frustum culling
+  bool cave_culling {true};
+};
+
+/**
+ * @brief What the last drawChunks() did.
+ */
+struct Stats {
+  // chunks skipped by the cave culling
+  std::size_t cave_culled {};
+  std::size_t candidates {};
+  // unknown when culling on the GPU, the count never comes back to the CPU
+  std::size_t chunks_drawn {};
+  std::size_t draw_calls {};
+  // time spent building and submitting the draws
+  GLdouble cpu_ms {};
+  // part of it spent culling, when culling on the CPU
+  GLdouble cull_ms {};
+};
+
+extern Settings settings;
+extern Stats stats;
+
+/**
+ * @brief Frees the OpenGL objects. Call before destroying the OpenGL context.
+ */
+void clean();
+
+/**
+ * @brief Tests every candidate against the frustum and appends a command for
+ *  each one that may be visible. The CPU reference of cull_chunks.comp, which
+ *  produces the same commands in any order. The CPU culling mode gets the same
+ *  result with Frustum::cull().
+ * @param frustum The view frustum.
+ * @param candidates The chunks to test.
+ * @param commands Gets the commands of the visible chunks.
+ */
+void cullChunks(const Frustum& frustum, const std::vector<CullCandidate>& candidates, std::vector<DrawElementsIndirectCommand>& commands);
+
+/**
+ * @brief Draws every chunk mesh uploaded by the streaming. Expects the Frame
+ *  block to be up to date.
+ * @param view_projection The matrix in the Frame block, for culling on the CPU.
+ * @param camera_position The position of the camera, for the cave culling.
+ */
+void drawChunks(const glm::mat4& view_projection, const Point3D& camera_position);
+
+/**
+ * @brief Creates the OpenGL objects. Call after streaming::init().
+ */
+void init();
+
+} } // namespace renderer/ktp
+
+#endif // KETEMINE_SRC_RENDERER_HPP_
@@ -1,8 +1,16 @@
 #include "resources.hpp"
 
+#include "jobs.hpp"
+#include "uniforms.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
 void logError(const std::string& msg) {
   std::cerr << msg << "\n";
@@ -17,21 +25,21 @@ void logMessage(const std::string& msg) {
 }
 
 void ktp::Resources::loadResources() {
-  Resources::createShaderProgram(
-    "basic",
-    "resources/shaders/basic.vert",
-    "resources/shaders/basic.frag"
-  );
-  Resources::createShaderProgram(
-    "interpolation",
-    "resources/shaders/basic.vert",
-    "resources/shaders/interpolation.frag"
-  );
+  binary_cache_stats = {};
+  Resources::createShaderPrograms({
+    {"basic",         "resources/shaders/basic.vert", "resources/shaders/basic.frag"},
+    {"interpolation", "resources/shaders/basic.vert", "resources/shaders/interpolation.frag"},
+    {"voxel",         "resources/shaders/voxel.vert", "resources/shaders/voxel.frag"},
+    {"cull_chunks",   "", "", "", "resources/shaders/cull_chunks.comp"}
+  });
+  std::cout << "Shader binary cache: " << binary_cache_stats.hits << " hits, " << binary_cache_stats.misses
+            << " misses, " << binary_cache_stats.saved_ms << " ms of start-up time saved\n";
 }
 
 // SHADERS
 
 ktp::Resources::ShaderPrograms ktp::Resources::shader_programs {};
+ktp::Resources::BinaryCacheStats ktp::Resources::binary_cache_stats {};
 
 bool ktp::Resources::compileShader(GLuint shader, const std::string& source) {
   const auto source_pointer {source.c_str()};
@@ -42,78 +50,157 @@ bool ktp::Resources::compileShader(GLuint shader, const std::string& source) {
   return true;
 }
 
+bool ktp::Resources::createComputeProgram(const std::string& name, const std::string& compute_shader_path) {
+  return createShaderPrograms({{name, "", "", "", compute_shader_path}});
+}
+
 bool ktp::Resources::createShaderProgram(const std::string& name, const std::string& vertex_shader_path, const std::string& fragment_shader_path, const std::string& geometry_shader_path) {
-  // Create the shaders
-	GLuint vertex_shader_id {glCreateShader(GL_VERTEX_SHADER)};
-  glCheckError();
-	GLuint fragment_shader_id {glCreateShader(GL_FRAGMENT_SHADER)};
-  glCheckError();
-  bool geometry_shader_present {};
-  GLuint geometry_shader_id {};
-  if (geometry_shader_path != "") {
-    geometry_shader_present = true;
-    glCreateShader(GL_GEOMETRY_SHADER);
-    glCheckError();
-  }
-  // Read the Vertex Shader code from the file
-	const std::string vertex_shader_code {loadShaderSource(vertex_shader_path)};
-  if (vertex_shader_code == "") {
-    logError("Could NOT open vertex shader file", vertex_shader_path);
-    deleteShaders({vertex_shader_id, fragment_shader_id, geometry_shader_id});
-    return false;
-  }
-  // Read the Fragment Shader code from the file
-	const std::string fragment_shader_code {loadShaderSource(fragment_shader_path)};
-  if (fragment_shader_code == "") {
-    logError("Could NOT open fragment shader file", fragment_shader_path);
-    deleteShaders({vertex_shader_id, fragment_shader_id, geometry_shader_id});
-    return false;
-  }
-  std::string geometry_shader_code {};
-  if (geometry_shader_present) {
-    // Read the Geometry Shader code from the file
-    geometry_shader_code = loadShaderSource(geometry_shader_path);
-    if (geometry_shader_code == "") {
-      logError("Could NOT open geometry shader file", geometry_shader_path);
-      deleteShaders({vertex_shader_id, fragment_shader_id, geometry_shader_id});
-      return false;
+  return createShaderPrograms({{name, vertex_shader_path, fragment_shader_path, geometry_shader_path}});
+}
+
+bool ktp::Resources::createShaderPrograms(const std::vector<ShaderProgramPaths>& programs) {
+  struct Build {
+    ShaderProgramInfo info {};
+    std::string binary_path {};
+    GLuint shaders[4] {};
+    bool failed {};
+    bool cached {};
+  };
+  std::vector<Build> builds(programs.size());
+
+  // read every file at once
+  jobs::parallelFor(programs.size(), 1, [&programs, &builds](std::size_t begin, std::size_t end) {
+    for (auto i = begin; i < end; ++i) {
+      if (programs[i].compute != "") {
+        builds[i].info.compute = loadShaderSource(programs[i].compute);
+        continue;
+      }
+      builds[i].info.vertex = loadShaderSource(programs[i].vertex);
+      builds[i].info.fragment = loadShaderSource(programs[i].fragment);
+      if (programs[i].geometry != "") builds[i].info.geometry = loadShaderSource(programs[i].geometry);
+    }
+  });
+
+  const auto cache_start {std::chrono::steady_clock::now()};
+  for (std::size_t i = 0; i < programs.size(); ++i) {
+    auto& build {builds[i]};
+    if (programs[i].compute != "") {
+      if (build.info.compute == "") {
+        logError("Could NOT open compute shader file", programs[i].compute);
+        build.failed = true;
+      }
+    } else if (build.info.vertex == "") {
+      logError("Could NOT open vertex shader file", programs[i].vertex);
+      build.failed = true;
+    }
+    if (programs[i].compute == "" && build.info.fragment == "") {
+      logError("Could NOT open fragment shader file", programs[i].fragment);
+      build.failed = true;
+    }
+    if (programs[i].geometry != "" && build.info.geometry == "") {
+      logError("Could NOT open geometry shader file", programs[i].geometry);
+      build.failed = true;
+    }
+    if (build.failed) continue;
+    // try the binary cache first
+    build.binary_path = programBinaryPath(programs[i].name, build.info.vertex + build.info.fragment + build.info.geometry + build.info.compute);
+    GLdouble source_ms {};
+    build.info.id = loadProgramBinary(build.binary_path, source_ms);
+    if (build.info.id) {
+      build.cached = true;
+      ++binary_cache_stats.hits;
+      binary_cache_stats.saved_ms += source_ms;
     }
   }
-  // compile shaders
-  if (!compileShader(vertex_shader_id, vertex_shader_code)
-   || !compileShader(fragment_shader_id, fragment_shader_code)) {
-    deleteShaders({vertex_shader_id, fragment_shader_id, geometry_shader_id});
-    return false;
+  binary_cache_stats.saved_ms -= std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - cache_start).count();
+
+  // let the driver compile in parallel if it can
+  if (GLEW_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+  } else if (GLEW_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
   }
-  if (geometry_shader_present) {
-    if (!compileShader(geometry_shader_id, geometry_shader_code)) {
-      deleteShaders({vertex_shader_id, fragment_shader_id, geometry_shader_id});
-      return false;
+
+  // issue every compile and link without asking for any status, so the driver isn't forced to sync
+  const auto source_start {std::chrono::steady_clock::now()};
+  GLuint compiled {};
+  for (auto& build: builds) {
+    if (build.failed || build.cached) continue;
+    const std::string* sources[4] {&build.info.vertex, &build.info.fragment, &build.info.geometry, &build.info.compute};
+    const GLenum types[4] {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER, GL_COMPUTE_SHADER};
+    build.info.id = glCreateProgram();
+    for (std::size_t s = 0; s < 4; ++s) {
+      if (*sources[s] == "") continue;
+      build.shaders[s] = glCreateShader(types[s]);
+      const auto source_pointer {sources[s]->c_str()};
+      glShaderSource(build.shaders[s], 1, &source_pointer, nullptr);
+      glCompileShader(build.shaders[s]);
+      glAttachShader(build.info.id, build.shaders[s]);
     }
+    glProgramParameteri(build.info.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(build.info.id);
+    ++compiled;
   }
-  // Link the program
-	const GLuint id {glCreateProgram()};
   glCheckError();
-	glAttachShader(id, vertex_shader_id);
-  glCheckError();
-	glAttachShader(id, fragment_shader_id);
-  glCheckError();
-  if (geometry_shader_present) {
-    glAttachShader(id, geometry_shader_id);
-    glCheckError();
+
+  // now check the results
+  bool all_ok {true};
+  for (std::size_t i = 0; i < programs.size(); ++i) {
+    auto& build {builds[i]};
+    if (build.failed) {
+      all_ok = false;
+      continue;
+    }
+    if (!build.cached) {
+      GLint status {};
+      glGetProgramiv(build.info.id, GL_LINK_STATUS, &status);
+      if (status != GL_TRUE) {
+        for (const auto shader: build.shaders) {
+          if (!shader) continue;
+          glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+          if (status != GL_TRUE) printShaderLog(shader);
+        }
+        printProgramLog(build.info.id);
+        glDeleteProgram(build.info.id);
+        build.failed = true;
+      }
+      deleteShaders({build.shaders[0], build.shaders[1], build.shaders[2], build.shaders[3]});
+      if (build.failed) {
+        logError("Shader program \"" + programs[i].name + "\" failed to compile or link.");
+        all_ok = false;
+        continue;
+      }
+    }
+    // every program shares the same buffers for the common blocks
+    for (const auto& block: uniforms::block_bindings) {
+      const auto index {glGetUniformBlockIndex(build.info.id, block.name)};
+      if (index != GL_INVALID_INDEX) glUniformBlockBinding(build.info.id, index, block.binding);
+    }
+    shader_programs[programs[i].name] = {
+      build.info.id,
+      std::move(build.info.vertex),
+      std::move(build.info.fragment),
+      std::move(build.info.geometry),
+      ShaderProgram::reflectUniforms(build.info.id),
+      std::move(build.info.compute)
+    };
+    if (build.cached) {
+      logMessage("Shader program \"" + programs[i].name + "\" loaded from the binary cache.");
+    } else {
+      logMessage("Shader program \"" + programs[i].name + "\" successfully compiled and linked.");
+    }
   }
-	glLinkProgram(id);
-  glCheckError();
-  if (!printProgramLog(id)) {
-    deleteShaders({vertex_shader_id, fragment_shader_id, geometry_shader_id});
-    return false;
+
+  // the builds overlapped, so every program gets an even share of the time
+  if (compiled > 0) {
+    const auto source_ms {std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - source_start).count() / compiled};
+    for (std::size_t i = 0; i < programs.size(); ++i) {
+      if (builds[i].failed || builds[i].cached) continue;
+      ++binary_cache_stats.misses;
+      saveProgramBinary(shader_programs[programs[i].name].id, builds[i].binary_path, source_ms);
+    }
   }
-  // Clean
-	deleteShaders({vertex_shader_id, fragment_shader_id, geometry_shader_id});
-  // add shader to the maps
-  shader_programs[name] = {id, vertex_shader_code, fragment_shader_code, geometry_shader_code};
-  logMessage("Shader program \"" + name + "\" successfully compiled and linked.");
-  return true;
+  return all_ok;
 }
 
 void ktp::Resources::deleteShaders(const std::initializer_list<GLuint>& list) {
@@ -123,6 +210,32 @@ void ktp::Resources::deleteShaders(const std::initializer_list<GLuint>& list) {
   }
 }
 
+GLuint ktp::Resources::loadProgramBinary(const std::string& path, GLdouble& source_ms) {
+  std::ifstream file {path, std::ios::binary};
+  if (!file.is_open()) return 0;
+  ProgramBinaryHeader header {};
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+   || header.magic != ProgramBinaryHeader{}.magic
+   || header.length <= 0) {
+    return 0;
+  }
+  std::vector<char> binary(static_cast<std::size_t>(header.length));
+  if (!file.read(binary.data(), header.length)) return 0;
+  const GLuint id {glCreateProgram()};
+  glProgramBinary(id, header.format, binary.data(), header.length);
+  // the driver rejects binaries from other versions, that's not an error
+  glGetError();
+  GLint status {};
+  glGetProgramiv(id, GL_LINK_STATUS, &status);
+  if (status != GL_TRUE) {
+    glDeleteProgram(id);
+    logMessage("Program binary rejected by the driver, compiling from source. file: \"" + path + "\"");
+    return 0;
+  }
+  source_ms = header.source_ms;
+  return id;
+}
+
 std::string ktp::Resources::loadShaderSource(const std::string path) {
   std::ifstream file {path};
   if (!file.is_open()) return "";
@@ -132,6 +245,25 @@ std::string ktp::Resources::loadShaderSource(const std::string path) {
   return sstr.str();
 }
 
+std::string ktp::Resources::programBinaryPath(const std::string& name, const std::string& sources) {
+  // any change in the sources or the driver gives a new file
+  std::uint64_t hash {14695981039346656037ull};
+  const auto add {[&hash](std::string_view text) {
+    for (const auto c: text) hash = (hash ^ static_cast<std::uint8_t>(c)) * 1099511628211ull;
+  }};
+  const auto gl_string {[](GLenum string_name) {
+    const auto value {glGetString(string_name)};
+    return value ? std::string_view{reinterpret_cast<const char*>(value)} : std::string_view{};
+  }};
+  add(sources);
+  add(gl_string(GL_VENDOR));
+  add(gl_string(GL_RENDERER));
+  add(gl_string(GL_VERSION));
+  std::ostringstream path {};
+  path << binary_cache_path << '/' << name << '-' << std::hex << hash << ".bin";
+  return path.str();
+}
+
 bool ktp::Resources::printProgramLog(GLuint program) {
   // Make sure name is program
   if (glIsProgram(program)) {
@@ -175,3 +307,25 @@ bool ktp::Resources::printShaderLog(GLuint shader) {
   }
   return true;
 }
+
+void ktp::Resources::saveProgramBinary(GLuint program, const std::string& path, GLdouble source_ms) {
+  GLint formats {};
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  if (formats <= 0) return;
+  ProgramBinaryHeader header {};
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &header.length);
+  if (header.length <= 0) return;
+  std::vector<char> binary(static_cast<std::size_t>(header.length));
+  glGetProgramBinary(program, header.length, nullptr, &header.format, binary.data());
+  glCheckError();
+  header.source_ms = source_ms;
+  std::error_code error {};
+  std::filesystem::create_directories(binary_cache_path, error);
+  std::ofstream file {path, std::ios::binary | std::ios::trunc};
+  if (!file.is_open()) {
+    logError("Could NOT write program binary", path);
+    return;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(binary.data(), header.length);
+}
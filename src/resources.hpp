@@ -16,6 +16,7 @@
 #include "types.hpp"
 #include <initializer_list>
 #include <string>
+#include <vector>
 
 namespace ktp { namespace Resources {
 
@@ -28,10 +29,49 @@ struct ShaderProgramInfo {
   std::string vertex {};
   std::string fragment {};
   std::string geometry {};
+  UniformCache uniforms {};
+  std::string compute {};
 };
 
 extern ShaderPrograms shader_programs;
 
+/**
+ * @brief The files of a shader program to create. A compute program only
+ *  has the compute stage and leaves the rest empty.
+ */
+struct ShaderProgramPaths {
+  std::string name {};
+  std::string vertex {};
+  std::string fragment {};
+  std::string geometry {};
+  std::string compute {};
+};
+
+// where the linked program binaries are stored between runs
+constexpr auto binary_cache_path {"cache/shaders"};
+
+/**
+ * @brief What the program binary cache did during the last loadResources().
+ */
+struct BinaryCacheStats {
+  GLuint hits {};
+  GLuint misses {};
+  // time it took to build from source when the binary was saved minus the time to load it
+  GLdouble saved_ms {};
+};
+
+extern BinaryCacheStats binary_cache_stats;
+
+/**
+ * @brief The header of a program binary file, followed by the binary itself.
+ */
+struct ProgramBinaryHeader {
+  GLuint magic {0x4B545042}; // "KTPB"
+  GLenum format {};
+  GLint length {};
+  GLdouble source_ms {};
+};
+
 /**
  * @brief Compiles a shader.
  * @param shader The id of the shader.
@@ -41,7 +81,14 @@ extern ShaderPrograms shader_programs;
 bool compileShader(GLuint shader, const std::string& source);
 
 /**
- * @brief Loads and compiles a shader program.
+ * @brief Loads and compiles a compute program. See createShaderPrograms().
+ * @param name The name you wan to give to the program.
+ * @param compute_shader_path Compute shader file path.
+ */
+bool createComputeProgram(const std::string& name, const std::string& compute_shader_path);
+
+/**
+ * @brief Loads and compiles a shader program. See createShaderPrograms().
  * @param name The name you wan to give to the shader program.
  * @param vertex_shader_path Vertex shader file path.
  * @param fragment_shader_path Fragment shader file path.
@@ -49,6 +96,17 @@ bool compileShader(GLuint shader, const std::string& source);
  */
 bool createShaderProgram(const std::string& name, const std::string& vertex_shader_path, const std::string& fragment_shader_path, const std::string& geometry_shader_path = "");
 
+/**
+ * @brief Loads, compiles and links a batch of shader programs.
+ *  The files are read concurrently on the job system, then every compile
+ *  and link is issued before any status is queried, so the driver can
+ *  overlap the work (with GL_KHR_parallel_shader_compile when available).
+ *  Programs found in the binary cache skip the compilation.
+ * @param programs The programs to create.
+ * @return True if every program was created.
+ */
+bool createShaderPrograms(const std::vector<ShaderProgramPaths>& programs);
+
 /**
  * @brief Calls glDeleteShader for every shader given.
  * @param list The list of shaders to delete.
@@ -60,7 +118,18 @@ void deleteShaders(const std::initializer_list<GLuint>& list);
  * @param name The name of the shader you want.
  * @return A ShaderProgram with the shader requested.
  */
-inline auto getShaderProgram(const std::string& name) { return ShaderProgram{shader_programs.at(name).id}; }
+inline auto getShaderProgram(const std::string& name) {
+  const auto& info {shader_programs.at(name)};
+  return ShaderProgram{info.id, info.uniforms.empty() ? nullptr : &info.uniforms};
+}
+
+/**
+ * @brief Creates a program from a binary saved by saveProgramBinary().
+ * @param path The path to the binary file.
+ * @param source_ms Gets the time it took to build the program from source.
+ * @return The id of the program or 0 if the file is missing or the driver rejects it.
+ */
+GLuint loadProgramBinary(const std::string& path, GLdouble& source_ms);
 
 /**
  * @brief Reads a file that hopefully contains a shaders's source code.
@@ -69,6 +138,16 @@ inline auto getShaderProgram(const std::string& name) { return ShaderProgram{sha
  */
 std::string loadShaderSource(const std::string path);
 
+/**
+ * @brief Builds the path of the binary cache file of a program. The name of
+ *  the file includes a hash of the sources and the vendor, renderer and
+ *  version strings of the driver.
+ * @param name The name of the shader program.
+ * @param sources All the source code of the program.
+ * @return The path to the binary file.
+ */
+std::string programBinaryPath(const std::string& name, const std::string& sources);
+
 /**
  * @brief Prints any problems with the shader program.
  * @param program The id of the shader program.
@@ -81,6 +160,14 @@ bool printProgramLog(GLuint program);
  */
 bool printShaderLog(GLuint shader);
 
+/**
+ * @brief Saves the binary of a linked program to disk, if the driver supports it.
+ * @param program The id of the shader program.
+ * @param path The path to the binary file.
+ * @param source_ms The time it took to build the program from source.
+ */
+void saveProgramBinary(GLuint program, const std::string& path, GLdouble source_ms);
+
 } } // namespace resources/ktp
 
 #endif // KETEMINE_SRC_RESOURCES_HPP_
@@ -0,0 +1,559 @@
+#include "streaming.hpp"
+
+#include "jobs.hpp"
+#include "light.hpp"
+#include "mesher.hpp"
+#include "mpsc_queue.hpp"
+#include "region.hpp"
+#include "terrain.hpp"
+#include "visibility.hpp"
+#include <glm/common.hpp>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+
+enum class State { Generating, Generated, Meshing, Meshed };
+
+struct ChunkEntry {
+  State state {State::Generating};
+  // renewed with every job scheduled, results with another ticket are stale
+  GLuint ticket {};
+  // a block changed while the chunk was being meshed
+  bool dirty {false};
+  // the level of detail of the last mesh scheduled
+  GLuint lod {};
+  // a block changed since it was generated or loaded, it's saved when unloaded
+  bool modified {false};
+  // the light job of the chunk, one at a time so it owns the light while it runs
+  bool lighting {false};
+  GLuint light_ticket {};
+  // handed by the neighbours and the block changes, for the next light job
+  std::vector<light::Update> light_updates {};
+};
+
+struct GeneratedChunk {
+  ChunkPos pos {};
+  GLuint ticket {};
+  Chunk chunk {};
+  visibility::Connectivity connectivity {};
+  // lit by itself, the light crossing the border is routed by the main thread
+  ChunkLight light {};
+  std::vector<light::Handoff> handoffs {};
+};
+
+struct LitChunk {
+  ChunkPos pos {};
+  GLuint ticket {};
+  ChunkLight light {};
+  std::vector<light::Handoff> handoffs {};
+};
+
+struct MeshedChunk {
+  ChunkPos pos {};
+  GLuint ticket {};
+  GLuint lod {};
+  ChunkMesh mesh {};
+  // recomputed with the mesh, blocks may have changed
+  visibility::Connectivity connectivity {};
+};
+
+std::unordered_map<ChunkPos, ChunkEntry, ChunkPosHash> entries {};
+GLuint next_ticket {};
+
+// filled by the workers, emptied by the main thread
+MpscQueue<GeneratedChunk> generated_queue {};
+MpscQueue<MeshedChunk> meshed_queue {};
+MpscQueue<LitChunk> lit_queue {};
+jobs::Counter jobs_counter {};
+GLint jobs_in_flight {};
+
+std::deque<MeshedChunk> pending_uploads {};
+visibility::Graph visibility_graph {};
+streaming::ChunkGpuMeshes gpu_meshes {};
+// the quad indices are the same for every chunk
+std::unique_ptr<EBO> quad_ebo {};
+// every mesh lives in the arena and is drawn with the same VAO
+std::unique_ptr<VertexArena> vertex_arena {};
+std::unique_ptr<VAO> arena_vao {};
+GLuint linked_generation {};
+constexpr GLsizeiptr arena_initial_size {16 * 1024 * 1024};
+// meshes are written here and copied to their VBO by the GPU, without stalls
+std::unique_ptr<StreamBuffer> staging {};
+constexpr GLsizeiptr staging_region_size {4 * 1024 * 1024};
+
+// shared by the generation jobs, it's const
+std::unique_ptr<terrain::Generator> generator {};
+// the chunks modified by the player, generated chunks are never saved
+std::unique_ptr<region::Storage> storage {};
+const std::filesystem::path worlds_path {"worlds"};
+
+// horizontal offsets around the camera, closest first
+std::vector<glm::vec<2, GLint>> offsets {};
+GLint offsets_radius {-1};
+
+void buildOffsets(GLint radius) {
+  offsets.clear();
+  for (GLint z = -radius; z <= radius; ++z) {
+    for (GLint x = -radius; x <= radius; ++x) offsets.push_back({x, z});
+  }
+  std::sort(offsets.begin(), offsets.end(), [](const auto& a, const auto& b) {
+    return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y;
+  });
+  offsets_radius = radius;
+}
+
+GLint horizontalDistance(const ChunkPos& a, const ChunkPos& b) {
+  return glm::max(glm::abs(a.x - b.x), glm::abs(a.z - b.z));
+}
+
+// all the chunks touching the given one are generated or out of the world
+bool neighboursReady(const ChunkPos& pos) {
+  for (GLint y = -1; y <= 1; ++y) {
+    const auto neighbour_y {pos.y + y};
+    if (neighbour_y < streaming::settings.min_chunk_y || neighbour_y > streaming::settings.max_chunk_y) continue;
+    for (GLint z = -1; z <= 1; ++z) {
+      for (GLint x = -1; x <= 1; ++x) {
+        const auto entry {entries.find({pos.x + x, neighbour_y, pos.z + z})};
+        if (entry == entries.cend() || entry->second.state == State::Generating) return false;
+      }
+    }
+  }
+  return true;
+}
+
+void scheduleGeneration(const ChunkPos& pos) {
+  const auto ticket {++next_ticket};
+  entries[pos] = {State::Generating, ticket, false, 0u, false};
+  ++jobs_in_flight;
+  const bool open_sky {pos.y == streaming::settings.max_chunk_y};
+  jobs::run([pos, ticket, open_sky, &terrain_generator = *generator, &chunk_storage = *storage] {
+    GeneratedChunk generated {pos, ticket, {}, {}, {}, {}};
+    if (!chunk_storage.load(pos, generated.chunk)) terrain_generator.generate(pos, generated.chunk);
+    generated.connectivity = visibility::Connectivity::compute(generated.chunk);
+    std::vector<light::Update> updates {};
+    light::seed(generated.chunk, open_sky, updates);
+    light::propagate(pos, generated.chunk, generated.light, updates, generated.handoffs);
+    generated_queue.push(std::move(generated));
+  }, &jobs_counter);
+}
+
+void scheduleLighting(const World& world, const ChunkPos& pos, ChunkEntry& entry) {
+  const auto ticket {++next_ticket};
+  entry.lighting = true;
+  entry.light_ticket = ticket;
+  ++jobs_in_flight;
+  // copies, the blocks and the light may change while it runs
+  const auto chunk {std::make_shared<Chunk>(*world.chunk(pos))};
+  auto job_light {*world.light(pos)};
+  jobs::run([pos, ticket, chunk, job_light, updates = std::move(entry.light_updates)]() mutable {
+    LitChunk lit {pos, ticket, job_light, {}};
+    light::propagate(pos, *chunk, lit.light, updates, lit.handoffs);
+    lit_queue.push(std::move(lit));
+  }, &jobs_counter);
+  entry.light_updates.clear();
+}
+
+// chunks still generating are skipped, they take the light of their
+// neighbours once they are in the world
+void route(const std::vector<light::Handoff>& handoffs) {
+  auto entry {entries.end()};
+  for (const auto& handoff: handoffs) {
+    // the handoffs come in runs for the same chunk
+    if (entry == entries.end() || entry->first != handoff.pos) entry = entries.find(handoff.pos);
+    if (entry == entries.end() || entry->second.state == State::Generating) continue;
+    entry->second.light_updates.push_back(handoff.update);
+  }
+}
+
+// meshed again, without being saved for it
+void remesh(ChunkEntry& entry) {
+  switch (entry.state) {
+    case State::Meshing: entry.dirty = true; break;
+    case State::Meshed:  entry.state = State::Generated; break;
+    default: break;
+  }
+}
+
+// no light job running or waiting, meshing it now won't be wasted
+bool lightSettled(const ChunkEntry& entry) {
+  return !entry.lighting && entry.light_updates.empty();
+}
+
+// calls function with the offset of every chunk touching a block through a
+// face, an edge or a corner: -1, 0 or 1 per axis, the ones only where the
+// block is on that side of its chunk. 7 chunks at most, for a corner block
+template <typename Function>
+void forEachTouchingChunk(const ChunkPos& local, Function&& function) {
+  ChunkPos first {}, last {};
+  for (GLint axis = 0; axis < 3; ++axis) {
+    first[axis] = local[axis] == 0 ? -1 : 0;
+    last[axis] = local[axis] == Chunk::size - 1 ? 1 : 0;
+  }
+  for (GLint y = first.y; y <= last.y; ++y) {
+    for (GLint z = first.z; z <= last.z; ++z) {
+      for (GLint x = first.x; x <= last.x; ++x) {
+        if (x != 0 || y != 0 || z != 0) function(ChunkPos{x, y, z});
+      }
+    }
+  }
+}
+
+// the full detail meshes showing the light that changed: the one of the
+// chunk and the ones of the up to 26 neighbours whose padded copies include
+// a block of the border that changed, the diagonal ones read it for the
+// smooth light and the occlusion of their corners
+void remeshLit(const ChunkPos& pos, ChunkEntry& entry, const ChunkLight& old_light, const ChunkLight& new_light) {
+  if (old_light == new_light) return;
+  if (entry.lod == 0) remesh(entry);
+  bool touched[3][3][3] {};
+  for (GLint y = 0; y < Chunk::size; ++y) {
+    for (GLint z = 0; z < Chunk::size; ++z) {
+      // only the border, the inside is in no other padded copy
+      const auto inner_row {y > 0 && y < Chunk::size - 1 && z > 0 && z < Chunk::size - 1};
+      for (GLint x = 0; x < Chunk::size; x += inner_row ? Chunk::size - 1 : 1) {
+        const auto index {Chunk::index(x, y, z)};
+        if (old_light.get(LightChannel::Sky, index) == new_light.get(LightChannel::Sky, index)
+         && old_light.get(LightChannel::Block, index) == new_light.get(LightChannel::Block, index)) continue;
+        forEachTouchingChunk({x, y, z}, [&touched](const ChunkPos& offset) {
+          touched[offset.y + 1][offset.z + 1][offset.x + 1] = true;
+        });
+      }
+    }
+  }
+  for (GLint y = -1; y <= 1; ++y) {
+    for (GLint z = -1; z <= 1; ++z) {
+      for (GLint x = -1; x <= 1; ++x) {
+        if (!touched[y + 1][z + 1][x + 1]) continue;
+        const auto neighbour {entries.find(pos + ChunkPos{x, y, z})};
+        if (neighbour != entries.end() && neighbour->second.lod == 0) remesh(neighbour->second);
+      }
+    }
+  }
+}
+
+// full detail close to the camera, then rings twice as wide as the last one
+GLuint lodLevel(GLint distance) {
+  GLuint level {0};
+  auto ring {streaming::settings.lod_distance};
+  while (distance > ring && level < mesher::max_lod) {
+    ++level;
+    ring *= 2;
+  }
+  return level;
+}
+
+void scheduleMeshing(const World& world, const ChunkPos& pos, ChunkEntry& entry, GLuint lod) {
+  const auto ticket {++next_ticket};
+  entry.state = State::Meshing;
+  entry.ticket = ticket;
+  entry.lod = lod;
+  ++jobs_in_flight;
+  // the workers never touch the world, they get a copy
+  if (lod > 0) {
+    const auto chunk {std::make_shared<Chunk>(*world.chunk(pos))};
+    jobs::run([pos, ticket, lod, chunk] {
+      MeshedChunk meshed {pos, ticket, lod, {}, {}};
+      mesher::lod(*chunk, lod, meshed.mesh);
+      meshed.connectivity = visibility::Connectivity::compute(*chunk);
+      meshed_queue.push(std::move(meshed));
+    }, &jobs_counter);
+    return;
+  }
+  const auto padded {std::make_shared<PaddedChunk>()};
+  mesher::copyNeighbourhood(world, pos, *padded);
+  jobs::run([pos, ticket, padded] {
+    MeshedChunk meshed {pos, ticket, 0u, {}, {}};
+    mesher::greedy(*padded, meshed.mesh);
+    meshed.connectivity = visibility::Connectivity::compute(*padded);
+    meshed_queue.push(std::move(meshed));
+  }, &jobs_counter);
+}
+
+void eraseMesh(const ChunkPos& pos) {
+  const auto found {gpu_meshes.find(pos)};
+  if (found == gpu_meshes.end()) return;
+  vertex_arena->free(found->second.allocation);
+  gpu_meshes.erase(found);
+}
+
+// the arena replaces its buffer when it grows or it's defragmented
+void linkArena() {
+  if (linked_generation == vertex_arena->generation()) return;
+  arena_vao->linkAttribI(vertex_arena->vbo(), 0, 2, GL_UNSIGNED_INT, sizeof(ChunkVertex), nullptr);
+  arena_vao->unbind();
+  linked_generation = vertex_arena->generation();
+}
+
+void upload(MeshedChunk& meshed) {
+  if (meshed.mesh.vertices.empty()) {
+    eraseMesh(meshed.pos);
+    return;
+  }
+  auto [found, inserted] {gpu_meshes.try_emplace(meshed.pos)};
+  auto& gpu_mesh {found->second};
+  if (inserted) gpu_mesh.origin = Point3D(meshed.pos * Chunk::size);
+  gpu_mesh.lod = meshed.lod;
+  const auto size {static_cast<GLsizeiptr>(meshed.mesh.vertices.size() * sizeof(ChunkVertex))};
+  // keep the range unless the mesh outgrew it or shrank to less than half of it
+  if (gpu_mesh.allocation != VertexArena::invalid_handle) {
+    const auto allocated {vertex_arena->size(gpu_mesh.allocation)};
+    if (size > allocated || size < allocated / 2) {
+      vertex_arena->free(gpu_mesh.allocation);
+      gpu_mesh.allocation = VertexArena::invalid_handle;
+    }
+  }
+  if (gpu_mesh.allocation == VertexArena::invalid_handle) gpu_mesh.allocation = vertex_arena->allocate(size);
+  const auto arena_offset {vertex_arena->offset(gpu_mesh.allocation)};
+  vertex_arena->vbo().bind();
+  const auto offset {staging->allocate(size)};
+  if (offset >= 0) {
+    std::memcpy(staging->data(offset), meshed.mesh.vertices.data(), static_cast<std::size_t>(size));
+    glBindBuffer(GL_COPY_READ_BUFFER, staging->id());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, offset, arena_offset, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  } else {
+    // no buffer storage, or the region is full
+    glBufferSubData(GL_ARRAY_BUFFER, arena_offset, size, meshed.mesh.vertices.data());
+  }
+  streaming::stats.uploaded_bytes_last_frame += static_cast<std::size_t>(size);
+  gpu_mesh.index_count = static_cast<GLsizei>(meshed.mesh.quadCount() * 6u);
+}
+
+} // namespace
+
+ktp::streaming::Settings ktp::streaming::settings {};
+ktp::streaming::Stats ktp::streaming::stats {};
+
+void ktp::streaming::clean() {
+  jobs::wait(jobs_counter);
+  generated_queue.consume([](GeneratedChunk&&) {});
+  meshed_queue.consume([](MeshedChunk&&) {});
+  lit_queue.consume([](LitChunk&&) {});
+  jobs_in_flight = 0;
+  pending_uploads.clear();
+  gpu_meshes.clear();
+  entries.clear();
+  visibility_graph = {};
+  arena_vao.reset();
+  vertex_arena.reset();
+  quad_ebo.reset();
+  staging.reset();
+  generator.reset();
+  // writes what's still queued
+  storage.reset();
+}
+
+const ktp::VertexArena& ktp::streaming::arena() {
+  return *vertex_arena;
+}
+
+void ktp::streaming::defragment() {
+  vertex_arena->defragment();
+  linkArena();
+}
+
+void ktp::streaming::init() {
+  UshortArray indices {};
+  mesher::quadIndices(mesher::max_quads, indices);
+  vertex_arena = std::make_unique<VertexArena>(arena_initial_size, static_cast<GLsizei>(sizeof(ChunkVertex)));
+  arena_vao = std::make_unique<VAO>();
+  arena_vao->bind();
+  quad_ebo = std::make_unique<EBO>();
+  quad_ebo->setup(indices);
+  arena_vao->linkAttribI(vertex_arena->vbo(), 0, 2, GL_UNSIGNED_INT, sizeof(ChunkVertex), nullptr);
+  arena_vao->unbind();
+  linked_generation = vertex_arena->generation();
+  staging = std::make_unique<StreamBuffer>(staging_region_size);
+  generator = std::make_unique<terrain::Generator>(settings.seed);
+  // one directory per seed, a world saved with one seed makes no sense with another
+  storage = std::make_unique<region::Storage>(worlds_path / std::to_string(settings.seed));
+}
+
+void ktp::streaming::markDirty(const ChunkPos& pos) {
+  const auto entry {entries.find(pos)};
+  if (entry == entries.end()) return;
+  if (entry->second.state != State::Generating) entry->second.modified = true;
+  remesh(entry->second);
+}
+
+bool ktp::streaming::setBlock(World& world, GLint x, GLint y, GLint z, BlockID block) {
+  const auto pos {World::chunkPosition(x, y, z)};
+  const auto entry {entries.find(pos)};
+  if (entry == entries.end() || entry->second.state == State::Generating) return false;
+  const auto local {glm::vec<3, GLint>{World::localCoord(x), World::localCoord(y), World::localCoord(z)}};
+  const auto index {Chunk::index(local.x, local.y, local.z)};
+  auto& chunk {*world.chunk(pos)};
+  if (chunk.get(index) == block) return true;
+  chunk.set(index, block);
+  markDirty(pos);
+  // a block on the border is in the meshes of the neighbours too, the faces
+  // next to it and the occlusion of the corners of the diagonal ones
+  forEachTouchingChunk(local, [&pos](const ChunkPos& offset) {
+    const auto neighbour {entries.find(pos + offset)};
+    if (neighbour != entries.end()) remesh(neighbour->second);
+  });
+  std::vector<light::Handoff> handoffs {};
+  light::changed(pos, index, pos.y == settings.max_chunk_y && local.y == Chunk::size - 1, handoffs);
+  route(handoffs);
+  return true;
+}
+
+void ktp::streaming::save(const World& world) {
+  for (auto& [pos, entry]: entries) {
+    if (!entry.modified) continue;
+    const auto chunk {world.chunk(pos)};
+    if (chunk) storage->save(pos, *chunk);
+    entry.modified = false;
+  }
+}
+
+const ktp::streaming::ChunkGpuMeshes& ktp::streaming::meshes() {
+  return gpu_meshes;
+}
+
+const ktp::visibility::Graph& ktp::streaming::visibilityGraph() {
+  return visibility_graph;
+}
+
+const ktp::VAO& ktp::streaming::vao() {
+  return *arena_vao;
+}
+
+void ktp::streaming::update(World& world, const Point3D& camera_position) {
+  // 1. collect the finished jobs
+  generated_queue.consume([&world](GeneratedChunk&& generated) {
+    --jobs_in_flight;
+    const auto entry {entries.find(generated.pos)};
+    if (entry == entries.end() || entry->second.ticket != generated.ticket) return;
+    world.insertChunk(generated.pos, std::move(generated.chunk));
+    world.insertLight(generated.pos, generated.light);
+    visibility_graph.set(generated.pos, generated.connectivity);
+    entry->second.state = State::Generated;
+    // the light of the neighbours coming in, and the one of the chunk going out
+    for (const auto& face: {ChunkPos{1, 0, 0}, ChunkPos{-1, 0, 0}, ChunkPos{0, 1, 0}, ChunkPos{0, -1, 0}, ChunkPos{0, 0, 1}, ChunkPos{0, 0, -1}}) {
+      const auto neighbour_light {world.light(generated.pos + face)};
+      if (neighbour_light) light::border(*neighbour_light, generated.pos + face, generated.pos, entry->second.light_updates);
+    }
+    route(generated.handoffs);
+  });
+  lit_queue.consume([&world](LitChunk&& lit) {
+    --jobs_in_flight;
+    const auto entry {entries.find(lit.pos)};
+    if (entry == entries.end() || entry->second.light_ticket != lit.ticket) return;
+    entry->second.lighting = false;
+    auto& chunk_light {*world.light(lit.pos)};
+    remeshLit(lit.pos, entry->second, chunk_light, lit.light);
+    chunk_light = lit.light;
+    route(lit.handoffs);
+  });
+  meshed_queue.consume([](MeshedChunk&& meshed) {
+    --jobs_in_flight;
+    const auto entry {entries.find(meshed.pos)};
+    if (entry == entries.end() || entry->second.ticket != meshed.ticket) return;
+    if (entry->second.dirty) {
+      // outdated, mesh it again
+      entry->second.dirty = false;
+      entry->second.state = State::Generated;
+      return;
+    }
+    entry->second.state = State::Meshed;
+    visibility_graph.set(meshed.pos, meshed.connectivity);
+    pending_uploads.push_back(std::move(meshed));
+  });
+
+  const auto camera_block {glm::floor(camera_position)};
+  const auto center {World::chunkPosition(
+    static_cast<GLint>(camera_block.x),
+    static_cast<GLint>(camera_block.y),
+    static_cast<GLint>(camera_block.z)
+  )};
+  // generate one ring further than what's meshed, meshing needs the neighbours
+  const auto generation_radius {settings.view_distance + 1};
+  if (offsets_radius != generation_radius) buildOffsets(generation_radius);
+
+  // 2. unload what's out of range, with one ring of margin to avoid thrashing
+  for (auto entry = entries.begin(); entry != entries.end();) {
+    if (horizontalDistance(entry->first, center) > generation_radius + 1) {
+      if (entry->second.modified) storage->save(entry->first, *world.chunk(entry->first));
+      world.removeChunk(entry->first);
+      eraseMesh(entry->first);
+      visibility_graph.erase(entry->first);
+      entry = entries.erase(entry);
+    } else {
+      ++entry;
+    }
+  }
+
+  // 3. schedule the jobs, the light first, it's quick and the meshes wait for it
+  for (auto& [pos, entry]: entries) {
+    if (jobs_in_flight >= settings.max_jobs_in_flight) break;
+    if (!entry.lighting && !entry.light_updates.empty()) scheduleLighting(world, pos, entry);
+  }
+  // then the closest chunks first
+  for (const auto& offset: offsets) {
+    if (jobs_in_flight >= settings.max_jobs_in_flight) break;
+    const auto distance {glm::max(glm::abs(offset.x), glm::abs(offset.y))};
+    for (GLint y = settings.min_chunk_y; y <= settings.max_chunk_y; ++y) {
+      if (jobs_in_flight >= settings.max_jobs_in_flight) break;
+      const ChunkPos pos {center.x + offset.x, y, center.z + offset.y};
+      const auto entry {entries.find(pos)};
+      if (entry == entries.end()) {
+        scheduleGeneration(pos);
+        continue;
+      }
+      if (distance > settings.view_distance) continue;
+      const auto lod {lodLevel(distance)};
+      if (entry->second.state == State::Generated && neighboursReady(pos) && lightSettled(entry->second)) {
+        scheduleMeshing(world, pos, entry->second, lod);
+      } else if (entry->second.state == State::Meshed && entry->second.lod != lod) {
+        // the camera moved, the old mesh stays until the new one is uploaded
+        scheduleMeshing(world, pos, entry->second, lod);
+      }
+    }
+  }
+
+  // 4. upload a bounded number of meshes
+  stats.uploaded_last_frame = 0;
+  stats.uploaded_bytes_last_frame = 0;
+  while (!pending_uploads.empty() && stats.uploaded_last_frame < static_cast<std::size_t>(settings.upload_budget)) {
+    auto meshed {std::move(pending_uploads.front())};
+    pending_uploads.pop_front();
+    const auto entry {entries.find(meshed.pos)};
+    if (entry == entries.end() || entry->second.ticket != meshed.ticket) continue;
+    upload(meshed);
+    ++stats.uploaded_last_frame;
+  }
+  // the copies were just issued, the region is free once they are done
+  staging->fence();
+  linkArena();
+  stats.staging_stalls = staging->stalls();
+
+  stats.chunks_loaded = world.chunkCount();
+  stats.meshes_on_gpu = gpu_meshes.size();
+  stats.lod_meshes = {};
+  stats.vertices = 0;
+  for (const auto& [pos, mesh]: gpu_meshes) {
+    ++stats.lod_meshes[mesh.lod];
+    stats.vertices += static_cast<std::size_t>(mesh.index_count) / 6u * 4u;
+  }
+  stats.generating = 0;
+  stats.meshing = 0;
+  stats.lighting = 0;
+  stats.light_updates = 0;
+  for (const auto& [pos, entry]: entries) {
+    if (entry.state == State::Generating) ++stats.generating;
+    else if (entry.state == State::Meshing) ++stats.meshing;
+    if (entry.lighting) ++stats.lighting;
+    stats.light_updates += entry.light_updates.size();
+  }
+  stats.pending_uploads = pending_uploads.size();
+  stats.storage = storage->stats();
+}
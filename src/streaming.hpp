@@ -0,0 +1,167 @@
+/**
+ * @file streaming.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Loads, meshes and uploads the chunks around the camera.
+ * @version 0.1
+ * @date 2022-11-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_STREAMING_HPP_)
+#define KETEMINE_SRC_STREAMING_HPP_
+
+#include "mesher.hpp"
+#include "opengl.hpp"
+#include "region.hpp"
+#include "types.hpp"
+#include "vertex_arena.hpp"
+#include "visibility.hpp"
+#include "world.hpp"
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+
+namespace ktp { namespace streaming {
+
+/**
+ * @brief The knobs of the streaming pipeline.
+ */
+struct Settings {
+  // horizontal radius, in chunks, of the area kept loaded around the camera
+  GLint view_distance {8};
+  // horizontal radius, in chunks, meshed at full detail. Every ring after it
+  // is twice as wide as the last one and has half the detail, down to 8x8x8
+  // blocks per cell. Lower it to see further with fewer vertices
+  GLint lod_distance {6};
+  // vertical range of the world, in chunks
+  GLint min_chunk_y {0};
+  GLint max_chunk_y {7};
+  // meshes uploaded to the GPU per frame at most
+  GLint upload_budget {8};
+  // generation, light and meshing jobs running at the same time at most
+  GLint max_jobs_in_flight {64};
+  // of the terrain generator, read by init()
+  GLint seed {1337};
+};
+
+/**
+ * @brief What the pipeline is doing, refreshed every update.
+ */
+struct Stats {
+  std::size_t chunks_loaded {};
+  std::size_t meshes_on_gpu {};
+  std::size_t generating {};
+  std::size_t meshing {};
+  // light jobs running, and the updates waiting for the next ones
+  std::size_t lighting {};
+  std::size_t light_updates {};
+  std::size_t pending_uploads {};
+  std::size_t uploaded_last_frame {};
+  std::size_t uploaded_bytes_last_frame {};
+  // times the CPU waited for the GPU to free a staging region
+  std::size_t staging_stalls {};
+  // meshes on the GPU per level of detail, and their vertices
+  std::array<std::size_t, mesher::max_lod + 1> lod_meshes {};
+  std::size_t vertices {};
+  // chunks read from and written to the region files
+  region::Storage::Stats storage {};
+};
+
+/**
+ * @brief The GPU side of a chunk mesh.
+ */
+struct ChunkGpuMesh {
+  // the range of the vertex arena holding the vertices
+  VertexArena::Handle allocation {VertexArena::invalid_handle};
+  GLsizei index_count {};
+  Point3D origin {};
+  // 0 is full detail, see Settings::lod_distance
+  GLuint lod {};
+};
+
+using ChunkGpuMeshes = std::unordered_map<ChunkPos, ChunkGpuMesh, ChunkPosHash>;
+
+extern Settings settings;
+extern Stats stats;
+
+/**
+ * @brief Waits for the jobs in flight and frees every mesh. Call before
+ *  destroying the OpenGL context.
+ */
+void clean();
+
+/**
+ * @return The arena holding the vertices of every chunk mesh.
+ */
+const VertexArena& arena();
+
+/**
+ * @brief Packs the chunk meshes in the vertex arena.
+ */
+void defragment();
+
+/**
+ * @brief Creates the OpenGL objects shared by the chunk meshes, the
+ *  staging buffer the meshes are uploaded through, the terrain generator
+ *  and the storage of the world, in worlds/<seed>.
+ */
+void init();
+
+/**
+ * @brief Flags a loaded chunk to be meshed again and saved when it's
+ *  unloaded, i.e. when a block changes.
+ * @param pos The chunk position.
+ */
+void markDirty(const ChunkPos& pos);
+
+/**
+ * @return The uploaded meshes. Draw them with vao() bound, GL_UNSIGNED_SHORT
+ *  indices and the base vertex of their allocation in the arena.
+ */
+const ChunkGpuMeshes& meshes();
+
+/**
+ * @brief Sets a block of a loaded chunk, meshes again the chunks showing it
+ *  and relights around it on the light jobs.
+ * @param world The world.
+ * @param x World x coordinate.
+ * @param y World y coordinate.
+ * @param z World z coordinate.
+ * @param block The block id.
+ * @return False if the chunk isn't loaded yet.
+ */
+bool setBlock(World& world, GLint x, GLint y, GLint z, BlockID block);
+
+/**
+ * @brief Runs the main thread side of the pipeline. Collects the finished
+ *  jobs, routes the light crossing between chunks, unloads far away chunks
+ *  and schedules light jobs, then generation and meshing jobs around the
+ *  camera, closest first. Then uploads at most settings.upload_budget meshes.
+ * @param world The world.
+ * @param camera_position The position of the camera.
+ */
+void update(World& world, const Point3D& camera_position);
+
+/**
+ * @brief Queues every modified chunk to be written to the region files.
+ *  Chunks are saved when they are unloaded too, call it before clean().
+ * @param world The world.
+ */
+void save(const World& world);
+
+/**
+ * @return The VAO reading the vertex arena, shared by every chunk mesh.
+ */
+const VAO& vao();
+
+/**
+ * @return The face connectivity of every generated chunk, updated when a chunk
+ *  is generated or meshed again.
+ */
+const visibility::Graph& visibilityGraph();
+
+} } // namespace streaming/ktp
+
+#endif // KETEMINE_SRC_STREAMING_HPP_
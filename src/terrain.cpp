@@ -0,0 +1,210 @@
+#include "terrain.hpp"
+
+#include "chunk.hpp"
+#include <glm/common.hpp>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+using namespace ktp;
+
+struct BiomeInfo {
+  // the climate where the biome is the strongest
+  GLfloat temperature;
+  GLfloat humidity;
+  // the height of the terrain, and how far the relief moves it up and down
+  GLfloat base_height;
+  GLfloat amplitude;
+  BlockID surface;
+  // the blocks under the surface, above the stone
+  BlockID filler;
+  GLint filler_depth;
+};
+
+// indexed by terrain::Biome
+constexpr std::array<BiomeInfo, 4> biomes {{
+  { 0.6f, -0.5f, 52.f,  4.f, Blocks::sand,  Blocks::sand,  4},
+  { 0.2f,  0.2f, 56.f, 10.f, Blocks::grass, Blocks::dirt,  3},
+  {-0.1f,  0.6f, 74.f, 40.f, Blocks::stone, Blocks::stone, 1},
+  {-0.6f, -0.2f, 58.f, 14.f, Blocks::snow,  Blocks::dirt,  2}
+}};
+
+// the higher, the narrower the transitions between biomes
+constexpr GLfloat blend_sharpness {12.f};
+// the continent noise where the coast is, and how deep the ocean floor sinks
+constexpr GLfloat coast {-0.15f};
+constexpr GLfloat ocean_depth {30.f};
+// bare stone above it is covered with snow
+constexpr GLint snow_line {100};
+// the tunnels are where the squared values of both cave noises add up less than this
+constexpr GLfloat cave_threshold {0.01f};
+// caves stay this deep below the floor of the seas, so they don't flood
+constexpr GLint cave_roof {4};
+
+struct Ore {
+  BlockID block;
+  // only in cells lower than it
+  GLint max_y;
+  // chance per 4x4x4 cell, out of 1024
+  std::uint32_t chance;
+};
+
+// rarest first, a cell gets the first one its roll falls in
+constexpr std::array<Ore, 3> ores {{
+  {Blocks::gold_ore, 32, 6},
+  {Blocks::iron_ore, 64, 18},
+  {Blocks::coal_ore, 96, 36}
+}};
+
+constexpr GLint ore_cell_size {4};
+constexpr GLint ore_cells {Chunk::size / ore_cell_size};
+// squared distance from the centre of the vein
+constexpr GLint ore_radius {2};
+
+std::uint32_t hash(GLint seed, GLint x, GLint y, GLint z) {
+  auto h {static_cast<std::uint32_t>(seed)
+    ^ (static_cast<std::uint32_t>(x) * 501125321u)
+    ^ (static_cast<std::uint32_t>(y) * 1136930381u)
+    ^ (static_cast<std::uint32_t>(z) * 1720413743u)};
+  h *= 0x27d4eb2du;
+  h ^= h >> 15;
+  h *= 0x2c1b3c6du;
+  return h ^ (h >> 13);
+}
+
+// every noise gets its own seed, derived from the one of the world
+GLint deriveSeed(GLint seed, GLint salt) {
+  return static_cast<GLint>(hash(seed, salt, 0, 0));
+}
+
+struct Surface {
+  GLint height;
+  BlockID surface;
+  BlockID filler;
+  GLint filler_depth;
+  // under the sea level
+  bool submerged;
+};
+
+} // namespace
+
+ktp::terrain::Generator::Generator(GLint seed):
+ m_seed{seed},
+ m_temperature{.type = noise::Type::Simplex, .seed = deriveSeed(seed, 1), .octaves = 3, .frequency = 0.002f, .warp_amplitude = 40.f},
+ m_humidity{.type = noise::Type::Simplex, .seed = deriveSeed(seed, 2), .octaves = 3, .frequency = 0.002f, .warp_amplitude = 40.f},
+ m_continents{.type = noise::Type::Simplex, .seed = deriveSeed(seed, 3), .octaves = 4, .frequency = 0.0015f},
+ m_relief{.type = noise::Type::Simplex, .seed = deriveSeed(seed, 4), .octaves = 5, .frequency = 0.008f},
+ m_cave_a{.type = noise::Type::Simplex, .seed = deriveSeed(seed, 5), .octaves = 1, .frequency = 0.025f},
+ m_cave_b{.type = noise::Type::Simplex, .seed = deriveSeed(seed, 6), .octaves = 1, .frequency = 0.025f} {}
+
+void ktp::terrain::Generator::generate(const ChunkPos& pos, Chunk& chunk) const {
+  chunk.fill(Blocks::air);
+  const auto origin {pos * Chunk::size};
+
+  // the heightmap, the same for every chunk of the column
+  noise::Column temperature {}, humidity {}, continents {}, relief {};
+  noise::fillColumn(m_temperature, origin.x, origin.z, temperature);
+  noise::fillColumn(m_humidity, origin.x, origin.z, humidity);
+  noise::fillColumn(m_continents, origin.x, origin.z, continents);
+  noise::fillColumn(m_relief, origin.x, origin.z, relief);
+  std::array<Surface, Chunk::size * Chunk::size> surfaces {};
+  GLint max_height {};
+  for (std::size_t i = 0; i < surfaces.size(); ++i) {
+    // every biome pulls the terrain towards its own shape, by its closeness in climate
+    GLfloat height {}, total_weight {}, best_weight {};
+    std::size_t best {};
+    for (std::size_t b = 0; b < biomes.size(); ++b) {
+      const auto dt {temperature[i] - biomes[b].temperature};
+      const auto dh {humidity[i] - biomes[b].humidity};
+      const auto weight {std::exp(-blend_sharpness * (dt * dt + dh * dh))};
+      height += weight * (biomes[b].base_height + biomes[b].amplitude * relief[i]);
+      total_weight += weight;
+      if (weight > best_weight) {
+        best_weight = weight;
+        best = b;
+      }
+    }
+    height /= total_weight;
+    height -= ocean_depth * glm::clamp((coast - continents[i]) * 5.f, 0.f, 1.f);
+    auto& surface {surfaces[i]};
+    surface.height = glm::max(static_cast<GLint>(std::floor(height)), 1);
+    surface.submerged = surface.height < sea_level;
+    if (surface.height <= sea_level + 1) {
+      // beaches and sea floor
+      surface.surface = surface.filler = Blocks::sand;
+      surface.filler_depth = 3;
+    } else {
+      surface.surface = biomes[best].surface;
+      surface.filler = biomes[best].filler;
+      surface.filler_depth = biomes[best].filler_depth;
+      if (surface.surface == Blocks::stone && surface.height >= snow_line) surface.surface = Blocks::snow;
+    }
+    max_height = glm::max(max_height, surface.height);
+  }
+  if (origin.y > glm::max(max_height, sea_level)) return;
+
+  // caves, only where there's ground to carve
+  const bool caves {origin.y <= max_height};
+  noise::Section cave_a {}, cave_b {};
+  if (caves) {
+    noise::fillSection(m_cave_a, origin, cave_a);
+    noise::fillSection(m_cave_b, origin, cave_b);
+  }
+
+  // one roll per cell for an ore vein, centred somewhere in the cell
+  struct Vein { BlockID block; GLint x, y, z; };
+  std::array<Vein, ore_cells * ore_cells * ore_cells> veins {};
+  for (GLint cy = 0; cy < ore_cells; ++cy) {
+    for (GLint cz = 0; cz < ore_cells; ++cz) {
+      for (GLint cx = 0; cx < ore_cells; ++cx) {
+        const auto x {cx * ore_cell_size}, y {cy * ore_cell_size}, z {cz * ore_cell_size};
+        const auto h {hash(m_seed, origin.x + x, origin.y + y, origin.z + z)};
+        auto& vein {veins[static_cast<std::size_t>((cy * ore_cells + cz) * ore_cells + cx)]};
+        vein = {Blocks::air, x + static_cast<GLint>((h >> 10) & 3u), y + static_cast<GLint>((h >> 12) & 3u), z + static_cast<GLint>((h >> 14) & 3u)};
+        auto roll {h & 1023u};
+        for (const auto& ore: ores) {
+          if (origin.y + y >= ore.max_y) continue;
+          if (roll < ore.chance) {
+            vein.block = ore.block;
+            break;
+          }
+          roll -= ore.chance;
+        }
+      }
+    }
+  }
+
+  for (GLint y = 0; y < Chunk::size; ++y) {
+    const auto world_y {origin.y + y};
+    for (GLint z = 0; z < Chunk::size; ++z) {
+      for (GLint x = 0; x < Chunk::size; ++x) {
+        const auto& surface {surfaces[static_cast<std::size_t>((z << 4) | x)]};
+        if (world_y > surface.height) {
+          if (world_y <= sea_level) chunk.set(x, y, z, Blocks::water);
+          continue;
+        }
+        const auto index {Chunk::index(x, y, z)};
+        const auto depth {surface.height - world_y};
+        if (caves && !(surface.submerged && depth < cave_roof)
+         && cave_a[index] * cave_a[index] + cave_b[index] * cave_b[index] < cave_threshold) {
+          continue;
+        }
+        auto block {Blocks::stone};
+        if (depth == 0) {
+          block = surface.surface;
+        } else if (depth <= surface.filler_depth) {
+          block = surface.filler;
+        } else {
+          const auto& vein {veins[static_cast<std::size_t>(((y / ore_cell_size) * ore_cells + z / ore_cell_size) * ore_cells + x / ore_cell_size)]};
+          const auto dx {x - vein.x}, dy {y - vein.y}, dz {z - vein.z};
+          if (vein.block != Blocks::air && dx * dx + dy * dy + dz * dz <= ore_radius) block = vein.block;
+        }
+        chunk.set(index, block);
+      }
+    }
+  }
+  chunk.optimize();
+}
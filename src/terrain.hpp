@@ -0,0 +1,77 @@
+/**
+ * @file terrain.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Terrain generation.
+ * @version 0.1
+ * @date 2022-11-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_TERRAIN_HPP_)
+#define KETEMINE_SRC_TERRAIN_HPP_
+
+#include "noise.hpp"
+#include "types.hpp"
+
+namespace ktp { namespace terrain {
+
+enum class Biome {
+  Desert,
+  Plains,
+  Mountains,
+  Tundra
+};
+
+/**
+ * @brief Generates the chunks of a world from a seed: a heightmap blended
+ *  between biomes, water up to the sea level, caves carved by 3D noise and
+ *  ore veins. A block only depends on the seed and its position, never on
+ *  what was generated before, so the world is the same whatever the order
+ *  of the chunks or the number of threads generating them.
+ */
+class Generator {
+
+ public:
+
+  // blocks at or below it are water where there's no terrain
+  static constexpr GLint sea_level {48};
+
+  /**
+   * @brief Creates the generator.
+   * @param seed The seed of the world.
+   */
+  explicit Generator(GLint seed);
+
+  /**
+   * @brief Fills a chunk with the terrain at its position. Const and
+   *  without shared state, so it's safe to call from any thread.
+   * @param pos The chunk position.
+   * @param chunk The chunk to fill.
+   */
+  void generate(const ChunkPos& pos, Chunk& chunk) const;
+
+  /**
+   * @return The seed of the world.
+   */
+  auto seed() const { return m_seed; }
+
+ private:
+
+  GLint m_seed {};
+  // climate, picks the biomes and how they blend
+  noise::Fractal m_temperature {};
+  noise::Fractal m_humidity {};
+  // oceans where it's negative
+  noise::Fractal m_continents {};
+  // hills, scaled by the amplitude of the biomes
+  noise::Fractal m_relief {};
+  // the caves are the tunnels where both are close to 0
+  noise::Fractal m_cave_a {};
+  noise::Fractal m_cave_b {};
+};
+
+} } // namespace terrain/ktp
+
+#endif // KETEMINE_SRC_TERRAIN_HPP_
@@ -14,6 +14,8 @@
 
 #include <GL/glew.h>
 #include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -23,11 +25,14 @@ struct GLFWwindow;
 
 namespace ktp {
 
+  class Camera;
+  class Chunk;
   class EBO;
   class ShaderProgram;
   class Texture2D;
   class VAO;
   class VBO;
+  class World;
 
   using Size2D  = glm::vec<2, GLint>;
   using Size2Du = glm::vec<2, GLuint>;
@@ -35,6 +40,11 @@ namespace ktp {
   using Vector3 = Point3D;
   using FloatArray = std::vector<GLfloat>;
   using UintArray  = std::vector<GLuint>;
+  using UshortArray = std::vector<GLushort>;
+
+  using BlockID  = std::uint16_t;
+  using BlockPos = glm::vec<3, GLint>;
+  using ChunkPos = glm::vec<3, GLint>;
 
   namespace Resources {
     struct ShaderProgramInfo;
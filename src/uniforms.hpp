@@ -0,0 +1,61 @@
+/**
+ * @file uniforms.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief The buffer blocks shared by the C++ side and the shaders.
+ * @version 0.1
+ * @date 2022-11-30
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_UNIFORMS_HPP_)
+#define KETEMINE_SRC_UNIFORMS_HPP_
+
+#include "opengl.hpp"
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <cstddef>
+
+namespace ktp { namespace uniforms {
+
+/**
+ * @brief Binds a named block of a program to a binding point.
+ */
+struct BlockBinding {
+  const char* name;
+  GLuint binding;
+};
+
+// keep them in sync with the layout(binding = N) of the shaders
+constexpr GLuint frame_binding {0};
+
+// Resources binds these to every program declaring them,
+// so shaders without an explicit binding get them too
+constexpr BlockBinding block_bindings[] {
+  {"Frame", frame_binding}
+};
+
+/**
+ * @brief The constants of a frame, the Frame block of the shaders.
+ *  Uploaded once per frame.
+ */
+struct Frame {
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::mat4 view_projection;
+  // w unused
+  glm::vec4 camera_position;
+  // x: seconds since start, y: delta time
+  glm::vec4 time;
+};
+
+KTP_STD140_MEMBER(Frame, view);
+KTP_STD140_MEMBER(Frame, projection);
+KTP_STD140_MEMBER(Frame, view_projection);
+KTP_STD140_MEMBER(Frame, camera_position);
+KTP_STD140_MEMBER(Frame, time);
+
+} } // namespace uniforms/ktp
+
+#endif // KETEMINE_SRC_UNIFORMS_HPP_
@@ -0,0 +1,153 @@
+#include "vertex_arena.hpp"
+
+#include <algorithm>
+
+namespace {
+
+constexpr GLsizeiptr roundUp(GLsizeiptr value, GLsizeiptr multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+ktp::VertexArena::VertexArena(GLsizeiptr capacity, GLsizei stride):
+ m_stride(stride),
+ m_granularity(stride * 64) {
+  m_capacity = roundUp(capacity, m_granularity);
+  m_vbo.setup(nullptr, m_capacity, GL_DYNAMIC_DRAW);
+  m_vbo.unbind();
+  addFree(0, m_capacity);
+}
+
+void ktp::VertexArena::addFree(GLsizeiptr offset, GLsizeiptr size) {
+  // merge with the following range
+  const auto next {m_free_by_offset.find(offset + size)};
+  if (next != m_free_by_offset.end()) {
+    size += next->second;
+    eraseFree(next);
+  }
+  // and with the previous one
+  auto previous {m_free_by_offset.lower_bound(offset)};
+  if (previous != m_free_by_offset.begin()) {
+    --previous;
+    if (previous->first + previous->second == offset) {
+      offset = previous->first;
+      size += previous->second;
+      eraseFree(previous);
+    }
+  }
+  m_free_by_offset.emplace(offset, size);
+  m_free_by_size.emplace(size, offset);
+}
+
+ktp::VertexArena::Handle ktp::VertexArena::allocate(GLsizeiptr size) {
+  size = roundUp(std::max(size, GLsizeiptr{1}), m_granularity);
+  auto offset {takeFree(size)};
+  if (offset < 0) {
+    if (m_capacity - m_used >= size) {
+      // there's room, just not in one piece
+      defragment();
+    } else {
+      replaceBuffer(std::max(m_capacity * 2, m_capacity + size), false);
+    }
+    offset = takeFree(size);
+  }
+  Handle handle {};
+  if (m_free_handles.empty()) {
+    handle = static_cast<Handle>(m_ranges.size());
+    m_ranges.emplace_back();
+  } else {
+    handle = m_free_handles.back();
+    m_free_handles.pop_back();
+  }
+  m_ranges[handle] = {offset, size, true};
+  m_used += size;
+  return handle;
+}
+
+void ktp::VertexArena::defragment() {
+  // already packed
+  if (m_free_by_offset.size() == 1 && m_free_by_offset.begin()->first == m_used) return;
+  replaceBuffer(m_capacity, true);
+}
+
+void ktp::VertexArena::eraseFree(std::map<GLsizeiptr, GLsizeiptr>::iterator free) {
+  auto [first, last] {m_free_by_size.equal_range(free->second)};
+  for (; first != last; ++first) {
+    if (first->second == free->first) {
+      m_free_by_size.erase(first);
+      break;
+    }
+  }
+  m_free_by_offset.erase(free);
+}
+
+void ktp::VertexArena::free(Handle handle) {
+  auto& range {m_ranges[handle]};
+  addFree(range.offset, range.size);
+  m_used -= range.size;
+  range.used = false;
+  m_free_handles.push_back(handle);
+}
+
+// copies the ranges to a new buffer, packing them if asked, and rebuilds the free list
+void ktp::VertexArena::replaceBuffer(GLsizeiptr capacity, bool pack) {
+  VBO vbo {};
+  vbo.setup(nullptr, capacity, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_COPY_READ_BUFFER, m_vbo.id());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, vbo.id());
+  if (pack) {
+    std::vector<Handle> live {};
+    for (Handle handle = 0; handle < m_ranges.size(); ++handle) {
+      if (m_ranges[handle].used) live.push_back(handle);
+    }
+    std::sort(live.begin(), live.end(), [this](Handle a, Handle b) {
+      return m_ranges[a].offset < m_ranges[b].offset;
+    });
+    GLsizeiptr cursor {};
+    for (const auto handle: live) {
+      auto& range {m_ranges[handle]};
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.offset, cursor, range.size);
+      range.offset = cursor;
+      cursor += range.size;
+    }
+    m_free_by_offset.clear();
+    m_free_by_size.clear();
+    if (capacity > cursor) addFree(cursor, capacity - cursor);
+  } else {
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_capacity);
+    addFree(m_capacity, capacity - m_capacity);
+  }
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  vbo.unbind();
+  m_vbo = std::move(vbo);
+  m_capacity = capacity;
+  ++m_generation;
+}
+
+ktp::VertexArena::Stats ktp::VertexArena::stats() const {
+  Stats stats {};
+  stats.capacity = m_capacity;
+  stats.used = m_used;
+  stats.largest_free = m_free_by_size.empty() ? 0 : m_free_by_size.rbegin()->first;
+  stats.allocations = m_ranges.size() - m_free_handles.size();
+  stats.free_ranges = m_free_by_offset.size();
+  const auto free_space {m_capacity - m_used};
+  if (free_space > 0) {
+    stats.fragmentation = 1.f - static_cast<GLfloat>(stats.largest_free) / static_cast<GLfloat>(free_space);
+  }
+  return stats;
+}
+
+// best fit, the rest of the range goes back to the free list
+GLsizeiptr ktp::VertexArena::takeFree(GLsizeiptr size) {
+  const auto best {m_free_by_size.lower_bound(size)};
+  if (best == m_free_by_size.end()) return -1;
+  const auto free_size {best->first};
+  const auto offset {best->second};
+  m_free_by_size.erase(best);
+  m_free_by_offset.erase(offset);
+  if (free_size > size) addFree(offset + size, free_size - size);
+  return offset;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file vertex_arena.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief One big vertex buffer shared by many meshes.
+ * @version 0.1
+ * @date 2022-11-30
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_VERTEX_ARENA_HPP_)
+#define KETEMINE_SRC_VERTEX_ARENA_HPP_
+
+#include "opengl.hpp"
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace ktp {
+
+/**
+ * @brief A single VBO handing out ranges to many meshes, so they can all be
+ *  drawn with one VAO and a base vertex. Free ranges are kept in a best fit
+ *  free list and merged with their neighbours when released. Meshes are
+ *  referred to by handles because defragment() moves them around.
+ */
+class VertexArena {
+
+ public:
+
+  using Handle = GLuint;
+  static constexpr Handle invalid_handle {0xFFFFFFFFu};
+
+  /**
+   * @brief The state of the arena, in bytes.
+   */
+  struct Stats {
+    GLsizeiptr capacity {};
+    GLsizeiptr used {};
+    GLsizeiptr largest_free {};
+    std::size_t allocations {};
+    std::size_t free_ranges {};
+    // 0 when all the free space is a single range, close to 1 when it's scattered
+    GLfloat fragmentation {};
+  };
+
+  /**
+   * @brief Creates the arena.
+   * @param capacity The initial size in bytes of the buffer.
+   * @param stride The size in bytes of a vertex. Ranges start at multiples of it.
+   */
+  VertexArena(GLsizeiptr capacity, GLsizei stride);
+
+  /**
+   * @brief Reserves a range. If no free range is big enough, the arena is
+   *  defragmented when that would be enough, or grown otherwise.
+   * @param size The size in bytes of the range.
+   * @return The handle of the range.
+   */
+  Handle allocate(GLsizeiptr size);
+
+  /**
+   * @param handle A valid handle.
+   * @return The index of the first vertex of the range, to use as base vertex.
+   */
+  GLint baseVertex(Handle handle) const { return static_cast<GLint>(m_ranges[handle].offset / m_stride); }
+
+  /**
+   * @brief Packs every range at the start of the buffer, leaving a single free range.
+   */
+  void defragment();
+
+  /**
+   * @brief Releases a range.
+   * @param handle A valid handle. It's invalid afterwards.
+   */
+  void free(Handle handle);
+
+  /**
+   * @return A number that changes every time the buffer is replaced, when it
+   *  grows or it's defragmented. The VAOs using it have to be linked again.
+   */
+  auto generation() const { return m_generation; }
+
+  /**
+   * @param handle A valid handle.
+   * @return The offset in bytes of the range.
+   */
+  auto offset(Handle handle) const { return m_ranges[handle].offset; }
+
+  /**
+   * @param handle A valid handle.
+   * @return The size in bytes of the range. It may be bigger than what was asked.
+   */
+  auto size(Handle handle) const { return m_ranges[handle].size; }
+
+  /**
+   * @return The usage and fragmentation of the arena.
+   */
+  Stats stats() const;
+
+  /**
+   * @return The buffer holding every range.
+   */
+  const auto& vbo() const { return m_vbo; }
+
+ private:
+
+  struct Range {
+    GLsizeiptr offset {};
+    GLsizeiptr size {};
+    bool used {false};
+  };
+
+  void addFree(GLsizeiptr offset, GLsizeiptr size);
+  void eraseFree(std::map<GLsizeiptr, GLsizeiptr>::iterator free);
+  void replaceBuffer(GLsizeiptr capacity, bool pack);
+  GLsizeiptr takeFree(GLsizeiptr size);
+
+  VBO m_vbo {};
+  GLsizeiptr m_capacity {};
+  GLsizei m_stride {};
+  // ranges are rounded up to it, so small changes in a mesh don't need a new range
+  GLsizeiptr m_granularity {};
+  GLsizeiptr m_used {};
+  GLuint m_generation {};
+  // indexed by handle
+  std::vector<Range> m_ranges {};
+  std::vector<Handle> m_free_handles {};
+  // free ranges by offset to merge neighbours, and by size for the best fit
+  std::map<GLsizeiptr, GLsizeiptr> m_free_by_offset {};
+  std::multimap<GLsizeiptr, GLsizeiptr> m_free_by_size {};
+};
+
+} // namespace ktp
+
+#endif // KETEMINE_SRC_VERTEX_ARENA_HPP_
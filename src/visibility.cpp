@@ -0,0 +1,117 @@
+#include "visibility.hpp"
+
+#include "mesher.hpp"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+using namespace ktp;
+
+constexpr GLuint no_face {6};
+
+constexpr ChunkPos face_offsets[6] {
+  {-1, 0, 0}, {1, 0, 0},
+  {0, -1, 0}, {0, 1, 0},
+  {0, 0, -1}, {0, 0, 1}
+};
+
+constexpr GLuint opposite(GLuint face) { return face ^ 1u; }
+
+} // namespace
+
+/* Connectivity */
+
+ktp::visibility::Connectivity ktp::visibility::Connectivity::compute(const Chunk& chunk) {
+  if (chunk.isEmpty()) return open();
+  const auto& palette {chunk.palette()};
+  if (std::find(palette.cbegin(), palette.cend(), Blocks::air) == palette.cend()) return {};
+  return floodFill([&chunk](std::size_t index) { return chunk.get(static_cast<GLuint>(index)) == Blocks::air; });
+}
+
+ktp::visibility::Connectivity ktp::visibility::Connectivity::compute(const PaddedChunk& padded) {
+  return floodFill([&padded](std::size_t index) {
+    const auto x {static_cast<GLint>(index & 15u)};
+    const auto z {static_cast<GLint>((index >> 4) & 15u)};
+    const auto y {static_cast<GLint>(index >> 8)};
+    return padded.get(x, y, z) == Blocks::air;
+  });
+}
+
+// every region of air connects all the faces it touches
+template <typename IsAir>
+ktp::visibility::Connectivity ktp::visibility::Connectivity::floodFill(IsAir&& is_air) {
+  std::array<bool, Chunk::volume> visited {};
+  std::array<std::uint16_t, Chunk::volume> stack {};
+  std::uint64_t bits {};
+  for (std::size_t seed = 0; seed < Chunk::volume; ++seed) {
+    if (visited[seed] || !is_air(seed)) continue;
+    GLuint faces {};
+    std::size_t top {};
+    stack[top++] = static_cast<std::uint16_t>(seed);
+    visited[seed] = true;
+    while (top > 0) {
+      const std::size_t index {stack[--top]};
+      // same layout as Chunk::index()
+      const GLint coords[3] {
+        static_cast<GLint>(index & 15u),
+        static_cast<GLint>(index >> 8),
+        static_cast<GLint>((index >> 4) & 15u)
+      };
+      for (GLuint face = 0; face < 6; ++face) {
+        const auto axis {face / 2u};
+        const auto step {face & 1u ? 1 : -1};
+        const auto coord {coords[axis] + step};
+        if (coord < 0 || coord >= Chunk::size) {
+          faces |= 1u << face;
+          continue;
+        }
+        constexpr std::size_t strides[3] {1u, 256u, 16u};
+        const auto neighbour {step > 0 ? index + strides[axis] : index - strides[axis]};
+        if (visited[neighbour] || !is_air(neighbour)) continue;
+        visited[neighbour] = true;
+        stack[top++] = static_cast<std::uint16_t>(neighbour);
+      }
+    }
+    for (GLuint a = 0; a < 6; ++a) {
+      if (!(faces & (1u << a))) continue;
+      for (GLuint b = 0; b < 6; ++b) {
+        if (faces & (1u << b)) bits |= std::uint64_t{1} << (a * 6u + b);
+      }
+    }
+    // nothing else to learn
+    if (bits == all_bits) break;
+  }
+  return Connectivity{bits};
+}
+
+GLuint ktp::visibility::Connectivity::pairs() const {
+  // the matrix is symmetric, count the pairs above the diagonal
+  GLuint count {};
+  for (GLuint a = 0; a < 6; ++a) {
+    for (GLuint b = a + 1; b < 6; ++b) count += connected(a, b);
+  }
+  return count;
+}
+
+/* Graph */
+
+void ktp::visibility::Graph::search(const ChunkPos& start, std::unordered_set<ChunkPos, ChunkPosHash>& reachable) const {
+  reachable.clear();
+  m_queue.clear();
+  m_queue.push_back({start, no_face, 0u});
+  reachable.insert(start);
+  for (std::size_t head = 0; head < m_queue.size(); ++head) {
+    const auto node {m_queue[head]};
+    const auto connectivity {m_chunks.find(node.pos)};
+    if (connectivity == m_chunks.cend()) continue;
+    for (GLuint face = 0; face < 6; ++face) {
+      // never turn back
+      if (node.directions & (1u << opposite(face))) continue;
+      if (node.entry != no_face && !connectivity->second.connected(node.entry, face)) continue;
+      const ChunkPos next {node.pos + face_offsets[face]};
+      if (!m_chunks.count(next) || !reachable.insert(next).second) continue;
+      m_queue.push_back({next, opposite(face), node.directions | (1u << face)});
+    }
+  }
+}
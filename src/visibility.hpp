@@ -0,0 +1,136 @@
+/**
+ * @file visibility.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief Cave culling: which chunks can be seen from the camera chunk going through air.
+ * @version 0.1
+ * @date 2022-12-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_VISIBILITY_HPP_)
+#define KETEMINE_SRC_VISIBILITY_HPP_
+
+#include "chunk.hpp"
+#include "types.hpp"
+#include "world.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ktp {
+
+struct PaddedChunk;
+
+namespace visibility {
+
+/**
+ * @brief Which faces of a chunk are connected through air inside the chunk.
+ *  Faces are numbered like mesher::Face, axis * 2 + positive direction.
+ */
+class Connectivity {
+
+ public:
+
+  /**
+   * @return Every face connected with every other, i.e. an empty chunk.
+   */
+  static constexpr Connectivity open() { return Connectivity{all_bits}; }
+
+  /**
+   * @brief Flood fills the air of a chunk.
+   * @param chunk The chunk.
+   * @return The connectivity of its faces.
+   */
+  static Connectivity compute(const Chunk& chunk);
+
+  /**
+   * @brief Flood fills the air of the centre of a padded copy, the neighbours
+   *  are ignored.
+   * @param padded The padded copy.
+   * @return The connectivity of its faces.
+   */
+  static Connectivity compute(const PaddedChunk& padded);
+
+  Connectivity() = default;
+
+  /**
+   * @return True if air connects both faces.
+   */
+  constexpr bool connected(GLuint a, GLuint b) const { return (m_bits >> (a * 6u + b)) & 1u; }
+
+  /**
+   * @return The number of connected face pairs, 0 to 15.
+   */
+  GLuint pairs() const;
+
+ private:
+
+  static constexpr std::uint64_t all_bits {(std::uint64_t{1} << 36) - 1};
+
+  constexpr explicit Connectivity(std::uint64_t bits): m_bits(bits) {}
+
+  template <typename IsAir>
+  static Connectivity floodFill(IsAir&& is_air);
+
+  // a symmetric 6x6 bit matrix, bit a * 6 + b
+  std::uint64_t m_bits {};
+};
+
+/**
+ * @brief The connectivity of every loaded chunk, kept by the main thread.
+ */
+class Graph {
+
+ public:
+
+  /**
+   * @brief Forgets a chunk.
+   */
+  void erase(const ChunkPos& pos) { m_chunks.erase(pos); }
+
+  /**
+   * @return True if the chunk is in the graph.
+   */
+  bool contains(const ChunkPos& pos) const { return m_chunks.find(pos) != m_chunks.cend(); }
+
+  /**
+   * @brief Finds the chunks that can be seen from the camera chunk, with a
+   *  breadth first search that only crosses a chunk between faces connected
+   *  through air and never goes back in a direction it already went, as in
+   *  "Advanced Cave Culling Algorithm" (Tommaso Checchi).
+   * @param start The chunk of the camera. It must be in the graph.
+   * @param reachable Gets the chunks that may be visible.
+   */
+  void search(const ChunkPos& start, std::unordered_set<ChunkPos, ChunkPosHash>& reachable) const;
+
+  /**
+   * @brief Adds or updates a chunk.
+   */
+  void set(const ChunkPos& pos, Connectivity connectivity) { m_chunks[pos] = connectivity; }
+
+  /**
+   * @return The number of chunks in the graph.
+   */
+  auto size() const { return m_chunks.size(); }
+
+ private:
+
+  struct Node {
+    ChunkPos pos;
+    // the face it was entered through, 6 for the start
+    GLuint entry;
+    // a bit per face the search went out through to get here
+    GLuint directions;
+  };
+
+  std::unordered_map<ChunkPos, Connectivity, ChunkPosHash> m_chunks {};
+  // reused between searches
+  mutable std::vector<Node> m_queue {};
+};
+
+} } // namespace visibility/ktp
+
+#endif // KETEMINE_SRC_VISIBILITY_HPP_
@@ -0,0 +1,10 @@
+#include "world.hpp"
+
+std::size_t ktp::World::memoryUsage() const {
+  std::size_t bytes {sizeof(World) + m_chunks.bucket_count() * sizeof(void*)};
+  for (const auto& [pos, chunk]: m_chunks) {
+    bytes += sizeof(pos) + chunk.memoryUsage();
+  }
+  bytes += m_lights.bucket_count() * sizeof(void*) + m_lights.size() * (sizeof(ChunkPos) + sizeof(ChunkLight));
+  return bytes;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file world.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief The voxel world, a sparse collection of chunks.
+ * @version 0.1
+ * @date 2022-11-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_SRC_WORLD_HPP_)
+#define KETEMINE_SRC_WORLD_HPP_
+
+#include "chunk.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+namespace ktp {
+
+/**
+ * @brief Hash functor for chunk positions.
+ */
+struct ChunkPosHash {
+  std::size_t operator()(const ChunkPos& pos) const {
+    // large primes, as in "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+    return (static_cast<std::size_t>(pos.x) * 73856093u)
+         ^ (static_cast<std::size_t>(pos.y) * 19349663u)
+         ^ (static_cast<std::size_t>(pos.z) * 83492791u);
+  }
+};
+
+/**
+ * @brief The world, made of 16x16x16 chunks addressed by chunk position.
+ *  Block coordinates are world coordinates, chunk positions are block
+ *  coordinates divided by Chunk::size.
+ */
+class World {
+
+ public:
+
+  using ChunkMap = std::unordered_map<ChunkPos, Chunk, ChunkPosHash>;
+  using LightMap = std::unordered_map<ChunkPos, ChunkLight, ChunkPosHash>;
+
+  /**
+   * @brief Converts world block coordinates to the position of the chunk holding them.
+   */
+  static constexpr ChunkPos chunkPosition(GLint x, GLint y, GLint z) {
+    // arithmetic shift rounds towards negative infinity
+    return {x >> 4, y >> 4, z >> 4};
+  }
+
+  /**
+   * @brief Converts a world block coordinate to a coordinate local to its chunk.
+   */
+  static constexpr GLint localCoord(GLint coord) { return coord & (Chunk::size - 1); }
+
+  /**
+   * @return The chunk at the given position or nullptr if it's not loaded.
+   */
+  Chunk* chunk(const ChunkPos& pos) {
+    const auto found {m_chunks.find(pos)};
+    return found != m_chunks.end() ? &found->second : nullptr;
+  }
+
+  /**
+   * @return The chunk at the given position or nullptr if it's not loaded.
+   */
+  const Chunk* chunk(const ChunkPos& pos) const {
+    const auto found {m_chunks.find(pos)};
+    return found != m_chunks.cend() ? &found->second : nullptr;
+  }
+
+  /**
+   * @return The number of chunks loaded.
+   */
+  auto chunkCount() const { return m_chunks.size(); }
+
+  /**
+   * @return All the chunks loaded.
+   */
+  const auto& chunks() const { return m_chunks; }
+
+  /**
+   * @brief Gets the chunk at the given position, creating an empty one if needed.
+   * @param pos The chunk position.
+   * @return A reference to the chunk.
+   */
+  Chunk& createChunk(const ChunkPos& pos) { return m_chunks[pos]; }
+
+  /**
+   * @brief Gets a block using world coordinates.
+   * @return The block id, or air if the chunk is not loaded.
+   */
+  BlockID getBlock(GLint x, GLint y, GLint z) const {
+    const auto section {chunk(chunkPosition(x, y, z))};
+    if (!section) return Blocks::air;
+    return section->get(localCoord(x), localCoord(y), localCoord(z));
+  }
+
+  /**
+   * @brief Stores a chunk in the world, replacing the old one if any.
+   * @param pos The chunk position.
+   * @param chunk The chunk to store.
+   */
+  void insertChunk(const ChunkPos& pos, Chunk&& chunk) { m_chunks.insert_or_assign(pos, std::move(chunk)); }
+
+  /**
+   * @brief Stores the light of a chunk, replacing the old one if any.
+   * @param pos The chunk position.
+   * @param light The light of the chunk.
+   */
+  void insertLight(const ChunkPos& pos, const ChunkLight& light) { m_lights.insert_or_assign(pos, light); }
+
+  /**
+   * @return The light of the chunk at the given position or nullptr if it's not lit.
+   */
+  ChunkLight* light(const ChunkPos& pos) {
+    const auto found {m_lights.find(pos)};
+    return found != m_lights.end() ? &found->second : nullptr;
+  }
+
+  /**
+   * @return The light of the chunk at the given position or nullptr if it's not lit.
+   */
+  const ChunkLight* light(const ChunkPos& pos) const {
+    const auto found {m_lights.find(pos)};
+    return found != m_lights.cend() ? &found->second : nullptr;
+  }
+
+  /**
+   * @brief Gets a light level using world coordinates.
+   * @return The light level, or 0 if the chunk is not lit.
+   */
+  std::uint8_t getLight(LightChannel channel, GLint x, GLint y, GLint z) const {
+    const auto section {light(chunkPosition(x, y, z))};
+    if (!section) return 0;
+    return section->get(channel, Chunk::index(localCoord(x), localCoord(y), localCoord(z)));
+  }
+
+  /**
+   * @return The approximate memory used by all the chunks and their light in bytes.
+   */
+  std::size_t memoryUsage() const;
+
+  /**
+   * @brief Unloads a chunk and its light.
+   * @param pos The chunk position.
+   */
+  void removeChunk(const ChunkPos& pos) {
+    m_chunks.erase(pos);
+    m_lights.erase(pos);
+  }
+
+  /**
+   * @brief Sets a block using world coordinates, creating the chunk if needed.
+   */
+  void setBlock(GLint x, GLint y, GLint z, BlockID block) {
+    createChunk(chunkPosition(x, y, z)).set(localCoord(x), localCoord(y), localCoord(z), block);
+  }
+
+ private:
+
+  ChunkMap m_chunks {};
+  LightMap m_lights {};
+};
+
+} // namespace ktp
+
+#endif // KETEMINE_SRC_WORLD_HPP_
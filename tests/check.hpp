@@ -0,0 +1,59 @@
+/**
+ * @file check.hpp
+ * @author Alejandro Castillo Blanco (alexcastilloblanco@gmail.com)
+ * @brief The checks of the tests and benchmarks, run by CTest.
+ * @version 0.1
+ * @date 2022-12-01
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#if !defined(KETEMINE_TESTS_CHECK_HPP_)
+#define KETEMINE_TESTS_CHECK_HPP_
+
+#include <cstdlib>
+#include <iostream>
+
+namespace ktp { namespace test {
+
+// checks failed so far
+inline int failures {0};
+
+/**
+ * @return The exit code of the test, what CTest looks at.
+ */
+inline int result() {
+  if (failures) std::cerr << failures << " checks failed\n";
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @brief Compares floating point results without -Wfloat-equal. A tolerance
+ *  of 0 asks for the same value.
+ * @param a A value.
+ * @param b Another value.
+ * @param tolerance How far apart they can be.
+ * @return True if they are at most that far apart.
+ */
+template <typename T>
+constexpr bool near(T a, T b, T tolerance = T{1} / T{10000}) {
+  return a - b <= tolerance && b - a <= tolerance;
+}
+
+// returned by the benchmarks that need something the machine doesn't have,
+// CTest reports them as skipped
+constexpr int skipped {77};
+
+} } // namespace test/ktp
+
+// reports the failure and goes on, so a run shows every broken check
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+      ++ktp::test::failures; \
+    } \
+  } while (false)
+
+#endif // KETEMINE_TESTS_CHECK_HPP_
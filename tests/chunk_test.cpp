@@ -0,0 +1,125 @@
+#include "check.hpp"
+#include "chunk.hpp"
+#include "world.hpp"
+#include <array>
+#include <random>
+
+namespace {
+
+using namespace ktp;
+
+// the bit width needed by a palette of that many blocks
+GLuint widthFor(std::size_t palette_size) {
+  if (palette_size <= 1) return 0;
+  if (palette_size <= 2) return 1;
+  if (palette_size <= 4) return 2;
+  if (palette_size <= 16) return 4;
+  if (palette_size <= 256) return 8;
+  return 16;
+}
+
+// the chunk holds the same as a flat copy of it
+bool matches(const Chunk& chunk, const std::array<BlockID, Chunk::volume>& flat) {
+  for (GLuint i = 0; i < Chunk::volume; ++i) {
+    if (chunk.get(i) != flat[i]) return false;
+  }
+  return true;
+}
+
+// adds one new block at a time, the width grows 0, 1, 2, 4, 8, 16 and every
+// block written so far is still there after each repack
+void growth() {
+  Chunk chunk {};
+  std::array<BlockID, Chunk::volume> flat {};
+  CHECK(chunk.bitsPerBlock() == 0);
+  std::mt19937 rng {2};
+  for (BlockID block = 1; block < 600; ++block) {
+    const auto index {static_cast<GLuint>(rng() % Chunk::volume)};
+    // the block it replaces may still be elsewhere, so the palette only grows
+    chunk.set(index, block);
+    flat[index] = block;
+    CHECK(chunk.bitsPerBlock() == widthFor(chunk.palette().size()));
+    if (block == 1 || block == 2 || block == 4 || block == 16 || block == 256 || block == 599) CHECK(matches(chunk, flat));
+  }
+  CHECK(chunk.bitsPerBlock() == 16);
+}
+
+// at every width, random writes read back
+void roundTrips() {
+  for (const std::size_t kinds: {1u, 2u, 3u, 4u, 9u, 16u, 100u, 256u, 1000u}) {
+    Chunk chunk {};
+    std::array<BlockID, Chunk::volume> flat {};
+    std::mt19937 rng {static_cast<unsigned>(kinds)};
+    for (int pass = 0; pass < 3; ++pass) {
+      for (GLuint i = 0; i < Chunk::volume; ++i) {
+        const auto block {static_cast<BlockID>(rng() % kinds)};
+        chunk.set(i, block);
+        flat[i] = block;
+      }
+    }
+    CHECK(matches(chunk, flat));
+    CHECK(chunk.bitsPerBlock() == widthFor(chunk.palette().size()));
+    // by coordinates too
+    for (GLint y = 0; y < Chunk::size; y += 5) {
+      for (GLint z = 0; z < Chunk::size; z += 3) {
+        for (GLint x = 0; x < Chunk::size; ++x) CHECK(chunk.get(x, y, z) == flat[Chunk::index(x, y, z)]);
+      }
+    }
+  }
+}
+
+void optimize() {
+  // 300 different blocks, then only 2 left
+  Chunk chunk {};
+  std::array<BlockID, Chunk::volume> flat {};
+  for (GLuint i = 0; i < Chunk::volume; ++i) chunk.set(i, static_cast<BlockID>(i % 300));
+  CHECK(chunk.bitsPerBlock() == 16);
+  for (GLuint i = 0; i < Chunk::volume; ++i) {
+    flat[i] = i % 2 ? Blocks::stone : Blocks::dirt;
+    chunk.set(i, flat[i]);
+  }
+  const auto before {chunk.memoryUsage()};
+  chunk.optimize();
+  CHECK(chunk.palette().size() == 2);
+  CHECK(chunk.bitsPerBlock() == 1);
+  CHECK(chunk.memoryUsage() < before);
+  CHECK(matches(chunk, flat));
+
+  // a single block left goes back to 0 bits
+  for (GLuint i = 0; i < Chunk::volume; ++i) chunk.set(i, Blocks::sand);
+  chunk.optimize();
+  CHECK(chunk.bitsPerBlock() == 0);
+  CHECK(chunk.palette().size() == 1);
+  CHECK(chunk.get(1234u) == Blocks::sand);
+  CHECK(!chunk.isEmpty());
+  chunk.fill(Blocks::air);
+  CHECK(chunk.isEmpty());
+}
+
+void world() {
+  World world {};
+  // negative coordinates land in the right chunks
+  world.setBlock(-1, -1, -1, Blocks::stone);
+  world.setBlock(0, 0, 0, Blocks::dirt);
+  world.setBlock(-17, 33, 16, Blocks::sand);
+  CHECK(world.getBlock(-1, -1, -1) == Blocks::stone);
+  CHECK(world.getBlock(0, 0, 0) == Blocks::dirt);
+  CHECK(world.getBlock(-17, 33, 16) == Blocks::sand);
+  CHECK(world.getBlock(-2, -1, -1) == Blocks::air);
+  CHECK(world.chunkCount() == 3);
+  CHECK(World::chunkPosition(-1, -16, 15) == ChunkPos(-1, -1, 0));
+  CHECK(World::chunkPosition(-17, 16, 0) == ChunkPos(-2, 1, 0));
+  CHECK(World::localCoord(-1) == 15 && World::localCoord(16) == 0);
+  // not loaded is air
+  CHECK(world.getBlock(1000, 0, 0) == Blocks::air);
+}
+
+} // namespace
+
+int main() {
+  growth();
+  roundTrips();
+  optimize();
+  world();
+  return test::result();
+}
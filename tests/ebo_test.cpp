@@ -0,0 +1,87 @@
+#include "check.hpp"
+#include "opengl.hpp"
+#include <bit>
+#include <cstdint>
+
+namespace {
+
+using namespace ktp;
+
+// the same bits, but -0.f and 0.f are the same, as for EBO::generateEBO
+bool same(GLfloat a, GLfloat b) {
+  return std::bit_cast<std::uint32_t>(a + 0.f) == std::bit_cast<std::uint32_t>(b + 0.f);
+}
+
+// every index must point to a vertex equal to the one it replaces
+bool sameMesh(const FloatArray& original, const FloatArray& vertices, const UintArray& indices, std::size_t stride) {
+  if (indices.size() * stride != original.size()) return false;
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    for (std::size_t f = 0; f < stride; ++f) {
+      if (!same(original[i * stride + f], vertices[indices[i] * stride + f])) return false;
+    }
+  }
+  return true;
+}
+
+void quad() {
+  // two triangles sharing an edge
+  const FloatArray original {
+    0.f, 0.f, 0.f,  1.f, 0.f, 0.f,  1.f, 1.f, 0.f,
+    0.f, 0.f, 0.f,  1.f, 1.f, 0.f,  0.f, 1.f, 0.f
+  };
+  auto vertices {original};
+  UintArray indices {};
+  EBO::generateEBO(vertices, indices);
+  CHECK(vertices.size() == 4 * 3);
+  CHECK((indices == UintArray{0, 1, 2, 0, 2, 3}));
+  CHECK(sameMesh(original, vertices, indices, 3));
+}
+
+void stride() {
+  // same position, different texture coordinates, they stay apart
+  const FloatArray original {
+    0.f, 0.f, 0.f, 0.f, 0.f,
+    0.f, 0.f, 0.f, 1.f, 0.f,
+    0.f, 0.f, 0.f, 0.f, 0.f
+  };
+  auto vertices {original};
+  UintArray indices {};
+  EBO::generateEBO(vertices, indices, 5);
+  CHECK(vertices.size() == 2 * 5);
+  CHECK((indices == UintArray{0, 1, 0}));
+  CHECK(sameMesh(original, vertices, indices, 5));
+}
+
+void empty() {
+  FloatArray vertices {};
+  UintArray indices {7};
+  EBO::generateEBO(vertices, indices);
+  CHECK(vertices.empty());
+  CHECK(indices.empty());
+}
+
+void shortIndices() {
+  // 2^16 different vertices fit, one more doesn't
+  FloatArray vertices {};
+  for (GLuint i = 0; i < 65536; ++i) vertices.insert(vertices.end(), {static_cast<GLfloat>(i), 0.f, 0.f});
+  const auto original {vertices};
+  UshortArray indices {};
+  CHECK(EBO::generateEBO(vertices, indices));
+  CHECK(indices.size() == 65536 && indices.back() == 65535);
+  auto too_many {original};
+  too_many.insert(too_many.end(), {-1.f, 0.f, 0.f});
+  UshortArray unused {};
+  CHECK(!EBO::generateEBO(too_many, unused));
+  // left as they were
+  CHECK(too_many.size() == original.size() + 3);
+}
+
+} // namespace
+
+int main() {
+  quad();
+  stride();
+  empty();
+  shortIndices();
+  return test::result();
+}
@@ -0,0 +1,181 @@
+#include "check.hpp"
+#include "ecs.hpp"
+#include "jobs.hpp"
+#include <atomic>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+
+struct Health { int points; };
+struct Motion { double speed; int axis; };
+struct Tag { char letter; };
+
+// what an entity should have, kept aside from the registry
+struct Expected {
+  ecs::Entity entity {};
+  bool health {false};
+  bool motion {false};
+  bool tag {false};
+  int points {};
+  double speed {};
+  char letter {};
+};
+
+// the registry holds exactly what's expected of every entity
+void matches(ecs::Registry& registry, const std::unordered_map<std::uint32_t, Expected>& expected) {
+  CHECK(registry.size() == expected.size());
+  for (const auto& [index, e]: expected) {
+    CHECK(registry.alive(e.entity));
+    CHECK(registry.has<Health>(e.entity) == e.health);
+    CHECK(registry.has<Motion>(e.entity) == e.motion);
+    CHECK(registry.has<Tag>(e.entity) == e.tag);
+    if (e.health) CHECK(registry.get<Health>(e.entity)->points == e.points);
+    if (e.motion) CHECK(test::near(registry.get<Motion>(e.entity)->speed, e.speed, 0.0));
+    if (e.tag) CHECK(registry.get<Tag>(e.entity)->letter == e.letter);
+  }
+}
+
+// the last row of an archetype moved into the hole keeps its components,
+// for every way an entity leaves an archetype
+void rowSwaps() {
+  ecs::Registry registry {};
+  std::vector<ecs::Entity> entities {};
+  for (int i = 0; i < 5; ++i) entities.push_back(registry.create(Health{i}, Motion{i * 0.5, i}));
+  // destroy the first, the last one takes its row
+  registry.destroy(entities[0]);
+  CHECK(!registry.alive(entities[0]));
+  CHECK(registry.get<Health>(entities[0]) == nullptr);
+  // remove a component of the second, it moves to another archetype
+  registry.remove<Motion>(entities[1]);
+  // add one to the third, it moves to a third archetype
+  registry.add(entities[2], Tag{'c'});
+  for (int i = 1; i < 5; ++i) {
+    const auto& entity {entities[static_cast<std::size_t>(i)]};
+    CHECK(registry.get<Health>(entity)->points == i);
+    CHECK(registry.has<Motion>(entity) == (i != 1));
+    if (i != 1) CHECK(test::near(registry.get<Motion>(entity)->speed, i * 0.5, 0.0) && registry.get<Motion>(entity)->axis == i);
+    CHECK(registry.has<Tag>(entity) == (i == 2));
+  }
+  CHECK(registry.get<Tag>(entities[2])->letter == 'c');
+  // replacing a component doesn't move the entity
+  registry.add(entities[3], Health{30});
+  CHECK(registry.get<Health>(entities[3])->points == 30);
+  CHECK(registry.get<Health>(entities[4])->points == 4);
+  // the index is reused by another generation
+  const auto reused {registry.create(Tag{'r'})};
+  CHECK(reused.index == entities[0].index && !(reused == entities[0]));
+  CHECK(!registry.alive(entities[0]) && registry.alive(reused));
+  CHECK(registry.size() == 5);
+}
+
+// random creations, destructions, additions and removals against a copy of
+// what every entity should have
+void randomChanges() {
+  ecs::Registry registry {};
+  std::mt19937 rng {1};
+  std::unordered_map<std::uint32_t, Expected> expected {};
+  std::vector<ecs::Entity> dead {};
+  for (int i = 0; i < 50000; ++i) {
+    const auto op {rng() % 7};
+    if (op < 2 || expected.empty()) {
+      Expected e {};
+      switch (rng() % 4) {
+        case 0:
+          e.health = true;
+          e.points = static_cast<int>(rng() % 1000);
+          e.entity = registry.create(Health{e.points});
+          break;
+        case 1:
+          e.health = e.motion = true;
+          e.points = static_cast<int>(rng() % 1000);
+          e.speed = static_cast<double>(rng()) * 0.5;
+          e.entity = registry.create(Health{e.points}, Motion{e.speed, 1});
+          break;
+        case 2:
+          e.tag = true;
+          e.letter = static_cast<char>('a' + rng() % 26);
+          e.entity = registry.create(Tag{e.letter});
+          break;
+        default:
+          e.entity = registry.create();
+      }
+      CHECK(!expected.contains(e.entity.index));
+      expected[e.entity.index] = e;
+      continue;
+    }
+    auto it {expected.begin()};
+    std::advance(it, rng() % expected.size());
+    auto& e {it->second};
+    switch (op) {
+      case 2:
+        registry.destroy(e.entity);
+        dead.push_back(e.entity);
+        expected.erase(it);
+        break;
+      case 3:
+        e.motion = true;
+        e.speed = static_cast<double>(rng()) * 0.25;
+        registry.add(e.entity, Motion{e.speed, 2});
+        break;
+      case 4:
+        e.health = false;
+        registry.remove<Health>(e.entity);
+        break;
+      case 5:
+        e.tag = true;
+        e.letter = static_cast<char>('a' + rng() % 26);
+        registry.add(e.entity, Tag{e.letter});
+        break;
+      default:
+        e.motion = false;
+        registry.remove<Motion>(e.entity);
+    }
+    if (i % 5000 == 0) matches(registry, expected);
+  }
+  matches(registry, expected);
+  for (const auto& entity: dead) CHECK(!registry.alive(entity));
+
+  // the iterations see every entity with the components once
+  std::size_t health {}, both {};
+  for (const auto& [index, e]: expected) {
+    health += e.health;
+    both += e.health && e.motion;
+  }
+  std::size_t seen {};
+  registry.forEach<Health>([&seen](Health&) { ++seen; });
+  CHECK(seen == health);
+  seen = 0;
+  registry.forEachArchetype<Health, Motion>([&registry, &seen](std::size_t count, const ecs::Entity* entities, Health*, Motion*) {
+    for (std::size_t i = 0; i < count; ++i) CHECK(registry.has<Motion>(entities[i]));
+    seen += count;
+  });
+  CHECK(seen == both);
+  std::atomic<std::size_t> parallel_seen {};
+  registry.parallelForEach<Health>(7, [&parallel_seen](Health& h) {
+    ++parallel_seen;
+    ++h.points;
+  });
+  CHECK(parallel_seen == health);
+  for (auto& [index, e]: expected) {
+    if (e.health) ++e.points;
+  }
+  matches(registry, expected);
+
+  registry.clear();
+  CHECK(registry.size() == 0);
+  for (const auto& [index, e]: expected) CHECK(!registry.alive(e.entity));
+}
+
+} // namespace
+
+int main() {
+  jobs::init(3);
+  rowSwaps();
+  randomChanges();
+  jobs::shutdown();
+  return test::result();
+}
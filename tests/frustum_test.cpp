@@ -0,0 +1,109 @@
+#include "check.hpp"
+#include "frustum.hpp"
+#include "renderer.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+
+// looking down -z from the origin, 90 degrees, from 0.1 to 100
+glm::mat4 forward() {
+  return glm::perspective(glm::radians(90.f), 1.f, 0.1f, 100.f);
+}
+
+// the chunks of a 16x8x16 grid around the origin, index in base_instance
+std::vector<renderer::CullCandidate> chunkGrid() {
+  std::vector<renderer::CullCandidate> candidates {};
+  for (GLint x = -8; x < 8; ++x) {
+    for (GLint y = -4; y < 4; ++y) {
+      for (GLint z = -8; z < 8; ++z) {
+        const glm::vec4 min {static_cast<GLfloat>(x * 16), static_cast<GLfloat>(y * 16), static_cast<GLfloat>(z * 16), 0.f};
+        const auto index {static_cast<GLuint>(candidates.size())};
+        candidates.push_back({min, min + glm::vec4{16.f, 16.f, 16.f, 0.f}, glm::uvec4{index * 6u + 6u, index * 4u, index, 0u}});
+      }
+    }
+  }
+  return candidates;
+}
+
+// boxes whose answer is known
+void knownBoxes() {
+  const Frustum frustum {forward()};
+  std::vector<renderer::CullCandidate> candidates {
+    // in front of the camera
+    {glm::vec4{-1.f, -1.f, -11.f, 0.f}, glm::vec4{1.f, 1.f, -9.f, 0.f}, glm::uvec4{36u, 0u, 0u, 0u}},
+    // behind it
+    {glm::vec4{-1.f, -1.f, 5.f, 0.f}, glm::vec4{1.f, 1.f, 7.f, 0.f}, glm::uvec4{36u, 24u, 1u, 0u}},
+    // beyond the far plane
+    {glm::vec4{-1.f, -1.f, -210.f, 0.f}, glm::vec4{1.f, 1.f, -200.f, 0.f}, glm::uvec4{36u, 48u, 2u, 0u}},
+    // out to the left, the side planes are at 45 degrees
+    {glm::vec4{-100.f, -1.f, -11.f, 0.f}, glm::vec4{-90.f, 1.f, -9.f, 0.f}, glm::uvec4{36u, 72u, 3u, 0u}},
+    // around the camera, crossing the near plane
+    {glm::vec4{-1.f, -1.f, -1.f, 0.f}, glm::vec4{1.f, 1.f, 1.f, 0.f}, glm::uvec4{36u, 96u, 4u, 0u}},
+    // touching the right plane from inside
+    {glm::vec4{9.f, -1.f, -10.f, 0.f}, glm::vec4{12.f, 1.f, -9.f, 0.f}, glm::uvec4{36u, 120u, 5u, 0u}},
+    // above, out of the top plane
+    {glm::vec4{-1.f, 30.f, -11.f, 0.f}, glm::vec4{1.f, 40.f, -9.f, 0.f}, glm::uvec4{36u, 144u, 6u, 0u}}
+  };
+  const std::vector<GLuint> expected {0u, 4u, 5u};
+
+  std::vector<renderer::DrawElementsIndirectCommand> commands {};
+  renderer::cullChunks(frustum, candidates, commands);
+  CHECK(commands.size() == expected.size());
+  for (std::size_t i = 0; i < commands.size() && i < expected.size(); ++i) {
+    const auto& candidate {candidates[expected[i]]};
+    CHECK(commands[i].base_instance == expected[i]);
+    CHECK(commands[i].count == candidate.draw.x);
+    CHECK(commands[i].instance_count == 1u);
+    CHECK(commands[i].first_index == 0u);
+    CHECK(commands[i].base_vertex == static_cast<GLint>(candidate.draw.y));
+  }
+}
+
+// cullChunks() keeps the same chunks as every Frustum test, from many views
+void sameAsFrustum() {
+  const auto candidates {chunkGrid()};
+  AabbArray boxes {};
+  for (const auto& candidate: candidates) boxes.push(Point3D{candidate.aabb_min}, Point3D{candidate.aabb_max});
+
+  std::mt19937 rng {14};
+  std::uniform_real_distribution<GLfloat> coord {-100.f, 100.f};
+  std::size_t views_with_chunks {};
+  for (int view = 0; view < 64; ++view) {
+    const Point3D eye {coord(rng), coord(rng) * 0.5f, coord(rng)};
+    Point3D target {coord(rng), coord(rng) * 0.5f, coord(rng)};
+    if (test::near(target.x, eye.x, 1e-3f) && test::near(target.z, eye.z, 1e-3f)) target.x += 1.f;
+    const auto view_projection {glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 150.f) * glm::lookAt(eye, target, Point3D{0.f, 1.f, 0.f})};
+    const Frustum frustum {view_projection};
+
+    std::vector<renderer::DrawElementsIndirectCommand> commands {};
+    renderer::cullChunks(frustum, candidates, commands);
+    std::vector<GLuint> from_commands {};
+    for (const auto& command: commands) from_commands.push_back(command.base_instance);
+
+    std::vector<GLuint> simd {}, scalar {}, one_by_one {};
+    frustum.cull(boxes, simd);
+    frustum.cullScalar(boxes, scalar);
+    for (GLuint i = 0; i < candidates.size(); ++i) {
+      if (frustum.intersects(Point3D{candidates[i].aabb_min}, Point3D{candidates[i].aabb_max})) one_by_one.push_back(i);
+    }
+    CHECK(from_commands == one_by_one);
+    CHECK(from_commands == scalar);
+    CHECK(from_commands == simd);
+    // none sees everything
+    CHECK(from_commands.size() < candidates.size());
+    if (!from_commands.empty()) ++views_with_chunks;
+  }
+  CHECK(views_with_chunks > 32);
+}
+
+} // namespace
+
+int main() {
+  knownBoxes();
+  sameAsFrustum();
+  return test::result();
+}
@@ -0,0 +1,149 @@
+#include "check.hpp"
+#include "jobs.hpp"
+#include "light.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+
+// 3x3x3 chunks, the top layer under the open sky
+constexpr GLint side {3};
+constexpr GLint top {side * Chunk::size - 1};
+
+// gives every chunk fresh light and lights the whole world from scratch
+void fullRelight(World& world) {
+  std::vector<light::Handoff> handoffs {};
+  std::vector<light::Update> updates {};
+  for (const auto& [pos, chunk]: world.chunks()) {
+    world.insertLight(pos, ChunkLight{});
+    updates.clear();
+    light::seed(chunk, pos.y == side - 1, updates);
+    for (const auto& update: updates) handoffs.push_back({pos, update});
+  }
+  light::relight(world, std::move(handoffs));
+}
+
+// a copy of the blocks lit from scratch
+World relitCopy(const World& world) {
+  World copy {};
+  for (const auto& [pos, chunk]: world.chunks()) copy.insertChunk(pos, Chunk{chunk});
+  fullRelight(copy);
+  return copy;
+}
+
+// blocks whose light differs
+std::size_t differences(const World& a, const World& b) {
+  std::size_t count {};
+  for (const auto& [pos, chunk]: a.chunks()) {
+    const auto light_a {a.light(pos)}, light_b {b.light(pos)};
+    if (!light_a || !light_b) return Chunk::volume;
+    for (GLuint i = 0; i < Chunk::volume; ++i) {
+      for (const auto channel: {LightChannel::Sky, LightChannel::Block}) count += light_a->get(channel, i) != light_b->get(channel, i);
+    }
+  }
+  return count;
+}
+
+// a block changes and only the light around it is updated
+void edit(World& world, GLint x, GLint y, GLint z, BlockID block) {
+  world.setBlock(x, y, z, block);
+  std::vector<light::Handoff> handoffs {};
+  light::changed(World::chunkPosition(x, y, z), Chunk::index(World::localCoord(x), World::localCoord(y), World::localCoord(z)), y == top, handoffs);
+  light::relight(world, std::move(handoffs));
+}
+
+World emptyWorld() {
+  World world {};
+  for (GLint y = 0; y < side; ++y) {
+    for (GLint z = 0; z < side; ++z) {
+      for (GLint x = 0; x < side; ++x) world.insertChunk({x, y, z}, Chunk{Blocks::air});
+    }
+  }
+  return world;
+}
+
+// a lamp at the corner of 8 chunks lights and darkens all of them
+void lamp() {
+  auto world {emptyWorld()};
+  // a stone roof over everything, so only the lamp lights it
+  for (GLint z = 0; z <= top; ++z) {
+    for (GLint x = 0; x <= top; ++x) world.setBlock(x, top, z, Blocks::stone);
+  }
+  fullRelight(world);
+  CHECK(world.getLight(LightChannel::Sky, 20, 20, 20) == 0);
+
+  edit(world, 31, 31, 31, Blocks::lamp);
+  CHECK(world.getLight(LightChannel::Block, 31, 31, 31) == light::max_level);
+  CHECK(world.getLight(LightChannel::Block, 32, 31, 31) == light::max_level - 1);
+  CHECK(world.getLight(LightChannel::Block, 32, 32, 32) == light::max_level - 3);
+  CHECK(world.getLight(LightChannel::Block, 31 - 14, 31, 31) == 1);
+  CHECK(world.getLight(LightChannel::Block, 31 - 15, 31, 31) == 0);
+  CHECK(differences(world, relitCopy(world)) == 0);
+
+  edit(world, 31, 31, 31, Blocks::air);
+  for (GLint i = 17; i < 46; ++i) CHECK(world.getLight(LightChannel::Block, i, 31, 31) == 0);
+  CHECK(differences(world, relitCopy(world)) == 0);
+
+  // a hole in the roof lets the sky in, straight down at full level
+  edit(world, 24, top, 24, Blocks::air);
+  CHECK(world.getLight(LightChannel::Sky, 24, 0, 24) == light::max_level);
+  CHECK(world.getLight(LightChannel::Sky, 25, 0, 24) == light::max_level - 1);
+  CHECK(differences(world, relitCopy(world)) == 0);
+  // and closing it takes it away
+  edit(world, 24, top, 24, Blocks::stone);
+  CHECK(world.getLight(LightChannel::Sky, 24, 0, 24) == 0);
+  CHECK(differences(world, relitCopy(world)) == 0);
+}
+
+// random edits of a cave-like world, the incremental light is always the
+// same as lighting it all over again
+void randomEdits() {
+  std::mt19937 rng {21};
+  World world {};
+  for (GLint y = 0; y < side; ++y) {
+    for (GLint z = 0; z < side; ++z) {
+      for (GLint x = 0; x < side; ++x) {
+        Chunk chunk {Blocks::air};
+        for (GLuint i = 0; i < Chunk::volume; ++i) {
+          const auto world_y {y * Chunk::size + static_cast<GLint>(i >> 8)};
+          const auto roll {rng() % 100};
+          auto block {Blocks::air};
+          if (world_y < 20) {
+            block = roll < 70 ? Blocks::stone : (roll < 75 ? Blocks::water : Blocks::air);
+          } else if (roll < 3) {
+            block = Blocks::stone;
+          } else if (roll == 3) {
+            block = Blocks::lamp;
+          }
+          chunk.set(i, block);
+        }
+        world.insertChunk({x, y, z}, std::move(chunk));
+      }
+    }
+  }
+  fullRelight(world);
+
+  constexpr BlockID blocks[] {Blocks::lamp, Blocks::stone, Blocks::water, Blocks::air};
+  for (int i = 1; i <= 200; ++i) {
+    const auto x {static_cast<GLint>(rng() % (side * Chunk::size))};
+    const auto y {static_cast<GLint>(rng() % (side * Chunk::size))};
+    const auto z {static_cast<GLint>(rng() % (side * Chunk::size))};
+    edit(world, x, y, z, blocks[rng() % 4]);
+    if (i % 25 == 0) CHECK(differences(world, relitCopy(world)) == 0);
+  }
+}
+
+} // namespace
+
+int main() {
+  // the chunks are lit in parallel, with handoffs between them
+  jobs::init(3);
+  lamp();
+  randomEdits();
+  jobs::shutdown();
+  // and on the main thread alone
+  randomEdits();
+  return test::result();
+}
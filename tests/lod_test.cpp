@@ -0,0 +1,139 @@
+#include "check.hpp"
+#include "mesher.hpp"
+#include "terrain.hpp"
+#include <algorithm>
+
+namespace {
+
+using namespace ktp;
+using enum mesher::Face;
+
+// area in blocks of the quads of a face direction lying on a plane
+GLuint area(const ChunkMesh& mesh, GLuint face, GLuint plane) {
+  GLuint total {};
+  for (std::size_t i = 0; i < mesh.vertices.size(); i += 4) {
+    if (mesh.vertices[i].face() != face) continue;
+    GLuint min[3] {31u, 31u, 31u}, max[3] {};
+    for (std::size_t v = i; v < i + 4; ++v) {
+      const GLuint coords[3] {mesh.vertices[v].x(), mesh.vertices[v].y(), mesh.vertices[v].z()};
+      for (int axis = 0; axis < 3; ++axis) {
+        min[axis] = std::min(min[axis], coords[axis]);
+        max[axis] = std::max(max[axis], coords[axis]);
+      }
+    }
+    const auto axis {face / 2u};
+    if (min[axis] != plane) continue;
+    const auto u {(axis + 1u) % 3u}, v {(axis + 2u) % 3u};
+    total += (max[u] - min[u]) * (max[v] - min[v]);
+  }
+  return total;
+}
+
+bool insideChunk(const ChunkMesh& mesh) {
+  return std::all_of(mesh.vertices.cbegin(), mesh.vertices.cend(), [](const ChunkVertex& vertex) {
+    return vertex.x() <= 16u && vertex.y() <= 16u && vertex.z() <= 16u;
+  });
+}
+
+void downsample() {
+  Chunk chunk {};
+  // a 2x2x2 cell with 5 stone and 3 dirt is stone
+  for (GLint i = 0; i < 5; ++i) chunk.set(i & 1, (i >> 1) & 1, i >> 2, Blocks::stone);
+  for (GLint i = 5; i < 8; ++i) chunk.set(i & 1, (i >> 1) & 1, i >> 2, Blocks::dirt);
+  // a single block of sand fills its cell, so thin terrain has no holes
+  chunk.set(3, 2, 2, Blocks::sand);
+  PaddedChunk padded {};
+  mesher::downsample(chunk, 1, padded);
+  CHECK(padded.get(0, 0, 0) == Blocks::stone);
+  CHECK(padded.get(1, 1, 1) == Blocks::sand);
+  CHECK(padded.get(1, 0, 0) == Blocks::air);
+  // only the low corner is used, the rest and the border are air
+  for (GLint y = -1; y <= Chunk::size; ++y) {
+    for (GLint z = -1; z <= Chunk::size; ++z) {
+      for (GLint x = -1; x <= Chunk::size; ++x) {
+        if (x >= 0 && y >= 0 && z >= 0 && x < 8 && y < 8 && z < 8) continue;
+        CHECK(padded.get(x, y, z) == Blocks::air);
+      }
+    }
+  }
+  // 8x8x8 cells: the single stone block among the dirt loses
+  chunk.fill(Blocks::air);
+  for (GLint x = 0; x < 4; ++x) chunk.set(x, 0, 0, Blocks::dirt);
+  chunk.set(7, 7, 7, Blocks::stone);
+  mesher::downsample(chunk, mesher::max_lod, padded);
+  CHECK(padded.get(0, 0, 0) == Blocks::dirt);
+  CHECK(padded.get(1, 0, 0) == Blocks::air);
+}
+
+// the chunk border gets faces even where the full mesh has none, they hide
+// the cracks next to chunks of another level
+void skirts() {
+  // the lower half of the chunk is ground
+  Chunk chunk {};
+  for (GLint y = 0; y < 8; ++y) {
+    for (GLint z = 0; z < Chunk::size; ++z) {
+      for (GLint x = 0; x < Chunk::size; ++x) chunk.set(x, y, z, Blocks::stone);
+    }
+  }
+  for (GLuint level = 1; level <= mesher::max_lod; ++level) {
+    ChunkMesh mesh {};
+    mesher::lod(chunk, level, mesh);
+    CHECK(insideChunk(mesh));
+    CHECK(area(mesh, PositiveY, 8) == 256);
+    CHECK(area(mesh, NegativeY, 0) == 256);
+    CHECK(area(mesh, NegativeX, 0) == 128);
+    CHECK(area(mesh, PositiveX, 16) == 128);
+    CHECK(area(mesh, NegativeZ, 0) == 128);
+    CHECK(area(mesh, PositiveZ, 16) == 128);
+    // nothing else, a box is all there is
+    CHECK(mesh.quadCount() == 6);
+  }
+
+  // a one block thick layer stays closed at the coarsest level
+  chunk.fill(Blocks::air);
+  for (GLint z = 0; z < Chunk::size; ++z) {
+    for (GLint x = 0; x < Chunk::size; ++x) chunk.set(x, 5, z, Blocks::grass);
+  }
+  ChunkMesh mesh {};
+  mesher::lod(chunk, mesher::max_lod, mesh);
+  CHECK(area(mesh, PositiveY, 8) == 256);
+  CHECK(area(mesh, NegativeY, 0) == 256);
+}
+
+// coarser levels never need more quads, on real terrain
+void generated() {
+  const terrain::Generator generator {1234};
+  std::size_t checked {};
+  for (GLint x = 0; x < 4; ++x) {
+    for (GLint y = 2; y < 5; ++y) {
+      Chunk chunk {};
+      generator.generate({x, y, 0}, chunk);
+      if (chunk.isEmpty()) continue;
+      ++checked;
+      ChunkMesh previous {};
+      mesher::lod(chunk, 1, previous);
+      CHECK(insideChunk(previous));
+      for (GLuint level = 2; level <= mesher::max_lod; ++level) {
+        ChunkMesh mesh {};
+        mesher::lod(chunk, level, mesh);
+        CHECK(insideChunk(mesh));
+        CHECK(mesh.quadCount() > 0);
+        CHECK(mesh.quadCount() <= previous.quadCount());
+        // corners fall on the grid of the level
+        const auto cell {1u << level};
+        for (const auto& vertex: mesh.vertices) CHECK(vertex.x() % cell == 0 && vertex.y() % cell == 0 && vertex.z() % cell == 0);
+        previous = std::move(mesh);
+      }
+    }
+  }
+  CHECK(checked > 0);
+}
+
+} // namespace
+
+int main() {
+  downsample();
+  skirts();
+  generated();
+  return test::result();
+}
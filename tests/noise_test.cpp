@@ -0,0 +1,113 @@
+#include "check.hpp"
+#include "noise.hpp"
+#include <bit>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+
+constexpr noise::Isa isas[] {noise::Isa::Scalar, noise::Isa::SSE2, noise::Isa::AVX2};
+
+// the same bits, the kernels must give exactly the same samples
+std::size_t differences(const std::vector<GLfloat>& a, const std::vector<GLfloat>& b) {
+  std::size_t count {};
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (std::bit_cast<std::uint32_t>(a[i]) != std::bit_cast<std::uint32_t>(b[i])) ++count;
+  }
+  return count;
+}
+
+// the noises sampled: both types, 2D and 3D, with and without warping
+std::vector<noise::Fractal> fractals() {
+  std::vector<noise::Fractal> result {};
+  for (const auto type: {noise::Type::Perlin, noise::Type::Simplex}) {
+    for (const auto warp: {0.f, 24.f}) {
+      noise::Fractal fractal {};
+      fractal.type = type;
+      fractal.seed = 4242;
+      fractal.octaves = 5;
+      fractal.frequency = 0.013f;
+      fractal.warp_amplitude = warp;
+      result.push_back(fractal);
+    }
+  }
+  return result;
+}
+
+// every kernel against the scalar one, on a count that isn't a multiple of
+// any register width so the scalar tail of sample() runs too
+void sameAsScalar() {
+  constexpr std::size_t count {4099};
+  std::mt19937 rng {18};
+  std::uniform_real_distribution<GLfloat> coord {-3000.f, 3000.f};
+  std::vector<GLfloat> x(count), y(count), z(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    x[i] = coord(rng);
+    y[i] = coord(rng) * 0.1f;
+    z[i] = coord(rng);
+  }
+  // and on the whole blocks the terrain uses
+  for (std::size_t i = 0; i < 64; ++i) {
+    x[i] = static_cast<GLfloat>(static_cast<GLint>(i) - 32);
+    y[i] = static_cast<GLfloat>(i % 16);
+    z[i] = static_cast<GLfloat>(static_cast<GLint>(i * 7) - 200);
+  }
+
+  for (const auto& fractal: fractals()) {
+    for (const bool three_d: {false, true}) {
+      const GLfloat* zs {three_d ? z.data() : nullptr};
+      std::vector<GLfloat> scalar(count);
+      noise::sample(fractal, x.data(), y.data(), zs, count, scalar.data(), noise::Isa::Scalar);
+      // the scalar batch is fbm() at every position
+      std::vector<GLfloat> one_by_one(count);
+      for (std::size_t i = 0; i < count; ++i) {
+        one_by_one[i] = three_d ? noise::fbm(fractal, x[i], y[i], z[i]) : noise::fbm(fractal, x[i], y[i]);
+      }
+      CHECK(differences(scalar, one_by_one) == 0);
+      for (const auto isa: isas) {
+        if (!noise::supported(isa)) continue;
+        std::vector<GLfloat> batch(count);
+        noise::sample(fractal, x.data(), y.data(), zs, count, batch.data(), isa);
+        CHECK(differences(batch, scalar) == 0);
+        // fewer than a register, all in the tail
+        std::vector<GLfloat> tail(3), tail_scalar(3);
+        noise::sample(fractal, x.data() + 5, y.data() + 5, three_d ? zs + 5 : nullptr, 3, tail.data(), isa);
+        noise::sample(fractal, x.data() + 5, y.data() + 5, three_d ? zs + 5 : nullptr, 3, tail_scalar.data(), noise::Isa::Scalar);
+        CHECK(differences(tail, tail_scalar) == 0);
+      }
+    }
+  }
+}
+
+// the chunk fillers give the same with every kernel
+void fillers() {
+  for (const auto& fractal: fractals()) {
+    noise::Column scalar_column {};
+    noise::Section scalar_section {};
+    noise::fillColumn(fractal, -37, 512, scalar_column, noise::Isa::Scalar);
+    noise::fillSection(fractal, {-48, 64, 16}, scalar_section, noise::Isa::Scalar);
+    for (const auto isa: isas) {
+      if (!noise::supported(isa)) continue;
+      noise::Column column {};
+      noise::Section section {};
+      noise::fillColumn(fractal, -37, 512, column, isa);
+      noise::fillSection(fractal, {-48, 64, 16}, section, isa);
+      CHECK(differences({column.begin(), column.end()}, {scalar_column.begin(), scalar_column.end()}) == 0);
+      CHECK(differences({section.begin(), section.end()}, {scalar_section.begin(), scalar_section.end()}) == 0);
+    }
+  }
+  // the scalar kernel is always there, and the best one too
+  CHECK(noise::supported(noise::Isa::Scalar));
+  CHECK(noise::supported(noise::best()));
+}
+
+} // namespace
+
+int main() {
+  sameAsScalar();
+  fillers();
+  return test::result();
+}
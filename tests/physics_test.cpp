@@ -0,0 +1,163 @@
+#include "check.hpp"
+#include "physics.hpp"
+#include "world.hpp"
+#include <algorithm>
+
+namespace {
+
+using namespace ktp;
+
+// as close as the bodies get to the blocks
+constexpr GLfloat tolerance {1e-3f};
+
+// a square of stone blocks at that height, from -radius to radius - 1
+void floorAt(World& world, GLint y, GLint radius) {
+  for (GLint x = -radius; x < radius; ++x) {
+    for (GLint z = -radius; z < radius; ++z) world.setBlock(x, y, z, Blocks::stone);
+  }
+}
+
+// falls, lands right on top of the floor and stays there
+void landing() {
+  World world {};
+  floorAt(world, 0, 16);
+  physics::Body body {};
+  body.position = {0.5f, 10.f, 0.5f};
+  for (int i = 0; i < 200; ++i) physics::tick(world, body, {});
+  CHECK(body.on_ground);
+  CHECK(test::near(body.position.y, 1.f, tolerance));
+  CHECK(test::near(body.velocity.y, 0.f, 0.f));
+  for (int i = 0; i < 600; ++i) physics::tick(world, body, {});
+  CHECK(body.on_ground && test::near(body.position.y, 1.f, tolerance));
+
+  // a jump goes up and comes back down on the floor
+  GLfloat top {};
+  physics::Input jump {};
+  jump.jump = true;
+  physics::tick(world, body, jump);
+  CHECK(!body.on_ground);
+  for (int i = 0; i < 120; ++i) {
+    physics::tick(world, body, {});
+    top = std::max(top, body.position.y);
+  }
+  CHECK(top > 2.2f && top < 2.7f);
+  CHECK(body.on_ground && test::near(body.position.y, 1.f, tolerance));
+
+  // a ceiling stops it
+  floorAt(world, 3, 16);
+  top = 0.f;
+  physics::tick(world, body, jump);
+  for (int i = 0; i < 60; ++i) {
+    physics::tick(world, body, {});
+    top = std::max(top, body.position.y);
+  }
+  CHECK(top <= 3.f - body.height + 1e-3f);
+}
+
+// walking into a wall at an angle, it stops against it and slides along it
+void wallSlide() {
+  World world {};
+  floorAt(world, 0, 16);
+  for (GLint y = 1; y < 5; ++y) {
+    for (GLint z = -16; z < 16; ++z) world.setBlock(5, y, z, Blocks::stone);
+  }
+  physics::Body body {};
+  body.position = {0.5f, 1.f, 0.5f};
+  body.on_ground = true;
+  physics::Input input {};
+  input.walk = {4.f, 0.f, 2.f};
+  for (int i = 0; i < 120; ++i) physics::tick(world, body, input);
+  CHECK(test::near(body.position.x, 5.f - body.half_width, tolerance));
+  CHECK(body.position.z > 3.5f);
+  CHECK(test::near(body.velocity.x, 0.f, 0.f));
+  CHECK(test::near(body.position.y, 1.f, tolerance));
+}
+
+// walks up a 1 block ledge, but not up the 2 block wall after it
+void stepUp() {
+  World world {};
+  floorAt(world, 0, 16);
+  for (GLint z = -16; z < 16; ++z) {
+    for (GLint x = 5; x < 16; ++x) world.setBlock(x, 1, z, Blocks::stone);
+    for (GLint x = 10; x < 16; ++x) {
+      world.setBlock(x, 2, z, Blocks::stone);
+      world.setBlock(x, 3, z, Blocks::stone);
+    }
+  }
+  physics::Input input {};
+  input.walk = {4.f, 0.f, 0.f};
+  physics::Body body {};
+  body.position = {0.5f, 1.f, 0.5f};
+  for (int i = 0; i < 10; ++i) physics::tick(world, body, {});
+  for (int i = 0; i < 200; ++i) physics::tick(world, body, input);
+  CHECK(test::near(body.position.y, 2.f, tolerance));
+  CHECK(test::near(body.position.x, 10.f - body.half_width, tolerance));
+
+  // not without the setting
+  const auto step_height {physics::settings.step_height};
+  physics::settings.step_height = 0.f;
+  physics::Body low {};
+  low.position = {0.5f, 1.f, 0.5f};
+  for (int i = 0; i < 200; ++i) physics::tick(world, low, input);
+  CHECK(test::near(low.position.x, 5.f - low.half_width, tolerance));
+  CHECK(test::near(low.position.y, 1.f, tolerance));
+  physics::settings.step_height = step_height;
+}
+
+// fast bodies stop at a floor 1 block thick instead of going through it
+void tunnelling() {
+  World world {};
+  floorAt(world, -100, 8);
+  // at the max fall speed, a tick moves a block
+  physics::Body body {};
+  body.position = {0.5f, 300.f, 0.5f};
+  for (int i = 0; i < 1200; ++i) physics::tick(world, body, {});
+  CHECK(test::near(body.position.y, -99.f, tolerance));
+  CHECK(body.on_ground);
+  // a single move far past it
+  physics::Body thrown {};
+  thrown.position = {0.5f, 20.f, 0.5f};
+  thrown.velocity = {0.f, -1000.f, 0.f};
+  physics::move(world, thrown, {3.f, -1000.f, -2.f});
+  CHECK(test::near(thrown.position.y, -99.f, tolerance));
+  CHECK(test::near(thrown.velocity.y, 0.f, 0.f));
+  CHECK(test::near(thrown.position.x, 3.5f, tolerance) && test::near(thrown.position.z, -1.5f, tolerance));
+  // and sideways into a wall
+  for (GLint y = -99; y < -96; ++y) {
+    for (GLint z = -8; z < 8; ++z) world.setBlock(6, y, z, Blocks::stone);
+  }
+  physics::move(world, thrown, {500.f, 0.f, 0.f});
+  CHECK(test::near(thrown.position.x, 6.f - thrown.half_width, tolerance));
+}
+
+// the player ticked by update() lands the same on the calling thread as on
+// the physics thread, with sync() in between like the frames do
+void updates() {
+  World world {};
+  floorAt(world, 0, 16);
+  for (const bool thread: {false, true}) {
+    if (thread) physics::init();
+    physics::teleport({0.5f, 5.f, 0.5f});
+    for (int frame = 0; frame < 300; ++frame) {
+      physics::sync();
+      physics::update(world, {}, 1.f / 144.f);
+    }
+    physics::sync();
+    CHECK(physics::body().on_ground);
+    CHECK(test::near(physics::body().position.y, 1.f, tolerance));
+    CHECK(physics::stats.alpha >= 0.f && physics::stats.alpha < 1.f);
+    CHECK(physics::stats.ticks <= 1);
+    physics::shutdown();
+  }
+}
+
+} // namespace
+
+int main() {
+  landing();
+  wallSlide();
+  stepUp();
+  tunnelling();
+  updates();
+  return test::result();
+}
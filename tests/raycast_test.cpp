@@ -0,0 +1,150 @@
+#include "check.hpp"
+#include "jobs.hpp"
+#include "raycast.hpp"
+#include "world.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+
+// along the 6 axes, the face the ray goes in through and how far it is
+void axisAligned() {
+  World world {};
+  world.setBlock(5, 0, 0, Blocks::stone);
+  world.setBlock(-3, 0, 0, Blocks::stone);
+  world.setBlock(0, 7, 0, Blocks::sand);
+  world.setBlock(0, -7, 0, Blocks::dirt);
+  world.setBlock(0, 0, 2, Blocks::stone);
+  world.setBlock(0, 0, -9, Blocks::stone);
+  const Point3D origin {0.5f, 0.5f, 0.5f};
+
+  const struct {
+    Vector3 direction;
+    BlockPos block;
+    GLuint face;
+    GLfloat distance;
+  } cases[] {
+    {{ 1.f,  0.f,  0.f}, { 5,  0,  0}, 0, 4.5f},
+    {{-1.f,  0.f,  0.f}, {-3,  0,  0}, 1, 2.5f},
+    {{ 0.f,  1.f,  0.f}, { 0,  7,  0}, 2, 6.5f},
+    {{ 0.f, -1.f,  0.f}, { 0, -7,  0}, 3, 6.5f},
+    {{ 0.f,  0.f,  1.f}, { 0,  0,  2}, 4, 1.5f},
+    {{ 0.f,  0.f, -1.f}, { 0,  0, -9}, 5, 8.5f},
+  };
+  for (const auto& expected: cases) {
+    const auto hit {raycast::cast(world, {origin, expected.direction, 20.f})};
+    CHECK(hit.hit);
+    CHECK(hit.block == expected.block);
+    CHECK(hit.face == expected.face);
+    CHECK(test::near(hit.distance, expected.distance));
+    CHECK(hit.id == world.getBlock(expected.block.x, expected.block.y, expected.block.z));
+    // a block placed against the face goes back towards the origin
+    CHECK(raycast::adjacent(hit) == expected.block - BlockPos{glm::sign(expected.direction)});
+  }
+  // the direction doesn't need to be normalized
+  const auto hit {raycast::cast(world, {origin, {10.f, 0.f, 0.f}, 20.f})};
+  CHECK(hit.hit && hit.block == BlockPos(5, 0, 0) && test::near(hit.distance, 4.5f));
+  // starting inside a block
+  const auto inside {raycast::cast(world, {{5.5f, 0.5f, 0.5f}, {1.f, 0.f, 0.f}, 20.f})};
+  CHECK(inside.hit && inside.face == raycast::inside && test::near(inside.distance, 0.f));
+  // no direction, no hit
+  CHECK(!raycast::cast(world, {origin, {0.f, 0.f, 0.f}, 20.f}).hit);
+}
+
+// rays from negative coordinates, across the borders of the chunks
+void chunkBorders() {
+  World world {};
+  world.setBlock(-20, -20, -20, Blocks::stone);
+  world.setBlock(17, -40, -1, Blocks::stone);
+  // diagonal, through 2 chunks on every axis
+  auto hit {raycast::cast(world, {{0.5f, 0.5f, 0.5f}, {-1.f, -1.f, -1.f}, 100.f})};
+  CHECK(hit.hit && hit.block == BlockPos(-20, -20, -20));
+  CHECK(test::near(hit.distance, 19.5f * std::sqrt(3.f)));
+  // along x from -33.5, the chunks -3 to 1 of the row, most of them not loaded
+  hit = raycast::cast(world, {{-33.5f, -39.5f, -0.5f}, {1.f, 0.f, 0.f}, 100.f});
+  CHECK(hit.hit && hit.block == BlockPos(17, -40, -1) && hit.face == 0);
+  CHECK(test::near(hit.distance, 50.5f));
+  // along z from the chunk behind, a row below misses it
+  hit = raycast::cast(world, {{17.5f, -40.5f, -16.5f}, {0.f, 0.f, 1.f}, 100.f});
+  CHECK(!hit.hit);
+  hit = raycast::cast(world, {{17.5f, -39.5f, -16.5f}, {0.f, 0.f, 1.f}, 100.f});
+  CHECK(hit.hit && hit.block == BlockPos(17, -40, -1) && hit.face == 4);
+  CHECK(test::near(hit.distance, 15.5f));
+}
+
+// the ray stops at max_distance, and water is seen through
+void misses() {
+  World world {};
+  world.setBlock(5, 0, 0, Blocks::stone);
+  const Point3D origin {0.5f, 0.5f, 0.5f};
+  CHECK(!raycast::cast(world, {origin, {1.f, 0.f, 0.f}, 4.f}).hit);
+  CHECK(!raycast::cast(world, {origin, {1.f, 0.f, 0.f}, 4.49f}).hit);
+  CHECK(raycast::cast(world, {origin, {1.f, 0.f, 0.f}, 4.51f}).hit);
+  CHECK(!raycast::cast(world, {origin, {-1.f, 0.f, 0.f}, 1000.f}).hit);
+  CHECK(!raycast::lineOfSight(world, origin, {9.5f, 0.5f, 0.5f}));
+  CHECK(raycast::lineOfSight(world, origin, {4.4f, 0.5f, 0.5f}));
+
+  World water {};
+  water.setBlock(2, 0, 0, Blocks::water);
+  water.setBlock(4, 0, 0, Blocks::sand);
+  const auto hit {raycast::cast(water, {origin, {1.f, 0.f, 0.f}, 20.f})};
+  CHECK(hit.hit && hit.block == BlockPos(4, 0, 0));
+}
+
+// random rays through scattered blocks, against small steps along them, and
+// the batched ones against the single ones
+void randomRays() {
+  std::mt19937 rng {7};
+  std::uniform_real_distribution<GLfloat> unit {-1.f, 1.f};
+  World world {};
+  for (int i = 0; i < 3000; ++i) {
+    const auto x {static_cast<GLint>(rng() % 64) - 32};
+    const auto y {static_cast<GLint>(rng() % 64) - 32};
+    const auto z {static_cast<GLint>(rng() % 64) - 32};
+    world.setBlock(x, y, z, Blocks::stone);
+  }
+  std::vector<raycast::Ray> rays {};
+  while (rays.size() < 300) {
+    const Point3D origin {unit(rng) * 20.f, unit(rng) * 20.f, unit(rng) * 20.f};
+    const Vector3 direction {unit(rng), unit(rng), unit(rng)};
+    const BlockPos start {glm::floor(origin)};
+    if (glm::length(direction) < 0.1f || world.getBlock(start.x, start.y, start.z) != Blocks::air) continue;
+    rays.push_back({origin, glm::normalize(direction), 40.f});
+  }
+  std::vector<raycast::Hit> hits {};
+  raycast::cast(world, rays, hits);
+  CHECK(hits.size() == rays.size());
+  for (std::size_t i = 0; i < rays.size(); ++i) {
+    const auto& ray {rays[i]};
+    const auto hit {raycast::cast(world, ray)};
+    CHECK(hit.hit == hits[i].hit && hit.block == hits[i].block && test::near(hit.distance, hits[i].distance));
+    // steps of 1/1000 of a block, close enough to tell the block apart
+    bool found {false};
+    GLfloat t {};
+    BlockPos block {};
+    for (; t <= ray.max_distance; t += 0.001f) {
+      block = BlockPos{glm::floor(ray.origin + ray.direction * t)};
+      if (world.getBlock(block.x, block.y, block.z) != Blocks::air) {
+        found = true;
+        break;
+      }
+    }
+    CHECK(hit.hit == found);
+    if (found) CHECK(hit.block == block && std::abs(hit.distance - t) < 0.01f);
+  }
+}
+
+} // namespace
+
+int main() {
+  jobs::init(3);
+  axisAligned();
+  chunkBorders();
+  misses();
+  randomRays();
+  jobs::shutdown();
+  return test::result();
+}
@@ -0,0 +1,157 @@
+#include "check.hpp"
+#include "region.hpp"
+#include "terrain.hpp"
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace ktp;
+namespace fs = std::filesystem;
+
+bool same(const Chunk& a, const Chunk& b) {
+  for (GLuint i = 0; i < Chunk::volume; ++i) {
+    if (a.get(i) != b.get(i)) return false;
+  }
+  return true;
+}
+
+// empty, uniform, noisy enough to be stored raw and generated chunks, some
+// in other regions and at negative coordinates
+std::vector<std::pair<ChunkPos, Chunk>> sampleChunks() {
+  std::vector<std::pair<ChunkPos, Chunk>> chunks {};
+  chunks.push_back({{0, 0, 0}, Chunk{}});
+  Chunk full {};
+  full.fill(Blocks::stone);
+  chunks.push_back({{1, 0, 0}, full});
+  Chunk noisy {};
+  std::mt19937 rng {20};
+  for (GLuint i = 0; i < Chunk::volume; ++i) noisy.set(i, static_cast<BlockID>(rng() % 1000));
+  chunks.push_back({{31, 2, 31}, noisy});
+  const terrain::Generator generator {1234};
+  for (const ChunkPos pos: {ChunkPos{2, 3, 0}, ChunkPos{-1, 2, -1}, ChunkPos{-33, 3, 40}, ChunkPos{32, 0, 0}, ChunkPos{5, 3, 7}}) {
+    Chunk chunk {};
+    generator.generate(pos, chunk);
+    chunks.push_back({pos, chunk});
+  }
+  return chunks;
+}
+
+bool allLoad(region::Storage& storage, const std::vector<std::pair<ChunkPos, Chunk>>& chunks) {
+  bool ok {true};
+  for (const auto& [pos, chunk]: chunks) {
+    Chunk loaded {};
+    ok &= storage.load(pos, loaded) && same(loaded, chunk);
+  }
+  return ok;
+}
+
+void roundTripAndReopen(const fs::path& directory) {
+  auto chunks {sampleChunks()};
+  {
+    region::Storage storage {directory};
+    for (const auto& [pos, chunk]: chunks) storage.save(pos, chunk);
+    // found while still waiting for the I/O thread
+    CHECK(allLoad(storage, chunks));
+    storage.flush();
+    CHECK(storage.stats().pending == 0);
+    CHECK(storage.stats().saved == chunks.size());
+    CHECK(allLoad(storage, chunks));
+    Chunk missing {};
+    CHECK(!storage.load({3, 3, 3}, missing));
+  }
+  // a chunk per region layer at most, plus the regions of the far ones
+  CHECK(fs::exists(directory / "r.0.0.0.ktr"));
+  CHECK(fs::exists(directory / "r.-2.3.1.ktr"));
+
+  {
+    region::Storage storage {directory};
+    CHECK(allLoad(storage, chunks));
+    // grows out of its sectors, then shrinks back into them
+    chunks[1].second = chunks[2].second;
+    storage.save(chunks[1].first, chunks[1].second);
+    storage.flush();
+    chunks[2].second = Chunk{};
+    storage.save(chunks[2].first, chunks[2].second);
+  }
+  region::Storage storage {directory};
+  CHECK(allLoad(storage, chunks));
+}
+
+// many threads load while another one keeps saving to the same regions
+void concurrentReads(const fs::path& directory) {
+  const auto chunks {sampleChunks()};
+  region::Storage storage {directory};
+  for (const auto& [pos, chunk]: chunks) storage.save(pos, chunk);
+  storage.flush();
+
+  std::vector<std::thread> readers {};
+  std::vector<int> failures(4, 0);
+  for (std::size_t t = 0; t < failures.size(); ++t) {
+    readers.emplace_back([&storage, &chunks, &failure = failures[t]] {
+      for (int round = 0; round < 50; ++round) {
+        if (!allLoad(storage, chunks)) ++failure;
+      }
+    });
+  }
+  Chunk other {};
+  other.fill(Blocks::dirt);
+  for (GLint i = 0; i < 200; ++i) {
+    other.set(static_cast<GLuint>(i), Blocks::sand);
+    storage.save({i % 30, 0, 1 + i % 29}, other);
+    if (i % 20 == 0) storage.flush();
+  }
+  for (auto& reader: readers) reader.join();
+  for (const auto failure: failures) CHECK(failure == 0);
+  storage.flush();
+  Chunk loaded {};
+  CHECK(storage.load({199 % 30, 0, 1 + 199 % 29}, loaded) && same(loaded, other));
+}
+
+void truncated(const fs::path& directory) {
+  const auto path {directory / "truncated.ktr"};
+  const std::vector<std::uint8_t> first(1000, 7u), second(3000, 9u);
+  {
+    region::RegionFile file {path};
+    CHECK(file.valid());
+    CHECK(file.write(0, first));
+    CHECK(file.write(1, second));
+  }
+  // the last payload loses its end
+  fs::resize_file(path, fs::file_size(path) - 1000);
+  {
+    region::RegionFile file {path};
+    CHECK(file.valid());
+    std::vector<std::uint8_t> payload {};
+    CHECK(file.read(0, payload) && payload == first);
+    CHECK(!file.read(1, payload));
+    // and can be written again
+    CHECK(file.write(1, second));
+    CHECK(file.read(1, payload) && payload == second);
+  }
+  // shorter than the table, it starts over empty
+  fs::resize_file(path, 100);
+  region::RegionFile file {path};
+  CHECK(file.valid());
+  std::vector<std::uint8_t> payload {};
+  CHECK(!file.read(0, payload));
+  CHECK(!file.read(1, payload));
+  // a payload too big for the 8 bit sector count is refused
+  CHECK(!file.write(2, std::vector<std::uint8_t>(256 * region::sector_size, 1u)));
+}
+
+} // namespace
+
+int main() {
+  const auto directory {fs::temp_directory_path() / "ketemine_region_test"};
+  fs::remove_all(directory);
+  roundTripAndReopen(directory / "round_trip");
+  concurrentReads(directory / "concurrent");
+  fs::create_directories(directory);
+  truncated(directory);
+  fs::remove_all(directory);
+  return test::result();
+}
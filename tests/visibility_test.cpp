@@ -0,0 +1,161 @@
+#include "check.hpp"
+#include "mesher.hpp"
+#include "visibility.hpp"
+
+namespace {
+
+using namespace ktp;
+using visibility::Connectivity;
+using enum mesher::Face;
+
+// stone everywhere but the boxes carved into it
+Chunk solid() {
+  Chunk chunk {};
+  chunk.fill(Blocks::stone);
+  return chunk;
+}
+
+void carve(Chunk& chunk, GLint x0, GLint y0, GLint z0, GLint x1, GLint y1, GLint z1) {
+  for (GLint y = y0; y <= y1; ++y) {
+    for (GLint z = z0; z <= z1; ++z) {
+      for (GLint x = x0; x <= x1; ++x) chunk.set(x, y, z, Blocks::air);
+    }
+  }
+}
+
+// only the listed pairs of faces are connected
+bool onlyConnects(const Connectivity& connectivity, std::initializer_list<std::pair<GLuint, GLuint>> pairs) {
+  for (GLuint a = 0; a < 6; ++a) {
+    for (GLuint b = a + 1; b < 6; ++b) {
+      bool expected {false};
+      for (const auto& [first, second]: pairs) expected |= (first == a && second == b) || (first == b && second == a);
+      if (connectivity.connected(a, b) != expected || connectivity.connected(b, a) != expected) return false;
+    }
+  }
+  return connectivity.pairs() == pairs.size();
+}
+
+void connectivity() {
+  Chunk chunk {};
+  CHECK(Connectivity::compute(chunk).pairs() == 15);
+  CHECK(Connectivity::compute(chunk).connected(NegativeY, PositiveY));
+  CHECK(onlyConnects(Connectivity::compute(solid()), {}));
+
+  // a straight tunnel along x
+  chunk = solid();
+  carve(chunk, 0, 8, 8, 15, 8, 8);
+  CHECK(onlyConnects(Connectivity::compute(chunk), {{NegativeX, PositiveX}}));
+  // blocked in the middle, each half only touches its own face
+  chunk.set(7, 8, 8, Blocks::stone);
+  CHECK(onlyConnects(Connectivity::compute(chunk), {}));
+
+  // a bend from -x up to +y
+  chunk = solid();
+  carve(chunk, 0, 4, 4, 4, 4, 4);
+  carve(chunk, 4, 4, 4, 4, 15, 4);
+  CHECK(onlyConnects(Connectivity::compute(chunk), {{NegativeX, PositiveY}}));
+
+  // two tunnels crossing at different heights don't connect
+  chunk = solid();
+  carve(chunk, 0, 2, 8, 15, 2, 8);
+  carve(chunk, 8, 12, 0, 8, 12, 15);
+  CHECK(onlyConnects(Connectivity::compute(chunk), {{NegativeX, PositiveX}, {NegativeZ, PositiveZ}}));
+
+  // a cave touching no face connects nothing
+  chunk = solid();
+  carve(chunk, 4, 4, 4, 11, 11, 11);
+  CHECK(onlyConnects(Connectivity::compute(chunk), {}));
+
+  // a floor splits the air in two, the sides connect above and below it,
+  // but not the bottom and the top
+  chunk = {};
+  carve(chunk, 0, 0, 0, 15, 15, 15);
+  for (GLint z = 0; z < Chunk::size; ++z) {
+    for (GLint x = 0; x < Chunk::size; ++x) chunk.set(x, 8, z, Blocks::stone);
+  }
+  const auto floor {Connectivity::compute(chunk)};
+  CHECK(!floor.connected(NegativeY, PositiveY));
+  CHECK(floor.connected(NegativeX, PositiveZ));
+  CHECK(floor.connected(NegativeY, PositiveX));
+  CHECK(floor.connected(PositiveY, NegativeZ));
+  CHECK(floor.pairs() == 14);
+
+  // the padded copy gives the same, whatever the neighbours hold
+  PaddedChunk padded {};
+  padded.blocks.fill(Blocks::stone);
+  for (GLint y = 0; y < Chunk::size; ++y) {
+    for (GLint z = 0; z < Chunk::size; ++z) {
+      for (GLint x = 0; x < Chunk::size; ++x) padded.blocks[PaddedChunk::index(x, y, z)] = chunk.get(x, y, z);
+    }
+  }
+  const auto from_padded {Connectivity::compute(padded)};
+  for (GLuint a = 0; a < 6; ++a) {
+    for (GLuint b = 0; b < 6; ++b) CHECK(from_padded.connected(a, b) == floor.connected(a, b));
+  }
+}
+
+void search() {
+  const auto open {Connectivity::open()};
+  const auto closed {Connectivity::compute(solid())};
+  visibility::Graph graph {};
+  std::unordered_set<ChunkPos, ChunkPosHash> reachable {};
+
+  // a row of open chunks is all visible
+  for (GLint x = 0; x < 4; ++x) graph.set({x, 0, 0}, open);
+  graph.search({0, 0, 0}, reachable);
+  CHECK(reachable.size() == 4);
+
+  // a solid chunk is seen, what's behind it isn't
+  graph.set({2, 0, 0}, closed);
+  graph.search({0, 0, 0}, reachable);
+  CHECK(reachable.count({1, 0, 0}) && reachable.count({2, 0, 0}));
+  CHECK(!reachable.count({3, 0, 0}));
+  CHECK(reachable.size() == 3);
+
+  // the search never turns back: (0, 2, 0) is only reachable going +x,
+  // up and then -x, around the solid chunk above the start
+  graph = {};
+  graph.set({0, 0, 0}, open);
+  graph.set({0, 1, 0}, closed);
+  graph.set({1, 0, 0}, open);
+  graph.set({1, 1, 0}, open);
+  graph.set({1, 2, 0}, open);
+  graph.set({0, 2, 0}, open);
+  graph.search({0, 0, 0}, reachable);
+  CHECK(reachable.count({1, 2, 0}));
+  CHECK(reachable.count({0, 1, 0}));
+  CHECK(!reachable.count({0, 2, 0}));
+  // updated in place when the chunk opens up
+  graph.set({0, 1, 0}, open);
+  graph.search({0, 0, 0}, reachable);
+  CHECK(reachable.count({0, 2, 0}));
+  CHECK(reachable.size() == graph.size());
+
+  // a chunk is crossed only between connected faces: a tunnel along x lets
+  // the search through along x but not up
+  Chunk chunk {solid()};
+  carve(chunk, 0, 8, 8, 15, 8, 8);
+  graph = {};
+  graph.set({0, 0, 0}, open);
+  graph.set({1, 0, 0}, Connectivity::compute(chunk));
+  graph.set({2, 0, 0}, open);
+  graph.set({1, 1, 0}, open);
+  graph.set({2, 1, 0}, open);
+  graph.search({0, 0, 0}, reachable);
+  CHECK(reachable.count({2, 0, 0}));
+  CHECK(reachable.count({2, 1, 0}));
+  // up from the tunnel is only reachable through (2, 1, 0), which would need going back -x
+  CHECK(!reachable.count({1, 1, 0}));
+
+  // chunks out of the graph are never reported
+  graph.search({0, 0, 0}, reachable);
+  CHECK(!reachable.count({-1, 0, 0}));
+}
+
+} // namespace
+
+int main() {
+  connectivity();
+  search();
+  return test::result();
+}